@@ -1,10 +1,17 @@
 #ifndef GMIF_INCLUDE_GMIF_GMIF_H_
 #define GMIF_INCLUDE_GMIF_GMIF_H_
 
+#include <geos/geom/Coordinate.h>
+#include <geos/geom/Envelope.h>
 #include <geos/geom/Geometry.h>
-#include <bitset>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
 #include <map>
 #include <memory>
+#include <string>
 #include <vector>
 //#include <variant>  // C++17 need
 
@@ -15,47 +22,104 @@
 
 namespace gmif {
 
-//! 复合属性值类型
+//! 复合属性值类型: 整数、浮点数或字符串, 短字符串内联存储, 读取接口无副作用可并发调用
 class AttrValue {
  public:
+  //! 值类型
+  enum class Kind : uint8_t { kNull, kInt, kDouble, kStr };
+
+  //! 内联存储的字符串最大长度, 更长的字符串存放于堆上或共享存储
+  static const size_t kInlineCapacity = 24;
+
   AttrValue();
   AttrValue(const std::string& v);
   AttrValue(const char* v);
   AttrValue(int32_t v);
+  AttrValue(int64_t v);
   AttrValue(double v);
-  AttrValue(const AttrValue& rhs) = default;
+  AttrValue(const AttrValue& rhs);
   AttrValue(AttrValue&& rhs) noexcept;
-  ~AttrValue() = default;
+  ~AttrValue();
 
-  AttrValue& operator=(const AttrValue& rhs) = default;
+  AttrValue& operator=(const AttrValue& rhs);
   AttrValue& operator=(AttrValue&& rhs) noexcept;
   AttrValue& operator=(const std::string& v);
   AttrValue& operator=(const char* v);
   AttrValue& operator=(int32_t v);
+  AttrValue& operator=(int64_t v);
   AttrValue& operator=(double v);
 
-  //! 比较运算符要求init_flag_一致
+  //! 比较运算符要求值类型一致(整数与浮点数视为一致), 不一致时相等比较返回true, 大小比较返回false
   bool operator==(const AttrValue& rhs) const;
   bool operator<(const AttrValue& rhs) const;
   bool operator>(const AttrValue& rhs) const;
 
   //! 判断实际值相等
-  bool ValueEqual(AttrValue& rhs);
+  bool ValueEqual(const AttrValue& rhs) const;
+
+  Kind getKind() const { return kind_; }
+
+  //! 字符串值, 数值按GMIF_DOUBLE_PRECISION位定点小数格式化
+  std::string getStr() const;
+  //! 整数值, 浮点数截断取整, 字符串按十进制解析
+  int32_t getInt() const;
+  int64_t getInt64() const;
+  //! 浮点数值, 字符串按十进制解析
+  double getDouble() const;
+
+  //! 字符串值的数据地址与长度, 仅Kind::kStr有效, 不以'\0'结尾
+  const char* getStrData() const {
+    return storage_ == kHeap ? heap_.data : (storage_ == kShared ? shared_->data() : inline_);
+  }
+  size_t getStrSize() const {
+    return storage_ == kHeap ? heap_.size : (storage_ == kShared ? shared_->size() : inline_size_);
+  }
+
+  //! 设置字符串值, 复用已有的字符串容量
+  void setStr(const char* v, size_t len);
+
+  //! 设置共享字符串值(不可为空), 与其他属性值共享同一存储, 相同存储的相等比较无需比较内容
+  void setStr(const std::shared_ptr<const std::string>& v);
 
-  const std::string& getStr();
-  int32_t getInt();
-  double getDouble();
+  //! 是否为共享字符串
+  bool isSharedStr() const { return storage_ == kShared; }
 
  private:
-  //  std::variant<int32_t, double, std::string> val_;  // C++17 need
-  std::string str_val_;
-  double num_val_;
-  std::bitset<2> init_flag_;
+  //! 字符串存储方式
+  enum Storage : uint8_t { kInline, kHeap, kShared };
+
+  //! 超出内联容量的字符串
+  struct HeapStr {
+    char* data;
+    size_t size;
+    size_t capacity;
+  };
+
+  //! 释放字符串存储, 之后为空的内联字符串
+  void release();
+  //! 复制数值或非共享字符串之外的存储区
+  void copyNumber(const AttrValue& rhs);
+  //! 从rhs转移存储, rhs置空
+  void moveFrom(AttrValue& rhs) noexcept;
+
+  union {
+    int64_t int_val_;
+    double dbl_val_;
+    HeapStr heap_;
+    std::shared_ptr<const std::string> shared_;
+    char inline_[kInlineCapacity];
+  };
+  Kind kind_;
+  Storage storage_;      // 字符串存储方式
+  uint8_t inline_size_;  // 内联字符串长度
 };
 
 //! 属性集合
 typedef std::map<std::string, AttrValue> AttrMap;
 
+//! 列式属性表, 定义于库内部
+class AttrTable;
+
 //! 几何对象
 typedef geos::geom::Geometry Geometry;
 typedef std::shared_ptr<Geometry> GeometryPtr;
@@ -172,24 +236,159 @@ class MifHeader {
   std::map<std::string, int32_t> col_index_;  // 字段下标索引(转为全小写)
 };
 
+//! 扁平几何坐标区: 一批几何对象的坐标连续存放(x, y交替), 以偏移数组划分几何对象、部件与环,
+//! 按需转换为GEOS几何对象. 部件为多线/多面中的每条线/每个面, 其余几何为1个部件;
+//! 环为面的外环与内环, 其余部件为1个环. 追加完成后只读, 可多线程并发读取与转换
+class GeoArena {
+ public:
+  GeoArena();
+
+  //! 几何对象数
+  size_t size() const { return types_.size(); }
+
+  //! 第i个几何对象的类型(geos::geom::GeometryTypeId), 无几何对象时为-1
+  int getType(size_t i) const { return types_[i]; }
+
+  //! 各几何对象的类型
+  const std::vector<int32_t>& getTypes() const { return types_; }
+  //! 各几何对象的首个部件, 大小为几何对象数 + 1
+  const std::vector<uint64_t>& getElemParts() const { return elem_parts_; }
+  //! 各部件的首个环, 大小为部件数 + 1
+  const std::vector<uint64_t>& getPartRings() const { return part_rings_; }
+  //! 各环的首个坐标, 大小为环数 + 1
+  const std::vector<uint64_t>& getRingCoords() const { return ring_coords_; }
+  //! 坐标, x, y交替
+  const std::vector<double>& getCoords() const { return coords_; }
+
+  /**
+   * @brief 追加GEOS几何对象的坐标
+   * @param geo 几何对象, 为nullptr时追加无几何对象的项
+   * @return 成功返回true, 不支持的几何类型(点集、几何集合)或坐标数不合法(空几何、线少于2点、
+   * 环少于4点)时返回false且不修改坐标区
+   */
+  bool append(const Geometry* geo);
+
+  /**
+   * @brief 追加另一坐标区中的第i个几何对象
+   */
+  void append(const GeoArena& other, size_t i);
+
+  //! 追加另一坐标区的全部几何对象
+  void append(const GeoArena& other);
+
+  /**
+   * @brief 逐环追加几何对象: beginGeometry后对每个部件依次addRing并endPart, 最后endGeometry
+   * @param geo_type 几何类型, -1表示无几何对象
+   */
+  void beginGeometry(int geo_type);
+  void addRing(const std::vector<geos::geom::Coordinate>& pts);
+  void addRing(const geos::geom::CoordinateSequence& seq);
+  void endPart();
+  void endGeometry();
+
+  /**
+   * @brief 以整体数组设置坐标区, 用于从外部存储恢复
+   * @return 偏移数组或各几何对象的部件、环、坐标数与类型不符时返回false, 坐标区不变
+   */
+  bool assign(std::vector<int32_t>&& types,
+              std::vector<uint64_t>&& elem_parts,
+              std::vector<uint64_t>&& part_rings,
+              std::vector<uint64_t>&& ring_coords,
+              std::vector<double>&& coords);
+
+  /**
+   * @brief 计算第i个几何对象的外包框, 无几何对象时为空范围
+   */
+  void getEnvelope(size_t i, geos::geom::Envelope& env) const;
+
+  /**
+   * @brief 将第i个几何对象转换为GEOS几何对象, 坐标原样使用, 不做闭环与方向修正
+   * @param i 编号
+   * @param res 返回的几何对象指针, 无几何对象时为nullptr
+   * @param geos_factory GEOS工厂, 为nullptr时每次转换使用独立的工厂,
+   * 避免不同线程构造或析构的几何对象共享工厂的非线程安全引用计数
+   * @return 成功返回0, 部件、环或坐标数与几何类型不符时返回-1
+   */
+  int toGeometry(size_t i,
+                 GeometryPtr& res,
+                 const geos::geom::GeometryFactory* geos_factory = nullptr) const;
+
+  //! 追加结束后释放多余容量
+  void shrink();
+
+ private:
+  //! 第i个几何对象的部件、环与坐标数是否与类型相符
+  bool checkGeometry(size_t i) const;
+
+  std::vector<int32_t> types_;
+  std::vector<uint64_t> elem_parts_;
+  std::vector<uint64_t> part_rings_;
+  std::vector<uint64_t> ring_coords_;
+  std::vector<double> coords_;
+};
+
 //! MIF元素结构
 class MifElement {
  public:
-  MifElement() : geo_(nullptr) {}
+  MifElement()
+      : geo_(nullptr), geo_index_(0), geo_pending_(false), attr_row_(0), attrs_cached_(false) {}
+  MifElement(const MifElement& rhs);
+  MifElement& operator=(const MifElement& rhs);
+  ~MifElement();
+
+  /**
+   * @brief 获取几何对象, 延迟构造的几何对象在首次访问时构造, 可多线程并发调用
+   * @note 延迟构造失败时返回nullptr
+   */
+  const GeometryPtr& getGeo() const;
+  void setGeo(const GeometryPtr& geo);
+
+  /**
+   * @brief 关联坐标区中的几何对象, 首次访问时才构造, 清空已有几何对象
+   * @param arena 坐标区
+   * @param index 在坐标区中的编号
+   */
+  void setLazyGeo(const std::shared_ptr<const GeoArena>& arena, size_t index);
+
+  //! 是否关联了尚未构造的几何对象
+  bool isGeoPending() const { return geo_pending_.load(std::memory_order_acquire); }
 
-  const GeometryPtr& getGeo() const { return geo_; }
-  void setGeo(const GeometryPtr& geo) { geo_ = geo; }
+  /**
+   * @brief 获取尚未构造的几何对象所在的坐标区, 可多线程并发调用
+   * @param arena 返回的坐标区
+   * @param index 返回在坐标区中的编号
+   * @return 几何对象尚未构造时返回true, 已构造或未关联坐标区时返回false
+   */
+  bool getLazyGeo(std::shared_ptr<const GeoArena>& arena, size_t& index) const;
 
-  const AttrMap& getAttrsMap() const { return attrs_map_; }
-  void setAttrsMap(const AttrMap& attrs_map) { attrs_map_ = attrs_map; }
-  void setAttrsMap(AttrMap&& attrs_map) { attrs_map_ = std::move(attrs_map); }
+  /**
+   * @brief 获取属性集合, 可多线程并发调用; 关联列式属性表时首次调用将本行解码为AttrMap缓存在元素中,
+   * 不解除关联. 只读取个别字段时宜使用getAttr(name, val)或const getAttr, 二者不解码整行
+   */
+  const AttrMap& getAttrsMap() const;
+  //! 获取可修改的属性集合, 关联列式属性表时将本行物化为AttrMap并解除关联
+  AttrMap& mutableAttrsMap();
+  void setAttrsMap(const AttrMap& attrs_map);
+  void setAttrsMap(AttrMap&& attrs_map);
+
+  /**
+   * @brief 关联列式属性表中的一行, 清空已有属性
+   * @param table 属性表
+   * @param row 行下标
+   */
+  void setAttrRow(const std::shared_ptr<const AttrTable>& table, size_t row);
+
+  //! 关联的列式属性表, 未关联或已物化时为nullptr
+  const std::shared_ptr<const AttrTable>& getAttrTable() const { return attr_table_; }
+  //! 关联的属性表行下标
+  size_t getAttrRow() const { return attr_row_; }
 
   /**
    * @brief 是否包含字段
    * @param col_lower_name 字段小写名称
    * @return 包含返回true, 不包含返回false
    */
-  bool hasColumn(const std::string& col_lower_name) noexcept;
+  bool hasColumn(const std::string& col_lower_name) const noexcept;
 
   /**
    * @brief 获取属性值
@@ -197,15 +396,23 @@ class MifElement {
    * @param res_val 若成功返回的属性值
    * @return 成功返回true, 失败返回false
    */
-  bool getAttr(const std::string& col_lower_name, AttrValue& res_val) noexcept;
+  bool getAttr(const std::string& col_lower_name, AttrValue& res_val) const noexcept;
 
   /**
-   * @brief 获取属性值, 失败抛出异常
+   * @brief 获取属性值, 失败抛出异常; 关联列式属性表时将本行物化为AttrMap并解除关联
    * @param col_lower_name 字段小写名称
-   * @return 成功返回属性值
+   * @return 成功返回属性值的引用
    */
   AttrValue& getAttr(const std::string& col_lower_name);
 
+  /**
+   * @brief 获取属性值, 失败抛出异常, 可多线程并发调用; 关联列式属性表时只读取对应单元格,
+   * 不解码整行也不解除关联
+   * @param col_lower_name 字段小写名称
+   * @return 成功返回属性值
+   */
+  AttrValue getAttr(const std::string& col_lower_name) const;
+
   /**
    * @brief 新增或更新属性值
    * @param col_lower_name 字段小写名称
@@ -214,10 +421,228 @@ class MifElement {
   void addOrUpdateAttr(const std::string& col_lower_name, const AttrValue& val) noexcept;
 
  private:
-  GeometryPtr geo_;
-  AttrMap attrs_map_;
+  //! 将关联的属性表行物化到attrs_map_并解除关联
+  void materialize();
+  //! 将关联的属性表行解码到attrs_map_缓存, 不解除关联
+  void cacheAttrs() const;
+  //! 从属性表登记的解码缓存内存中扣除本行的缓存, 需在清除attrs_cached_前调用
+  void releaseAttrsCache();
+  //! 解码关联的属性表行
+  void decodeAttrRow(AttrMap& res) const;
+  //! 构造延迟的几何对象
+  void materializeGeo() const;
+
+  mutable GeometryPtr geo_;
+  mutable std::shared_ptr<const GeoArena> geo_arena_;
+  size_t geo_index_;
+  mutable std::atomic<bool> geo_pending_;
+  mutable AttrMap attrs_map_;  // 关联属性表时为attrs_cached_标记的解码缓存
+  std::shared_ptr<const AttrTable> attr_table_;
+  size_t attr_row_;
+  mutable std::atomic<bool> attrs_cached_;
+};
+
+//! 加载选项
+struct LoadOptions {
+  LoadOptions()
+      : mid_only(false),
+        use_mmap(true),
+        num_threads(1),
+        columnar_attrs(false),
+        intern_strings(false),
+        lazy_geo(false),
+        columns(),
+        filter(),
+        predicate(),
+        bbox() {}
+
+  //! 是否只加载MID信息
+  bool mid_only;
+  //! 是否以内存映射方式读取文件, 映射失败时自动回退为分块读取
+  bool use_mmap;
+  //! Mif::Load解析线程数, 0表示使用硬件并发数, 大于1时需要文件可内存映射, 否则回退为单线程
+  size_t num_threads;
+  //! Mif::Load是否以列式属性表存储属性, 元素仅保存行下标, 可变访问属性时按需物化为AttrMap
+  bool columnar_attrs;
+  //! 是否驻留字符串属性: 同列相同取值共享存储, 相等比较可直接比较存储; 高基数列自动停止驻留
+  bool intern_strings;
+  //! 是否延迟构造几何对象: 加载时只将坐标(已做闭环与方向修正)写入图层的坐标区Mif::arena(),
+  //! 首次调用getGeo时才构造GEOS几何对象; 保存与空间索引直接读取坐标区, 不触发构造
+  bool lazy_geo;
+  //! 仅加载的列名(不区分大小写), 为空表示全部列; 未选中的列不做类型转换也不存储,
+  //! 但仍校验每行字段数与表头一致. 列名不存在时加载失败
+  std::vector<std::string> columns;
+  //! 属性过滤表达式, 如"kind in (1, 2) and length > 100", 可引用未投影的列, 为空表示不过滤;
+  //! 直接在切分出的字段上求值, 未通过的行不做类型转换, 其几何对象只被扫描跳过
+  std::string filter;
+  //! 属性过滤函数, 在过滤表达式之后对解码后的属性求值, 返回false的行被跳过;
+  //! 多线程加载时会被并发调用
+  std::function<bool(const AttrMap&)> predicate;
+  //! 查询范围, 仅保留几何外包框与其相交的元素, 无几何的元素被跳过; 默认为空范围, 表示不做范围过滤.
+  //! 在解析坐标时计算外包框, 范围外的元素不构造GEOS几何对象, 其MID行不做切分;
+  //! 仅加载MID时仍需扫描MIF
+  geos::geom::Envelope bbox;
+};
+
+//! 批量加载选项
+struct BatchLoadOptions {
+  BatchLoadOptions() : num_threads(0), load() {}
+
+  //! 工作线程数即同时加载的图层数上限, 0表示使用硬件并发数; 图层按列表顺序动态分配给线程
+  size_t num_threads;
+  //! 各图层的加载选项; load.num_threads为单个图层的解析线程数, 总线程数为二者之积,
+  //! 图层数不少于工作线程数时宜保持为1
+  LoadOptions load;
+};
+
+//! 文件压缩格式, 压缩文件名为原文件名加".gz"/".zst"后缀; 需在构建时启用对应的库
+enum class Compression { kNone, kGzip, kZstd };
+
+//! 保存选项
+struct DumpOptions {
+  DumpOptions()
+      : compat_format(true),
+        buffer_size(1 << 20),
+        num_threads(1),
+        async_write(false),
+        queue_depth(2),
+        drop_cache(false),
+        compression(Compression::kNone),
+        compression_level(0) {}
+
+  //! 是否按兼容格式写出数值: 开启时浮点数保留固定小数位, 与此前版本逐字节一致;
+  //! 关闭时去除小数末尾的0, 文件更小, 重新加载后数值不变
+  bool compat_format;
+  //! MIF与MID文件各自的写出缓冲区大小(字节), 小于4KB时按4KB处理
+  size_t buffer_size;
+  //! Mif::Dump格式化线程数, 0表示使用硬件并发数; 大于1时各线程将连续的元素段格式化到内存,
+  //! 由调用线程按原顺序写入文件, 输出与单线程逐字节一致
+  size_t num_threads;
+  //! 是否后台写出: MIF与MID各由一个I/O线程写入文件, 格式化与磁盘写入重叠进行, 适用于较慢的存储
+  bool async_write;
+  //! 后台写出时每个文件等待及正在写出的缓冲区数上限, 达到上限时格式化线程等待, 小于1时按1处理
+  size_t queue_depth;
+  //! 是否在写出后提示内核丢弃已写出数据的页缓存(posix_fadvise), 避免大批量导出挤占页缓存
+  bool drop_cache;
+  //! 输出压缩格式, 压缩时写出out_layer_path.mif.gz/.mid.gz(或.zst), 压缩数据在关闭文件时写完;
+  //! 加载时未找到未压缩文件会自动查找并流式解压压缩文件
+  Compression compression;
+  //! 压缩级别, 0表示使用压缩库的默认级别
+  int compression_level;
+};
+
+//! 元素空间索引: 按STR方式批量打包的R树, 构建后只读, 可多线程并发查询.
+//! 索引保存元素下标与元素指针, 元素列表或几何对象修改后需重新构建
+class SpatialIndex {
+ public:
+  //! 默认节点容量
+  static const size_t kDefaultNodeCapacity = 16;
+
+  SpatialIndex();
+  ~SpatialIndex();
+
+  SpatialIndex(const SpatialIndex&) = delete;
+  SpatialIndex& operator=(const SpatialIndex&) = delete;
+
+  /**
+   * @brief 批量构建索引, 几何对象为空的元素不参与索引
+   * @param elements 元素列表
+   * @param num_threads 构建线程数, 0表示使用硬件并发数
+   * @param node_capacity 节点容量, 小于2时按2处理
+   */
+  void Build(const std::vector<std::shared_ptr<MifElement>>& elements,
+             size_t num_threads = 1,
+             size_t node_capacity = kDefaultNodeCapacity);
+
+  //! 索引的元素数
+  size_t size() const;
+
+  /**
+   * @brief 范围查询
+   * @param env 查询范围
+   * @param res 返回外包框与查询范围相交的元素下标, 按下标升序
+   */
+  void Query(const geos::geom::Envelope& env, std::vector<size_t>& res) const;
+
+  /**
+   * @brief 点查询, 用于点在面内判断的候选筛选
+   * @param pt 查询点
+   * @param res 返回外包框包含查询点的元素下标, 按下标升序
+   */
+  void QueryPoint(const geos::geom::Coordinate& pt, std::vector<size_t>& res) const;
+
+  /**
+   * @brief k近邻查询, 距离为查询点到几何对象的平面欧氏距离, 点在面内时距离为0
+   * @param pt 查询点
+   * @param k 返回的元素数上限
+   * @param res 返回的元素下标, 按距离由近及远, 距离相同时按下标升序
+   */
+  void Nearest(const geos::geom::Coordinate& pt, size_t k, std::vector<size_t>& res) const;
+
+ private:
+  struct Impl;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+/**
+ * @brief 元素列表的只读视图, 通过const Mif访问元素时使用, 元素以指向常量的共享指针返回.
+ * 视图不持有元素列表, 在Mif的元素列表修改前有效
+ */
+class ConstElementsView {
+ public:
+  typedef std::vector<std::shared_ptr<MifElement>> Elements;
+
+  //! 只读迭代器, 解引用得到指向常量元素的共享指针
+  class const_iterator {
+   public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef std::shared_ptr<const MifElement> value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type* pointer;
+    typedef value_type reference;
+
+    explicit const_iterator(Elements::const_iterator it) : it_(it) {}
+
+    value_type operator*() const { return *it_; }
+    const_iterator& operator++() {
+      ++it_;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator res = *this;
+      ++it_;
+      return res;
+    }
+    bool operator==(const const_iterator& rhs) const { return it_ == rhs.it_; }
+    bool operator!=(const const_iterator& rhs) const { return it_ != rhs.it_; }
+
+   private:
+    Elements::const_iterator it_;
+  };
+
+  explicit ConstElementsView(const Elements& elements) : elements_(&elements) {}
+
+  size_t size() const { return elements_->size(); }
+  bool empty() const { return elements_->empty(); }
+
+  //! 第i个元素, 返回的共享指针会增加引用计数
+  std::shared_ptr<const MifElement> operator[](size_t i) const { return (*elements_)[i]; }
+  std::shared_ptr<const MifElement> front() const { return elements_->front(); }
+  std::shared_ptr<const MifElement> back() const { return elements_->back(); }
+
+  //! 第i个元素的裸指针, 不改变引用计数, 多线程频繁访问同一图层时使用
+  const MifElement* get(size_t i) const { return (*elements_)[i].get(); }
+
+  const_iterator begin() const { return const_iterator(elements_->begin()); }
+  const_iterator end() const { return const_iterator(elements_->end()); }
+
+ private:
+  const Elements* elements_;
 };
 
+struct LayerLoadResult;
+
 //! Mif结构
 class Mif {
  public:
@@ -229,32 +654,299 @@ class Mif {
    */
   static std::unique_ptr<Mif> Load(const std::string& layer_path, bool mid_only = false);
 
+  /**
+   * @brief 加载数据
+   * @param layer_path 图层路径, 不带MID/MIF后缀
+   * @param options 加载选项
+   * @return 成功返回Mif对象指针, 失败返回nullptr
+   */
+  static std::unique_ptr<Mif> Load(const std::string& layer_path, const LoadOptions& options);
+
+  /**
+   * @brief 并发加载多个图层, 各图层的加载与Load相同, 互不影响
+   * @param layer_paths 图层路径列表, 不带MID/MIF后缀
+   * @param options 批量加载选项
+   * @return 各图层的加载结果, 与layer_paths一一对应
+   */
+  static std::vector<LayerLoadResult> LoadBatch(
+      const std::vector<std::string>& layer_paths,
+      const BatchLoadOptions& options = BatchLoadOptions());
+
+  /**
+   * @brief 并发加载多个图层, 每个图层加载完成后交给回调处理, 不在内部保留;
+   * 回调不保留图层时, 内存中的图层数不超过工作线程数
+   * @param layer_paths 图层路径列表, 不带MID/MIF后缀
+   * @param options 批量加载选项
+   * @param on_loaded 回调函数, 参数为图层在列表中的下标与加载结果, 在工作线程中并发调用,
+   * 可取走结果中的图层; 抛出的第一个异常在调用线程重新抛出, 剩余图层不再加载
+   * @return 加载失败的图层数
+   */
+  static size_t LoadBatch(const std::vector<std::string>& layer_paths,
+                          const BatchLoadOptions& options,
+                          const std::function<void(size_t, LayerLoadResult&)>& on_loaded);
+
+  /**
+   * @brief 按通配符列出图层, 如"road_*.mif"或"road_*"; 只保留MIF文件(含.gz/.zst压缩文件),
+   * 去除后缀作为图层路径
+   * @param pattern 文件路径通配符, 语法同shell; Windows下只有最后一级可含通配符
+   * @return 排序去重后的图层路径列表, 无匹配时为空
+   */
+  static std::vector<std::string> ListLayers(const std::string& pattern);
+
+  /**
+   * @brief 生成图层的记录偏移索引, 写入图层旁的layer_path.gmifx文件;
+   * 索引记录各元素在MIF/MID中的偏移、外包框与几何类型, 图层文件修改后需重新生成
+   * @param layer_path 图层路径, 不带MID/MIF后缀
+   * @return 成功返回true, 失败返回false
+   */
+  static bool BuildOffsetIndex(const std::string& layer_path);
+
+  /**
+   * @brief 借助偏移索引加载连续的若干元素, 不解析范围之前的记录
+   * @param layer_path 图层路径, 不带MID/MIF后缀, 需已生成偏移索引
+   * @param begin 起始行号, 从0开始
+   * @param count 元素数, 超出记录数时截断
+   * @param options 加载选项, 忽略num_threads; 过滤条件在范围内生效
+   * @return 成功返回Mif对象指针, 索引不存在或已过期、起始行号越界时返回nullptr
+   */
+  static std::unique_ptr<Mif> LoadRange(const std::string& layer_path,
+                                        size_t begin,
+                                        size_t count,
+                                        const LoadOptions& options = LoadOptions());
+
+  /**
+   * @brief 借助偏移索引按行号加载元素
+   * @param layer_path 图层路径, 不带MID/MIF后缀, 需已生成偏移索引
+   * @param rows 行号列表, 从0开始, 元素按列表顺序返回, 未通过过滤条件的行被跳过
+   * @param options 加载选项, 忽略num_threads
+   * @return 成功返回Mif对象指针, 索引不存在或已过期、行号越界时返回nullptr
+   */
+  static std::unique_ptr<Mif> LoadRows(const std::string& layer_path,
+                                       const std::vector<size_t>& rows,
+                                       const LoadOptions& options = LoadOptions());
+
+  /**
+   * @brief 加载二进制缓存文件layer_path.gmifb, 坐标与属性数组整块复制, 不做文本解析;
+   * 生成缓存时图层文件layer_path.[mif/mid]存在的, 其修改或删除后缓存失效
+   * @param layer_path 图层路径, 不带后缀
+   * @param options 加载选项, 支持mid_only、num_threads、columnar_attrs与lazy_geo, 其余选项被忽略;
+   * lazy_geo时坐标整体复制为图层的坐标区, 不构造GEOS几何对象
+   * @return 成功返回Mif对象指针, 文件不存在、格式版本不符、校验失败或缓存过期时返回nullptr
+   */
+  static std::unique_ptr<Mif> LoadBinary(const std::string& layer_path,
+                                         const LoadOptions& options = LoadOptions());
+
   /**
    * @brief 保存数据
    * @param out_layer_path 图层路径, 不带MIF/MID后缀
+   * @param options 保存选项
    * @return 成功返回true, 失败返回false
    */
-  bool Dump(const std::string& out_layer_path);
+  bool Dump(const std::string& out_layer_path, const DumpOptions& options = DumpOptions());
+
+  /**
+   * @brief 保存为二进制缓存文件out_layer_path.gmifb, 包含MIF头、扁平坐标数组与列式属性,
+   * 属性按MIF头的列类型转换; 关联列式属性表的元素不会被物化. 图层文件out_layer_path.[mif/mid]
+   * 存在时记录其大小与修改时间, 用于LoadBinary判断缓存是否过期
+   * @param out_layer_path 图层路径, 不带后缀
+   * @return 成功返回true, 失败(含不支持的几何类型)返回false
+   */
+  bool DumpBinary(const std::string& out_layer_path);
 
   //! 获取MIF头
   MifHeader& header() { return header_; }
+  const MifHeader& header() const { return header_; }
 
   //! 获取元素列表
   std::vector<std::shared_ptr<MifElement>>& elements() { return elements_; }
+  //! 获取元素列表的只读视图, 共享的图层只能读取元素
+  ConstElementsView elements() const { return ConstElementsView(elements_); }
+
+  /**
+   * @brief 构建元素空间索引, 元素列表或几何对象修改后需重新构建
+   * @param num_threads 构建线程数, 0表示使用硬件并发数
+   */
+  void BuildIndex(size_t num_threads = 1);
+
+  //! 获取空间索引, 未构建时为nullptr
+  const SpatialIndex* index() const { return index_.get(); }
+
+  /**
+   * @brief 获取图层的坐标区, 以lazy_geo加载时第i项对应加载出的第i个元素(含无几何对象的元素),
+   * 否则为nullptr; 坐标区只读, 元素列表修改后不再与其对应
+   */
+  const GeoArena* arena() const { return arena_.get(); }
+
+  //! 设置图层的坐标区
+  void setArena(const std::shared_ptr<const GeoArena>& arena) { arena_ = arena; }
 
  private:
   MifHeader header_;
   std::vector<std::shared_ptr<MifElement>> elements_;
+  std::shared_ptr<const SpatialIndex> index_;
+  std::shared_ptr<const GeoArena> arena_;
+};
+
+//! 批量加载中单个图层的结果
+struct LayerLoadResult {
+  //! 图层路径
+  std::string layer_path;
+  //! 加载出的图层, 失败时为nullptr
+  std::unique_ptr<Mif> mif;
+  //! 失败原因, 成功时为空
+  std::string error;
+};
+
+//! 图层目录选项
+struct LayerCatalogOptions {
+  LayerCatalogOptions() : memory_budget(0), load() {}
+
+  //! 缓存图层的内存预算(字节), 0表示不限; 超出时按最近最少使用淘汰图层. 图层按加载后估计的
+  //! 内存占用(元素、属性、几何对象、坐标区与列式属性表)计入预算, 列式属性表只读访问产生的
+  //! 行解码缓存在获取图层时重新计入; 单个图层超出预算时不缓存
+  size_t memory_budget;
+  //! 图层的加载选项
+  LoadOptions load;
+};
+
+/**
+ * @brief 图层目录: 进程内缓存已加载的只读图层, 重复获取同一图层只需一次查找.
+ * 缓存项以图层路径及MIF/MID文件的大小与修改时间为键, 文件变化后自动重新加载;
+ * 同一图层的并发获取只加载一次. 可多线程并发调用
+ */
+class LayerCatalog {
+ public:
+  explicit LayerCatalog(const LayerCatalogOptions& options = LayerCatalogOptions());
+  ~LayerCatalog();
+
+  LayerCatalog(const LayerCatalog&) = delete;
+  LayerCatalog& operator=(const LayerCatalog&) = delete;
+
+  /**
+   * @brief 获取图层, 缓存中的图层文件未变化时直接返回, 否则加载并缓存;
+   * 其他线程正在加载同一图层时等待其结果
+   * @param layer_path 图层路径, 不带MID/MIF后缀, 按字符串区分图层
+   * @return 成功返回图层, 失败返回nullptr; 被淘汰的图层在使用方释放前仍然有效
+   */
+  std::shared_ptr<const Mif> Get(const std::string& layer_path);
+
+  //! 移除图层的缓存项, 正在进行的加载完成后不再缓存
+  void Invalidate(const std::string& layer_path);
+
+  //! 移除全部缓存项
+  void Clear();
+
+  //! 已缓存的图层数
+  size_t size() const;
+
+  //! 已缓存的图层估计占用的总内存(字节), 先重新计入行解码缓存, 超出预算时淘汰图层
+  size_t memoryUsage() const;
+
+ private:
+  struct Impl;
+
+  std::unique_ptr<Impl> impl_;
 };
 
-//! MIF读文件流
+//! MIF读文件流, 逐个读取元素, 内存占用与单个元素相当
 class MifIStream {
-  // TODO: MifIStream
+ public:
+  MifIStream();
+  ~MifIStream();
+
+  MifIStream(const MifIStream&) = delete;
+  MifIStream& operator=(const MifIStream&) = delete;
+
+  /**
+   * @brief 打开图层并读取MIF头
+   * @param layer_path 图层路径, 不带MID/MIF后缀
+   * @param options 加载选项, 关闭use_mmap时常驻内存仅为读取缓冲区
+   * @return 成功返回true, 失败返回false
+   */
+  bool Open(const std::string& layer_path, const LoadOptions& options = LoadOptions());
+
+  //! 关闭文件流
+  void Close();
+
+  //! 是否已打开
+  bool isOpen() const;
+
+  //! 获取MIF头, 需在Open成功后调用
+  const MifHeader& header() const { return header_; }
+
+  /**
+   * @brief 读取下一个元素
+   * @param elem 返回的元素对象
+   * @return 成功返回0, 失败返回-1, 文件结束返回1
+   */
+  int Read(MifElement& elem);
+
+  /**
+   * @brief 借助偏移索引跳转到指定行, 之后的Read从该行开始; 首次调用时加载偏移索引
+   * @param row 行号, 从0开始, 等于记录数时跳转到数据结束
+   * @return 成功返回true, 索引不存在或已过期、行号越界时返回false
+   */
+  bool Seek(size_t row);
+
+ private:
+  struct Impl;
+
+  std::string layer_path_;
+  MifHeader header_;
+  LoadOptions options_;
+  std::unique_ptr<Impl> impl_;
 };
 
-//! MIF写文件流
+//! MIF写文件流, 逐个写入元素, 写入后不持有元素
 class MifOStream {
-  // TODO: MifOStream
+ public:
+  MifOStream();
+  ~MifOStream();
+
+  MifOStream(const MifOStream&) = delete;
+  MifOStream& operator=(const MifOStream&) = delete;
+
+  /**
+   * @brief 创建图层文件并写入MIF头
+   * @param out_layer_path 图层路径, 不带MIF/MID后缀
+   * @param header MIF头对象
+   * @param options 保存选项
+   * @return 成功返回true, 失败返回false
+   */
+  bool Open(const std::string& out_layer_path,
+            const MifHeader& header,
+            const DumpOptions& options = DumpOptions());
+
+  /**
+   * @brief 将已写入的元素写出到文件, 后台写出时等待I/O线程写完已提交的数据
+   * @return 至今全部数据写入成功返回true, 失败或未打开返回false
+   */
+  bool Flush();
+
+  /**
+   * @brief 刷新并关闭文件流
+   * @return 全部数据写入成功返回true, 失败返回false
+   */
+  bool Close();
+
+  //! 是否已打开
+  bool isOpen() const;
+
+  //! 获取MIF头, 需在Open成功后调用
+  const MifHeader& header() const { return header_; }
+
+  /**
+   * @brief 写入单个元素
+   * @param elem 元素对象
+   * @return 成功返回0, 失败返回-1
+   */
+  int Write(MifElement& elem);
+
+ private:
+  struct Impl;
+
+  MifHeader header_;
+  std::unique_ptr<Impl> impl_;
 };
 
 }  // namespace gmif
@@ -0,0 +1,254 @@
+#include "attr_table.h"
+
+namespace gmif {
+
+//! 字典取值数超过该值且超过行数一半时关闭去重, 避免高基数列维护哈希表
+static const size_t kDictMaxDistinct = 4096;
+
+static inline uint64_t HashBytes(utils::StrView str) {
+  uint64_t h = 14695981039346656037ULL;  // FNV-1a
+  for (char c : str) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+uint32_t StrDict::Intern(utils::StrView str) {
+  uint32_t code = static_cast<uint32_t>(size());
+  if (dedup_) {
+    if ((size() + 1) * 2 > slots_.size()) {
+      // Assign或Shrink释放哈希表后已有取值, 按取值数重建
+      size_t num_slots = slots_.empty() ? 64 : slots_.size() * 2;
+      while ((size() + 1) * 2 > num_slots) {
+        num_slots *= 2;
+      }
+      Rehash(num_slots);
+    }
+    size_t mask = slots_.size() - 1;
+    for (size_t i = HashBytes(str) & mask;; i = (i + 1) & mask) {
+      if (slots_[i] == 0) {
+        slots_[i] = code + 1;
+        break;
+      }
+      if (get(slots_[i] - 1) == str) {
+        return slots_[i] - 1;
+      }
+    }
+  }
+  arena_.append(str.data(), str.size());
+  offsets_.push_back(arena_.size());
+  return code;
+}
+
+void StrDict::Rehash(size_t num_slots) {
+  slots_.assign(num_slots, 0);
+  size_t mask = num_slots - 1;
+  for (uint32_t code = 0; code < size(); ++code) {
+    size_t i = HashBytes(get(code)) & mask;
+    while (slots_[i] != 0) {
+      i = (i + 1) & mask;
+    }
+    slots_[i] = code + 1;
+  }
+}
+
+void StrDict::Assign(const char* arena, const uint64_t* offsets, size_t num) {
+  arena_.assign(arena, offsets[num]);
+  offsets_.assign(offsets, offsets + num + 1);
+  std::vector<uint32_t>().swap(slots_);
+}
+
+void StrDict::DisableDedup() {
+  dedup_ = false;
+  std::vector<uint32_t>().swap(slots_);
+}
+
+void StrDict::Shrink() {
+  std::vector<uint32_t>().swap(slots_);
+  arena_.shrink_to_fit();
+  offsets_.shrink_to_fit();
+}
+
+const std::shared_ptr<const std::string>* StrPool::Intern(utils::StrView str) {
+  if (!enabled_) {
+    return nullptr;
+  }
+  if ((size_ + 1) * 2 > slots_.size()) {
+    Rehash(slots_.empty() ? 64 : slots_.size() * 2);
+  }
+  size_t mask = slots_.size() - 1;
+  for (size_t i = HashBytes(str) & mask;; i = (i + 1) & mask) {
+    if (slots_[i] == nullptr) {
+      slots_[i] = std::make_shared<const std::string>(str.data(), str.size());
+      ++size_;
+      return &slots_[i];
+    }
+    if (utils::StrView(*slots_[i]) == str) {
+      return &slots_[i];
+    }
+  }
+}
+
+void StrPool::Rehash(size_t num_slots) {
+  std::vector<std::shared_ptr<const std::string>> old_slots(num_slots);
+  old_slots.swap(slots_);
+  size_t mask = num_slots - 1;
+  for (auto& entry : old_slots) {
+    if (entry == nullptr) {
+      continue;
+    }
+    size_t i = HashBytes(utils::StrView(*entry)) & mask;
+    while (slots_[i] != nullptr) {
+      i = (i + 1) & mask;
+    }
+    slots_[i] = std::move(entry);
+  }
+}
+
+void StrPool::Disable() {
+  enabled_ = false;
+  size_ = 0;
+  std::vector<std::shared_ptr<const std::string>>().swap(slots_);
+}
+
+AttrTable::AttrTable(const MifHeader& header) : schema_(header), row_size_(0), cache_memory_(0) {
+  columns_.resize(schema_.size());
+}
+
+void AttrTable::reserve(size_t rows) {
+  for (size_t col = 0; col < columns_.size(); ++col) {
+    switch (schema_[col].type) {
+      case io::ColType::kInt:
+        columns_[col].ints.reserve(rows);
+        break;
+      case io::ColType::kDouble:
+        columns_[col].doubles.reserve(rows);
+        break;
+      default:
+        columns_[col].codes.reserve(rows);
+        break;
+    }
+  }
+}
+
+size_t AttrTable::appendRow(const std::vector<utils::StrView>& items) {
+  for (size_t col = 0; col < columns_.size(); ++col) {
+    const utils::StrView& item = items[col];
+    Column& column = columns_[col];
+    switch (schema_[col].type) {
+      case io::ColType::kInt:
+        column.ints.push_back(item.empty() ? 0 : static_cast<int32_t>(utils::to_int(item)));
+        break;
+      case io::ColType::kDouble:
+        column.doubles.push_back(item.empty() ? 0.0 : utils::to_double(item));
+        break;
+      default:
+        appendStr(column, item);
+        break;
+    }
+  }
+  return row_size_++;
+}
+
+size_t AttrTable::appendValues(const std::vector<const AttrValue*>& values) {
+  for (size_t col = 0; col < columns_.size(); ++col) {
+    const AttrValue* val = values[col];
+    Column& column = columns_[col];
+    switch (schema_[col].type) {
+      case io::ColType::kInt:
+        column.ints.push_back(val != nullptr ? val->getInt() : 0);
+        break;
+      case io::ColType::kDouble:
+        column.doubles.push_back(val != nullptr ? val->getDouble() : 0.0);
+        break;
+      default:
+        if (val == nullptr) {
+          appendStr(column, utils::StrView());
+        } else if (val->getKind() == AttrValue::Kind::kStr) {
+          appendStr(column, utils::StrView(val->getStrData(), val->getStrSize()));
+        } else {
+          appendStr(column, val->getStr());
+        }
+        break;
+    }
+  }
+  return row_size_++;
+}
+
+void AttrTable::appendStr(Column& column, utils::StrView str) {
+  column.codes.push_back(column.dict.Intern(str));
+  if (column.dict.isDedup() && column.dict.size() > kDictMaxDistinct &&
+      column.dict.size() * 2 > row_size_ + 1) {
+    column.dict.DisableDedup();
+  }
+}
+
+void AttrTable::getValue(size_t col, size_t row, AttrValue& res) const {
+  switch (schema_[col].type) {
+    case io::ColType::kInt:
+      res = getInt(col, row);
+      break;
+    case io::ColType::kDouble:
+      res = getDouble(col, row);
+      break;
+    default: {
+      utils::StrView str = getStr(col, row);
+      res.setStr(str.data(), str.size());
+      break;
+    }
+  }
+}
+
+void AttrTable::Shrink() {
+  for (auto& column : columns_) {
+    column.ints.shrink_to_fit();
+    column.doubles.shrink_to_fit();
+    column.codes.shrink_to_fit();
+    column.dict.Shrink();
+  }
+}
+
+//! AttrMap每个节点的估计大小: 红黑树节点头、列名与属性值
+static const size_t kAttrNodeOverhead = 4 * sizeof(void*) + sizeof(AttrMap::value_type);
+
+size_t AttrMapMemory(const AttrMap& attrs) {
+  size_t usage = 0;
+  for (const auto& attr : attrs) {
+    usage += kAttrNodeOverhead;
+    const AttrValue& val = attr.second;
+    if (val.getKind() == AttrValue::Kind::kStr && !val.isSharedStr() &&
+        val.getStrSize() > AttrValue::kInlineCapacity) {
+      usage += val.getStrSize();
+    }
+  }
+  return usage;
+}
+
+size_t AttrTable::memoryUsage() const {
+  size_t usage = sizeof(AttrTable) + columns_.capacity() * sizeof(Column);
+  for (const auto& column : columns_) {
+    usage += column.ints.capacity() * sizeof(int32_t) +
+             column.doubles.capacity() * sizeof(double) +
+             column.codes.capacity() * sizeof(uint32_t) + column.dict.memoryUsage();
+  }
+  return usage;
+}
+
+void AttrTable::assignInts(size_t col, const int32_t* values, size_t rows) {
+  columns_[col].ints.assign(values, values + rows);
+  row_size_ = rows;
+}
+
+void AttrTable::assignDoubles(size_t col, const double* values, size_t rows) {
+  columns_[col].doubles.assign(values, values + rows);
+  row_size_ = rows;
+}
+
+void AttrTable::assignStrs(size_t col, const uint32_t* codes, size_t rows, StrDict&& dict) {
+  columns_[col].codes.assign(codes, codes + rows);
+  columns_[col].dict = std::move(dict);
+  row_size_ = rows;
+}
+
+}  // namespace gmif
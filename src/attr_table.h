@@ -0,0 +1,203 @@
+#ifndef GMIF_SRC_ATTR_TABLE_H_
+#define GMIF_SRC_ATTR_TABLE_H_
+
+#include "gmif/gmif.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "schema.h"
+#include "utils.h"
+
+namespace gmif {
+
+//! 字符串字典, 所有取值连续存放, 按编码访问
+class StrDict {
+ public:
+  StrDict() : offsets_(1, 0), dedup_(true) {}
+
+  /**
+   * @brief 写入字符串
+   * @param str 字符串
+   * @return 字符串编码, 去重开启时相同字符串返回相同编码
+   */
+  uint32_t Intern(utils::StrView str);
+
+  //! 获取编码对应的字符串, 返回值在下次写入前有效
+  utils::StrView get(uint32_t code) const {
+    return utils::StrView(arena_.data() + offsets_[code], offsets_[code + 1] - offsets_[code]);
+  }
+
+  //! 字典取值数量
+  size_t size() const { return offsets_.size() - 1; }
+
+  //! 是否对写入的字符串去重
+  bool isDedup() const { return dedup_; }
+
+  //! 关闭去重, 此后每次写入都追加新取值, 并释放哈希表
+  void DisableDedup();
+
+  //! 释放构建期的哈希表与多余容量
+  void Shrink();
+
+  //! 占用的堆内存字节数(按容量计)
+  size_t memoryUsage() const {
+    return arena_.capacity() + offsets_.capacity() * sizeof(uint64_t) +
+           slots_.capacity() * sizeof(uint32_t);
+  }
+
+  //! 字符串内容, 各取值首尾相接
+  const std::string& getArena() const { return arena_; }
+  //! 各取值的起始偏移, 大小为取值数 + 1
+  const std::vector<uint64_t>& getOffsets() const { return offsets_; }
+
+  /**
+   * @brief 以原始数据整体设置字典, 用于从二进制缓存恢复; 此后写入时按需重建哈希表
+   * @param arena 字符串内容
+   * @param offsets 各取值的起始偏移, 共num + 1个, 首个为0且非递减
+   * @param num 取值数
+   */
+  void Assign(const char* arena, const uint64_t* offsets, size_t num);
+
+ private:
+  void Rehash(size_t num_slots);
+
+  std::string arena_;               // 字符串内容
+  std::vector<uint64_t> offsets_;   // 各取值在arena_中的起始偏移, 末尾为总长度
+  std::vector<uint32_t> slots_;     // 开放寻址哈希表, 存放编码 + 1, 0表示空槽
+  bool dedup_;
+};
+
+//! 字符串驻留池, 相同取值共享同一存储, 池释放后已驻留的字符串仍然有效
+class StrPool {
+ public:
+  StrPool() : size_(0), enabled_(true) {}
+
+  /**
+   * @brief 查找或新增字符串
+   * @param str 字符串
+   * @return 共享字符串, 在下次调用前有效, 驻留已停用时返回nullptr
+   */
+  const std::shared_ptr<const std::string>* Intern(utils::StrView str);
+
+  //! 驻留数量
+  size_t size() const { return size_; }
+
+  //! 是否仍在驻留
+  bool isEnabled() const { return enabled_; }
+
+  //! 停止驻留并释放池
+  void Disable();
+
+ private:
+  void Rehash(size_t num_slots);
+
+  std::vector<std::shared_ptr<const std::string>> slots_;  // 开放寻址哈希表, 空指针表示空槽
+  size_t size_;
+  bool enabled_;
+};
+
+//! 列式属性表, 每列一个类型化数组, 字符串列使用字典编码
+class AttrTable {
+ public:
+  explicit AttrTable(const MifHeader& header);
+
+  //! 列定义
+  const io::ColumnSchema& schema() const { return schema_; }
+
+  //! 行数
+  size_t getRowSize() const { return row_size_; }
+
+  //! 预留行容量
+  void reserve(size_t rows);
+
+  /**
+   * @brief 按列类型解码并追加一行
+   * @param items 各字段文本, 数量需与列数一致
+   * @return 追加的行下标
+   */
+  size_t appendRow(const std::vector<utils::StrView>& items);
+
+  /**
+   * @brief 按列类型转换并追加一行, 转换规则与写出MID时一致
+   * @param values 各列取值, 数量需与列数一致, 为nullptr时取默认值(0或空字符串)
+   * @return 追加的行下标
+   */
+  size_t appendValues(const std::vector<const AttrValue*>& values);
+
+  /**
+   * @brief 读取单元格
+   * @param col 列下标
+   * @param row 行下标
+   * @param res 属性值, 与按行读取时得到的值一致
+   */
+  void getValue(size_t col, size_t row, AttrValue& res) const;
+
+  int32_t getInt(size_t col, size_t row) const { return columns_[col].ints[row]; }
+  double getDouble(size_t col, size_t row) const { return columns_[col].doubles[row]; }
+  utils::StrView getStr(size_t col, size_t row) const {
+    const Column& column = columns_[col];
+    return column.dict.get(column.codes[row]);
+  }
+
+  //! 加载结束后释放构建期辅助结构与多余容量
+  void Shrink();
+
+  //! 占用的内存字节数(按容量计), 不含元素的行解码缓存
+  size_t memoryUsage() const;
+
+  //! 关联本表的元素中行解码缓存占用的内存字节数, 可多线程并发调用
+  size_t cacheMemory() const { return cache_memory_.load(std::memory_order_relaxed); }
+
+  //! 登记或扣除元素的行解码缓存占用的内存, 可多线程并发调用
+  void addCacheMemory(size_t bytes) const {
+    cache_memory_.fetch_add(bytes, std::memory_order_relaxed);
+  }
+  void subCacheMemory(size_t bytes) const {
+    cache_memory_.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  //! 列的原始数组, 仅对应类型的列非空, 用于二进制缓存
+  const std::vector<int32_t>& getInts(size_t col) const { return columns_[col].ints; }
+  const std::vector<double>& getDoubles(size_t col) const { return columns_[col].doubles; }
+  const std::vector<uint32_t>& getCodes(size_t col) const { return columns_[col].codes; }
+  const StrDict& getDict(size_t col) const { return columns_[col].dict; }
+
+  /**
+   * @brief 以原始数组整体设置一列, 用于从二进制缓存恢复, 各列的行数需一致
+   * @param col 列下标, 列类型需与设置的数组对应
+   * @param values 各行取值
+   * @param rows 行数
+   */
+  void assignInts(size_t col, const int32_t* values, size_t rows);
+  void assignDoubles(size_t col, const double* values, size_t rows);
+  //! codes为各行的字典编码, 需小于dict的取值数
+  void assignStrs(size_t col, const uint32_t* codes, size_t rows, StrDict&& dict);
+
+ private:
+  struct Column {
+    std::vector<int32_t> ints;     // kInt列取值
+    std::vector<double> doubles;   // kDouble列取值
+    std::vector<uint32_t> codes;   // kStr列各行的字典编码
+    StrDict dict;                  // kStr列字典
+  };
+
+  //! 向字符串列追加取值, 高基数时关闭去重
+  void appendStr(Column& column, utils::StrView str);
+
+  io::ColumnSchema schema_;
+  std::vector<Column> columns_;
+  size_t row_size_;
+  mutable std::atomic<size_t> cache_memory_;  // 行解码缓存, 只读访问时产生
+};
+
+/**
+ * @brief 估计AttrMap占用的内存, 含红黑树节点、列名与属性值, 共享字符串不计入
+ * @param attrs 属性集合
+ * @return 估计的字节数
+ */
+size_t AttrMapMemory(const AttrMap& attrs);
+
+}  // namespace gmif
+
+#endif  // GMIF_SRC_ATTR_TABLE_H_
@@ -1,108 +1,268 @@
 #include "gmif/gmif.h"
+#include <algorithm>
 #include "utils.h"
 
 namespace gmif {
 
-AttrValue::AttrValue() : num_val_(0), init_flag_(0) {}
+AttrValue::AttrValue() : int_val_(0), kind_(Kind::kNull), storage_(kInline), inline_size_(0) {}
 
-AttrValue::AttrValue(const std::string& v) : str_val_(v), num_val_(0), init_flag_(1) {}
+AttrValue::AttrValue(const std::string& v) : AttrValue() {
+  setStr(v.data(), v.size());
+}
+
+AttrValue::AttrValue(const char* v) : AttrValue() {
+  setStr(v, strlen(v));
+}
 
-AttrValue::AttrValue(const char* v) : str_val_(v), num_val_(0), init_flag_(1) {}
+AttrValue::AttrValue(int32_t v)
+    : int_val_(v), kind_(Kind::kInt), storage_(kInline), inline_size_(0) {}
 
-AttrValue::AttrValue(int32_t v) : num_val_(v), init_flag_(2) {}
+AttrValue::AttrValue(int64_t v)
+    : int_val_(v), kind_(Kind::kInt), storage_(kInline), inline_size_(0) {}
 
-AttrValue::AttrValue(double v) : num_val_(v), init_flag_(2) {}
+AttrValue::AttrValue(double v)
+    : dbl_val_(v), kind_(Kind::kDouble), storage_(kInline), inline_size_(0) {}
 
-AttrValue::AttrValue(AttrValue&& rhs) noexcept : num_val_(rhs.num_val_), init_flag_(rhs.init_flag_) {
-  str_val_ = std::move(rhs.str_val_);
+AttrValue::AttrValue(const AttrValue& rhs) : AttrValue() {
+  *this = rhs;
+}
+
+AttrValue::AttrValue(AttrValue&& rhs) noexcept : AttrValue() {
+  moveFrom(rhs);
+}
+
+AttrValue::~AttrValue() {
+  release();
+}
+
+void AttrValue::release() {
+  if (storage_ == kHeap) {
+    delete[] heap_.data;
+  } else if (storage_ == kShared) {
+    shared_.~shared_ptr();
+  }
+  storage_ = kInline;
+  inline_size_ = 0;
+}
+
+void AttrValue::copyNumber(const AttrValue& rhs) {
+  release();
+  memcpy(&int_val_, &rhs.int_val_, sizeof(int_val_));
+  kind_ = rhs.kind_;
+}
+
+void AttrValue::moveFrom(AttrValue& rhs) noexcept {
+  release();
+  if (rhs.storage_ == kShared) {
+    new (&shared_) std::shared_ptr<const std::string>(std::move(rhs.shared_));
+    rhs.shared_.~shared_ptr();
+  } else {
+    memcpy(inline_, rhs.inline_, sizeof(inline_));  // 复制整个存储区, 堆上字符串随之转移
+  }
+  kind_ = rhs.kind_;
+  storage_ = rhs.storage_;
+  inline_size_ = rhs.inline_size_;
+  rhs.kind_ = Kind::kNull;
+  rhs.storage_ = kInline;
+  rhs.inline_size_ = 0;
+}
+
+AttrValue& AttrValue::operator=(const AttrValue& rhs) {
+  if (this == &rhs) {
+    return *this;
+  }
+  if (rhs.kind_ != Kind::kStr) {
+    copyNumber(rhs);
+  } else if (rhs.storage_ == kShared) {
+    setStr(rhs.shared_);
+  } else {
+    setStr(rhs.getStrData(), rhs.getStrSize());
+  }
+  return *this;
 }
 
 AttrValue& AttrValue::operator=(AttrValue&& rhs) noexcept {
   if (this != &rhs) {
-    str_val_ = std::move(rhs.str_val_);
-    num_val_ = rhs.num_val_;
-    init_flag_ = rhs.init_flag_;
+    moveFrom(rhs);
   }
   return *this;
 }
 
 AttrValue& AttrValue::operator=(const std::string& v) {
-  str_val_.assign(v);
-  init_flag_ = 1;
+  setStr(v.data(), v.size());
   return *this;
 }
 
 AttrValue& AttrValue::operator=(const char* v) {
-  str_val_.assign(v);
-  init_flag_ = 1;
+  setStr(v, strlen(v));
   return *this;
 }
 
 AttrValue& AttrValue::operator=(int32_t v) {
-  num_val_ = v;
-  init_flag_ = 2;
+  return *this = static_cast<int64_t>(v);
+}
+
+AttrValue& AttrValue::operator=(int64_t v) {
+  release();
+  int_val_ = v;
+  kind_ = Kind::kInt;
   return *this;
 }
 
 AttrValue& AttrValue::operator=(double v) {
-  num_val_ = v;
-  init_flag_ = 2;
+  release();
+  dbl_val_ = v;
+  kind_ = Kind::kDouble;
   return *this;
 }
 
+void AttrValue::setStr(const char* v, size_t len) {
+  std::shared_ptr<const std::string> hold;  // v可能指向自身的共享字符串
+  if (storage_ == kShared) {
+    hold = std::move(shared_);
+    release();
+  }
+  if (storage_ == kHeap && heap_.capacity >= len) {  // 复用已有容量
+    memmove(heap_.data, v, len);
+    heap_.size = len;
+  } else if (len <= kInlineCapacity) {
+    if (storage_ == kHeap) {  // v不可能指向容量不足的自身缓冲区
+      release();
+    }
+    memmove(inline_, v, len);
+    inline_size_ = static_cast<uint8_t>(len);
+  } else {
+    char* data = new char[len];
+    memcpy(data, v, len);
+    release();
+    heap_.data = data;
+    heap_.size = len;
+    heap_.capacity = len;
+    storage_ = kHeap;
+  }
+  kind_ = Kind::kStr;
+}
+
+void AttrValue::setStr(const std::shared_ptr<const std::string>& v) {
+  if (storage_ == kShared) {
+    if (shared_ != v) {
+      shared_ = v;
+    }
+  } else {
+    release();
+    new (&shared_) std::shared_ptr<const std::string>(v);
+    storage_ = kShared;
+  }
+  kind_ = Kind::kStr;
+}
+
 bool AttrValue::operator==(const AttrValue& rhs) const {
-  if (init_flag_.test(0) && rhs.init_flag_.test(0)) {
-    return str_val_ == rhs.str_val_;
+  if (kind_ == Kind::kStr && rhs.kind_ == Kind::kStr) {
+    if (storage_ == kShared && rhs.storage_ == kShared && shared_ == rhs.shared_) {
+      return true;
+    }
+    return getStrSize() == rhs.getStrSize() &&
+           memcmp(getStrData(), rhs.getStrData(), getStrSize()) == 0;
   }
-  if (init_flag_.test(1) && rhs.init_flag_.test(1)) {
-    return utils::DoubleEqual(num_val_, rhs.num_val_);
+  if (kind_ == Kind::kInt && rhs.kind_ == Kind::kInt) {
+    return int_val_ == rhs.int_val_;
+  }
+  bool is_num = (kind_ == Kind::kInt || kind_ == Kind::kDouble);
+  bool rhs_is_num = (rhs.kind_ == Kind::kInt || rhs.kind_ == Kind::kDouble);
+  if (is_num && rhs_is_num) {
+    return utils::DoubleEqual(getDouble(), rhs.getDouble());
   }
   return true;  // non initialization
 }
 
+//! 字符串按字节比较, 返回值同memcmp
+static int CompareStr(const AttrValue& lhs, const AttrValue& rhs) {
+  size_t len = std::min(lhs.getStrSize(), rhs.getStrSize());
+  int res = len == 0 ? 0 : memcmp(lhs.getStrData(), rhs.getStrData(), len);
+  if (res != 0) {
+    return res;
+  }
+  return lhs.getStrSize() < rhs.getStrSize() ? -1 : (lhs.getStrSize() > rhs.getStrSize() ? 1 : 0);
+}
+
 bool AttrValue::operator<(const AttrValue& rhs) const {
-  if (init_flag_.test(0) && rhs.init_flag_.test(0)) {
-    return str_val_ < rhs.str_val_;
+  if (kind_ == Kind::kStr && rhs.kind_ == Kind::kStr) {
+    return CompareStr(*this, rhs) < 0;
+  }
+  if (kind_ == Kind::kInt && rhs.kind_ == Kind::kInt) {
+    return int_val_ < rhs.int_val_;
   }
-  if (init_flag_.test(1) && rhs.init_flag_.test(1)) {
-    return num_val_ < rhs.num_val_;
+  if (kind_ != Kind::kNull && kind_ != Kind::kStr && rhs.kind_ != Kind::kNull &&
+      rhs.kind_ != Kind::kStr) {
+    return getDouble() < rhs.getDouble();
   }
   return false;
 }
 
 bool AttrValue::operator>(const AttrValue& rhs) const {
-  if (init_flag_.test(0) && rhs.init_flag_.test(0)) {
-    return str_val_ > rhs.str_val_;
-  }
-  if (init_flag_.test(1) && rhs.init_flag_.test(1)) {
-    return num_val_ > rhs.num_val_;
-  }
-  return false;
+  return rhs < *this;
 }
 
-const std::string& AttrValue::getStr() {
-  if (!init_flag_.test(0) && init_flag_.test(1)) {
-    str_val_ = utils::to_string(num_val_);
-    init_flag_.set(0, true);
+std::string AttrValue::getStr() const {
+  char buf[utils::kFixedBufferSize];
+  size_t len = 0;
+  switch (kind_) {
+    case Kind::kStr:
+      return std::string(getStrData(), getStrSize());
+    case Kind::kInt:
+      len = utils::FormatInt(int_val_, buf);
+      if (GMIF_DOUBLE_PRECISION > 0) {
+        buf[len++] = '.';
+        memset(buf + len, '0', GMIF_DOUBLE_PRECISION);
+        len += GMIF_DOUBLE_PRECISION;
+      }
+      return std::string(buf, len);
+    case Kind::kDouble:
+      len = utils::FormatFixed(dbl_val_, GMIF_DOUBLE_PRECISION, buf);
+      return std::string(buf, len);
+    default:
+      return std::string();
   }
-  return str_val_;
 }
 
-int32_t AttrValue::getInt() {
+int32_t AttrValue::getInt() const {
+  if (kind_ == Kind::kInt) {
+    return static_cast<int32_t>(int_val_);
+  }
   return static_cast<int32_t>(getDouble());
 }
 
-double AttrValue::getDouble() {
-  if (!init_flag_.test(1) && init_flag_.test(0)) {
-    num_val_ = strtod(str_val_.c_str(), nullptr);
-    init_flag_.set(1, true);
+int64_t AttrValue::getInt64() const {
+  if (kind_ == Kind::kInt) {
+    return int_val_;
+  }
+  return static_cast<int64_t>(getDouble());
+}
+
+double AttrValue::getDouble() const {
+  switch (kind_) {
+    case Kind::kInt:
+      return static_cast<double>(int_val_);
+    case Kind::kDouble:
+      return dbl_val_;
+    case Kind::kStr: {
+      const char* begin = getStrData();
+      const char* end = begin + getStrSize();
+      double v = 0;
+      if (begin != end && utils::ParseDouble(begin, end, v) == end) {
+        return v;
+      }
+      std::string str(begin, end);  // 非常规格式按strtod语义解析
+      return strtod(str.c_str(), nullptr);
+    }
+    default:
+      return 0;
   }
-  return num_val_;
 }
 
-bool AttrValue::ValueEqual(AttrValue& rhs) {
+bool AttrValue::ValueEqual(const AttrValue& rhs) const {
   if (*this == rhs) return true;
   return getStr() == rhs.getStr();
 }
 
-}  // namespace gmif
\ No newline at end of file
+}  // namespace gmif
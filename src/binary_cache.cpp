@@ -0,0 +1,584 @@
+#include "binary_cache.h"
+#include <geos/geom/GeometryFactory.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include "attr_table.h"
+#include "mapped_file.h"
+#include "offset_index.h"
+#include "parallel.h"
+#include "utils.h"
+
+using namespace geos::geom;
+
+namespace gmif {
+namespace io {
+
+const char* const kBinaryCacheExtension = "gmifb";
+
+static const char kCacheMagic[8] = {'G', 'M', 'I', 'F', 'B', '\0', '\0', '\0'};
+static const uint32_t kCacheVersion = 2;  // 2: 记录源图层时间戳
+//! 字节序标记, 与本机不一致说明缓存由不同字节序的机器生成
+static const uint32_t kByteOrderMark = 0x01020304;
+//! 每个线程分配的任务块数
+static const size_t kChunksPerThread = 4;
+
+//! 缓存文件头
+struct CacheFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint64_t file_size;
+  uint64_t checksum;  // 文件头之后全部内容的校验和
+  uint64_t num_elements;
+  uint64_t num_parts;  // 部件数: 多线/多面中的每条线/每个面, 其余几何为1
+  uint64_t num_rings;  // 环数: 面的外环与内环, 其余部件为1
+  uint64_t num_coords;
+  uint64_t has_source;  // 写入时源图层是否存在, 存在时记录其时间戳
+  FileStamp mif_stamp;
+  FileStamp mid_stamp;
+};
+
+static const uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+static const size_t kChecksumBlock = 32;
+
+static inline uint64_t Rotl(uint64_t v, int r) {
+  return (v << r) | (v >> (64 - r));
+}
+
+//! 增量计算的64位校验和, 按32字节分4路累加
+class Checksum {
+ public:
+  Checksum() : size_(0), pending_size_(0) {
+    lanes_[0] = kPrime1 + kPrime2;
+    lanes_[1] = kPrime2;
+    lanes_[2] = 0;
+    lanes_[3] = 0 - kPrime1;
+  }
+
+  void Update(const char* data, size_t size) {
+    if (size == 0) {
+      return;
+    }
+    size_ += size;
+    if (pending_size_ > 0) {
+      size_t n = std::min(kChecksumBlock - pending_size_, size);
+      memcpy(pending_ + pending_size_, data, n);
+      pending_size_ += n;
+      data += n;
+      size -= n;
+      if (pending_size_ < kChecksumBlock) {
+        return;
+      }
+      Round(pending_);
+      pending_size_ = 0;
+    }
+    for (; size >= kChecksumBlock; data += kChecksumBlock, size -= kChecksumBlock) {
+      Round(data);
+    }
+    memcpy(pending_, data, size);
+    pending_size_ = size;
+  }
+
+  uint64_t Final() const {
+    uint64_t h =
+        Rotl(lanes_[0], 1) + Rotl(lanes_[1], 7) + Rotl(lanes_[2], 12) + Rotl(lanes_[3], 18);
+    h ^= size_ * kPrime1;
+    for (size_t i = 0; i < pending_size_; ++i) {
+      h = Rotl(h ^ (static_cast<unsigned char>(pending_[i]) * kPrime2), 11) * kPrime1;
+    }
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime1;
+    h ^= h >> 32;
+    return h;
+  }
+
+ private:
+  void Round(const char* block) {
+    for (int i = 0; i < 4; ++i) {
+      uint64_t word;
+      memcpy(&word, block + i * 8, 8);
+      lanes_[i] = Rotl(lanes_[i] + word * kPrime2, 31) * kPrime1;
+    }
+  }
+
+  uint64_t lanes_[4];
+  uint64_t size_;
+  char pending_[kChecksumBlock];
+  size_t pending_size_;
+};
+
+//! 缓存写入流, 累计写入长度与校验和
+class CacheWriter {
+ public:
+  explicit CacheWriter(std::ofstream& ofs) : ofs_(ofs), size_(0) {}
+
+  void Write(const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    ofs_.write(bytes, size);
+    checksum_.Update(bytes, size);
+    size_ += size;
+  }
+
+  void WriteU64(uint64_t v) { Write(&v, sizeof(v)); }
+
+  //! 写入数组并补齐到8字节对齐
+  template <typename T>
+  void WriteArray(const T* data, size_t count) {
+    static const char kZeros[8] = {0};
+    Write(data, count * sizeof(T));
+    Write(kZeros, (8 - size_ % 8) % 8);
+  }
+
+  template <typename T>
+  void WriteArray(const std::vector<T>& v) {
+    WriteArray(v.data(), v.size());
+  }
+
+  //! 已写入的字节数
+  uint64_t size() const { return size_; }
+  uint64_t checksum() const { return checksum_.Final(); }
+
+ private:
+  std::ofstream& ofs_;
+  Checksum checksum_;
+  uint64_t size_;
+};
+
+//! 缓存读取游标, 越界时返回失败
+class CacheReader {
+ public:
+  CacheReader(const char* begin, const char* end) : begin_(begin), pos_(begin), end_(end) {}
+
+  bool ReadU64(uint64_t& v) {
+    if (end_ - pos_ < 8) {
+      return false;
+    }
+    memcpy(&v, pos_, sizeof(v));
+    pos_ += sizeof(v);
+    return true;
+  }
+
+  bool ReadStr(std::string& str) {
+    uint64_t size = 0;
+    if (!ReadU64(size) || size > static_cast<uint64_t>(end_ - pos_)) {
+      return false;
+    }
+    str.assign(pos_, size);
+    pos_ += size;
+    return true;
+  }
+
+  //! 读取数组并跳过对齐填充, 数据不足时返回nullptr
+  template <typename T>
+  const T* ReadArray(uint64_t count) {
+    if (count > static_cast<uint64_t>(end_ - pos_) / sizeof(T)) {
+      return nullptr;
+    }
+    const T* res = reinterpret_cast<const T*>(pos_);
+    pos_ += count * sizeof(T);
+    size_t pad = (8 - (pos_ - begin_) % 8) % 8;
+    pos_ += std::min(pad, static_cast<size_t>(end_ - pos_));
+    return res;
+  }
+
+ private:
+  const char* begin_;
+  const char* pos_;
+  const char* end_;
+};
+
+static void PutU64(std::string& out, uint64_t v) {
+  out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+static void PutStr(std::string& out, const std::string& str) {
+  PutU64(out, str.size());
+  out.append(str);
+}
+
+//! 序列化MIF头
+static std::string SerializeHeader(const MifHeader& header) {
+  std::string out;
+  PutU64(out, header.getVersion());
+  PutStr(out, header.getCharset());
+  PutU64(out, static_cast<unsigned char>(header.getDelimiter()));
+  PutStr(out, header.getCoordsys());
+  PutStr(out, header.getTransform());
+  for (const std::vector<size_t>* vec : {&header.getUniqueVec(), &header.getIndexVec()}) {
+    PutU64(out, vec->size());
+    for (size_t v : *vec) {
+      PutU64(out, v);
+    }
+  }
+  PutU64(out, header.getColumnSize());
+  for (size_t i = 0; i < header.getColumnSize(); ++i) {
+    PutStr(out, header.getColumnName(i));
+    PutStr(out, header.getColumnType(i));
+  }
+  return out;
+}
+
+//! 反序列化MIF头
+static bool ParseHeader(CacheReader& reader, MifHeader& header) {
+  uint64_t version = 0;
+  uint64_t delimiter = 0;
+  std::string charset, coordsys, transform;
+  if (!(reader.ReadU64(version) && reader.ReadStr(charset) && reader.ReadU64(delimiter) &&
+        reader.ReadStr(coordsys) && reader.ReadStr(transform))) {
+    return false;
+  }
+  header = MifHeader();
+  header.setVersion(static_cast<uint32_t>(version));
+  header.setCharset(charset);
+  header.setDelimiter(static_cast<char>(delimiter));
+  header.setCoordsys(coordsys);
+  header.setTransform(transform);
+  for (std::vector<size_t>* vec : {&header.getUniqueVec(), &header.getIndexVec()}) {
+    uint64_t size = 0;
+    if (!reader.ReadU64(size)) {
+      return false;
+    }
+    vec->clear();
+    for (uint64_t i = 0; i < size; ++i) {
+      uint64_t v = 0;
+      if (!reader.ReadU64(v)) {
+        return false;
+      }
+      vec->push_back(v);
+    }
+  }
+  uint64_t num_columns = 0;
+  if (!reader.ReadU64(num_columns)) {
+    return false;
+  }
+  for (uint64_t i = 0; i < num_columns; ++i) {
+    std::string name, type;
+    if (!(reader.ReadStr(name) && reader.ReadStr(type) && header.addColumn(name, type))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * 按属性表的列将元素属性转换为列式存储, 取值与写出MID时一致
+ * @param elements 元素列表, 关联列式属性表的元素直接读取表中的值而不物化
+ * @param table 由MIF头创建的属性表, 返回时追加了各元素的属性
+ */
+static void CollectAttrs(const std::vector<std::shared_ptr<MifElement>>& elements,
+                         AttrTable& table) {
+  const ColumnSchema& schema = table.schema();
+  std::vector<const AttrValue*> values(schema.size());
+  std::vector<AttrValue> table_values(schema.size());
+  const AttrTable* mapped_table = nullptr;
+  std::vector<int32_t> table_cols(schema.size());  // 各列在元素属性表中的下标
+  table.reserve(elements.size());
+  for (const auto& elem : elements) {
+    const AttrTable* src = elem->getAttrTable().get();
+    if (src != nullptr) {
+      if (src != mapped_table) {
+        mapped_table = src;
+        for (size_t i = 0; i < schema.size(); ++i) {
+          table_cols[i] = src->schema().findColumn(schema[i].name);
+        }
+      }
+      for (size_t i = 0; i < schema.size(); ++i) {
+        values[i] = nullptr;
+        if (table_cols[i] >= 0) {
+          src->getValue(table_cols[i], elem->getAttrRow(), table_values[i]);
+          values[i] = &table_values[i];
+        }
+      }
+    } else {
+      const AttrMap& attrs = elem->getAttrsMap();
+      for (size_t i = 0; i < schema.size(); ++i) {
+        auto it = attrs.find(schema[i].name);
+        values[i] = (it == attrs.end()) ? nullptr : &it->second;
+      }
+    }
+    table.appendValues(values);
+  }
+}
+
+int WriteBinaryCache(Mif& mif, const std::string& layer_path) {
+  std::string path = layer_path + "." + kBinaryCacheExtension;
+  const auto& elements = mif.elements();
+  GeoArena geos;
+  for (size_t i = 0; i < elements.size(); ++i) {
+    if (elements[i] == nullptr) {
+      LOG_ERROR << "cache geometry of element[" << i << "] failed" << std::endl;
+      return -1;
+    }
+    // 尚未构造的几何对象直接复制坐标区中的坐标
+    std::shared_ptr<const GeoArena> arena;
+    size_t index = 0;
+    if (elements[i]->getLazyGeo(arena, index)) {
+      geos.append(*arena, index);
+    } else if (!geos.append(elements[i]->getGeo().get())) {
+      LOG_ERROR << "cache geometry of element[" << i << "] failed" << std::endl;
+      return -1;
+    }
+  }
+  AttrTable table(mif.header());
+  CollectAttrs(elements, table);
+
+  std::string tmp_path = path + ".tmp";
+  std::ofstream ofs(tmp_path.c_str(), std::ios_base::out | std::ios_base::binary);
+  if (!ofs.is_open()) {
+    LOG_ERROR << "open '" << tmp_path << "' failed" << std::endl;
+    return -1;
+  }
+  CacheFileHeader header;
+  memset(&header, 0, sizeof(header));
+  ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));  // 写完后回填
+
+  CacheWriter writer(ofs);
+  std::string meta = SerializeHeader(mif.header());
+  writer.WriteU64(meta.size());
+  writer.WriteArray(meta.data(), meta.size());
+  writer.WriteArray(geos.getTypes());
+  writer.WriteArray(geos.getElemParts());
+  writer.WriteArray(geos.getPartRings());
+  writer.WriteArray(geos.getRingCoords());
+  writer.WriteArray(geos.getCoords());
+  const ColumnSchema& schema = table.schema();
+  for (size_t col = 0; col < schema.size(); ++col) {
+    writer.WriteU64(static_cast<uint64_t>(schema[col].type));
+    if (schema[col].type == ColType::kInt) {
+      writer.WriteArray(table.getInts(col));
+    } else if (schema[col].type == ColType::kDouble) {
+      writer.WriteArray(table.getDoubles(col));
+    } else {
+      const StrDict& dict = table.getDict(col);
+      writer.WriteArray(table.getCodes(col));
+      writer.WriteU64(dict.size());
+      writer.WriteArray(dict.getOffsets());
+      writer.WriteArray(dict.getArena().data(), dict.getArena().size());
+    }
+  }
+
+  memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+  header.version = kCacheVersion;
+  header.byte_order = kByteOrderMark;
+  header.file_size = sizeof(header) + writer.size();
+  header.checksum = writer.checksum();
+  header.num_elements = elements.size();
+  header.num_parts = geos.getPartRings().size() - 1;
+  header.num_rings = geos.getRingCoords().size() - 1;
+  header.num_coords = geos.getCoords().size() / 2;
+  header.has_source = StatLayerFiles(layer_path, header.mif_stamp, header.mid_stamp) == 0;
+  ofs.seekp(0);
+  ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  ofs.close();
+  if (ofs.fail()) {
+    LOG_ERROR << "write '" << tmp_path << "' failed" << std::endl;
+    std::remove(tmp_path.c_str());
+    return -1;
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG_ERROR << "rename '" << tmp_path << "' to '" << path << "' failed" << std::endl;
+    std::remove(tmp_path.c_str());
+    return -1;
+  }
+  return 0;
+}
+
+//! 偏移数组首个为0、非递减且末尾为total
+static bool CheckOffsets(const uint64_t* offsets, uint64_t count, uint64_t total) {
+  if (offsets[0] != 0 || offsets[count] != total) {
+    return false;
+  }
+  for (uint64_t i = 0; i < count; ++i) {
+    if (offsets[i] > offsets[i + 1]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//! 读取各列属性
+static bool ReadAttrColumns(CacheReader& reader, uint64_t num_elements, AttrTable& table) {
+  const ColumnSchema& schema = table.schema();
+  for (size_t col = 0; col < schema.size(); ++col) {
+    uint64_t type = 0;
+    if (!reader.ReadU64(type) || type != static_cast<uint64_t>(schema[col].type)) {
+      return false;
+    }
+    if (schema[col].type == ColType::kInt) {
+      const int32_t* values = reader.ReadArray<int32_t>(num_elements);
+      if (values == nullptr) {
+        return false;
+      }
+      table.assignInts(col, values, num_elements);
+    } else if (schema[col].type == ColType::kDouble) {
+      const double* values = reader.ReadArray<double>(num_elements);
+      if (values == nullptr) {
+        return false;
+      }
+      table.assignDoubles(col, values, num_elements);
+    } else {
+      const uint32_t* codes = reader.ReadArray<uint32_t>(num_elements);
+      uint64_t dict_size = 0;
+      if (codes == nullptr || !reader.ReadU64(dict_size) || dict_size >= UINT32_MAX) {
+        return false;
+      }
+      const uint64_t* offsets = reader.ReadArray<uint64_t>(dict_size + 1);
+      if (offsets == nullptr || !CheckOffsets(offsets, dict_size, offsets[dict_size])) {
+        return false;
+      }
+      const char* arena = reader.ReadArray<char>(offsets[dict_size]);
+      if (arena == nullptr) {
+        return false;
+      }
+      for (uint64_t row = 0; row < num_elements; ++row) {
+        if (codes[row] >= dict_size) {
+          return false;
+        }
+      }
+      StrDict dict;
+      dict.Assign(arena, offsets, dict_size);
+      table.assignStrs(col, codes, num_elements, std::move(dict));
+    }
+  }
+  return true;
+}
+
+int ReadBinaryCache(const std::string& layer_path, const LoadOptions& options, Mif& res) {
+  std::string path = layer_path + "." + kBinaryCacheExtension;
+  MappedFile file;
+  std::string buffer;
+  const char* data = nullptr;
+  size_t size = 0;
+  if (file.Open(path)) {
+    data = file.data();
+    size = file.size();
+  } else {
+    std::ifstream ifs(path.c_str(), std::ios_base::in | std::ios_base::binary);
+    if (!ifs.is_open()) {
+      LOG_ERROR << "binary cache '" << path << "' not found" << std::endl;
+      return -1;
+    }
+    buffer.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    data = buffer.data();
+    size = buffer.size();
+  }
+
+  CacheFileHeader header;
+  if (size < sizeof(header)) {
+    LOG_ERROR << "binary cache '" << path << "' is truncated" << std::endl;
+    return -1;
+  }
+  memcpy(&header, data, sizeof(header));
+  if (memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 ||
+      header.version != kCacheVersion || header.byte_order != kByteOrderMark) {
+    LOG_ERROR << "binary cache '" << path << "' has incompatible format" << std::endl;
+    return -1;
+  }
+  Checksum checksum;
+  checksum.Update(data + sizeof(header), size - sizeof(header));
+  if (header.file_size != size || checksum.Final() != header.checksum) {
+    LOG_ERROR << "binary cache '" << path << "' is corrupted" << std::endl;
+    return -1;
+  }
+  FileStamp mif_stamp, mid_stamp;
+  if (header.has_source &&
+      (StatLayerFiles(layer_path, mif_stamp, mid_stamp) != 0 ||
+       !(mif_stamp == header.mif_stamp && mid_stamp == header.mid_stamp))) {
+    LOG_ERROR << "binary cache '" << path << "' is out of date" << std::endl;
+    return -1;
+  }
+
+  // 校验和通过后仍检查各数组的边界与偏移, 避免格式错误导致越界访问
+  CacheReader reader(data + sizeof(header), data + size);
+  uint64_t meta_size = 0;
+  const char* meta = nullptr;
+  if (!reader.ReadU64(meta_size) || (meta = reader.ReadArray<char>(meta_size)) == nullptr) {
+    LOG_ERROR << "binary cache '" << path << "' is corrupted" << std::endl;
+    return -1;
+  }
+  CacheReader meta_reader(meta, meta + meta_size);
+  if (!ParseHeader(meta_reader, res.header())) {
+    LOG_ERROR << "parse header of binary cache '" << path << "' failed" << std::endl;
+    return -1;
+  }
+
+  uint64_t num_elements = header.num_elements;
+  if (num_elements > size || header.num_parts > size || header.num_rings > size ||
+      header.num_coords > size) {
+    LOG_ERROR << "binary cache '" << path << "' is corrupted" << std::endl;
+    return -1;
+  }
+  const int32_t* types = reader.ReadArray<int32_t>(num_elements);
+  const uint64_t* elem_parts = reader.ReadArray<uint64_t>(num_elements + 1);
+  const uint64_t* part_rings = reader.ReadArray<uint64_t>(header.num_parts + 1);
+  const uint64_t* ring_coords = reader.ReadArray<uint64_t>(header.num_rings + 1);
+  const double* coords = reader.ReadArray<double>(header.num_coords * 2);
+  auto arena = std::make_shared<GeoArena>();
+  if (types == nullptr || elem_parts == nullptr || part_rings == nullptr ||
+      ring_coords == nullptr || coords == nullptr ||
+      !arena->assign(std::vector<int32_t>(types, types + num_elements),
+                     std::vector<uint64_t>(elem_parts, elem_parts + num_elements + 1),
+                     std::vector<uint64_t>(part_rings, part_rings + header.num_parts + 1),
+                     std::vector<uint64_t>(ring_coords, ring_coords + header.num_rings + 1),
+                     std::vector<double>(coords, coords + header.num_coords * 2))) {
+    LOG_ERROR << "geometry of binary cache '" << path << "' is corrupted" << std::endl;
+    return -1;
+  }
+  auto table = std::make_shared<AttrTable>(res.header());
+  if (!ReadAttrColumns(reader, num_elements, *table)) {
+    LOG_ERROR << "attributes of binary cache '" << path << "' is corrupted" << std::endl;
+    return -1;
+  }
+
+  // 按元素分块并行构造几何对象与物化属性; 延迟构造时元素直接关联坐标区
+  std::shared_ptr<const AttrTable> shared_table = std::move(table);
+  bool lazy_geo = options.lazy_geo && !options.mid_only;
+  auto& elements = res.elements();
+  elements.assign(num_elements, nullptr);
+  size_t num_threads = parallel::ResolveThreads(options.num_threads);
+  size_t num_chunks = std::min<size_t>(num_elements, num_threads * kChunksPerThread);
+  std::atomic<bool> failed(false);
+  parallel::ParallelFor(num_chunks, num_threads, [&](size_t k) {
+    // GEOS工厂的引用计数非线程安全, 每个任务块使用独立工厂
+    PrecisionModel pm(GMIF_COORD_PRECISION, 0, 0);
+    auto geos_factory = GeometryFactory::create(&pm, -1);
+    size_t end = num_elements * (k + 1) / num_chunks;
+    for (size_t i = num_elements * k / num_chunks; i < end && !failed; ++i) {
+      auto elem = std::make_shared<MifElement>();
+      elem->setAttrRow(shared_table, i);
+      if (!options.columnar_attrs) {
+        elem->mutableAttrsMap();  // 物化为AttrMap
+      }
+      if (lazy_geo && arena->getType(i) >= 0) {
+        elem->setLazyGeo(arena, i);
+      } else if (!options.mid_only) {
+        GeometryPtr geo;
+        if (arena->toGeometry(i, geo, geos_factory.get()) != 0) {
+          LOG_ERROR << "build geometry of element[" << i << "] failed" << std::endl;
+          failed = true;
+          return;
+        }
+        elem->setGeo(geo);
+      }
+      elements[i] = elem;
+    }
+  });
+  if (failed) {
+    elements.clear();
+    return -1;
+  }
+  if (lazy_geo) {
+    res.setArena(arena);
+  }
+  return 0;
+}
+
+}  // namespace io
+}  // namespace gmif
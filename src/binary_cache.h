@@ -0,0 +1,43 @@
+#ifndef GMIF_SRC_BINARY_CACHE_H_
+#define GMIF_SRC_BINARY_CACHE_H_
+
+#include "gmif/gmif.h"
+#include <string>
+
+namespace gmif {
+namespace io {
+
+//! 二进制缓存文件扩展名
+extern const char* const kBinaryCacheExtension;
+
+/**
+ * @brief 写入二进制缓存文件layer_path.gmifb
+ *
+ * 文件格式(本机字节序, 各段按8字节对齐): 文件头(魔数、版本、字节序标记、文件大小、校验和、
+ * 元素/部件/环/坐标数、源图层MIF/MID时间戳), 其后依次为:
+ *   MIF头: 长度与序列化内容
+ *   几何: 各元素的几何类型(int32, 无几何为-1), 元素->部件、部件->环、环->坐标的偏移数组
+ *        (uint64, 各比数量多1), 扁平坐标数组(x, y交替的double)
+ *   属性: 按列存放, 每列为类型标记及取值数组; 字符串列为各行字典编码与字典(偏移数组+内容)
+ * 校验和覆盖文件头之后的全部内容. 写入临时文件后重命名, 不会留下不完整的缓存.
+ * 图层文件layer_path.[mif/mid]存在时记录其时间戳, 读取时据此判断缓存是否过期.
+ * @param mif Mif对象, 关联列式属性表的元素不会被物化
+ * @param layer_path 图层路径, 不带后缀
+ * @return 成功返回0, 失败(含不支持的几何类型)返回-1
+ */
+int WriteBinaryCache(Mif& mif, const std::string& layer_path);
+
+/**
+ * @brief 读取二进制缓存文件layer_path.gmifb, 可映射时内存映射, 否则整体读入内存;
+ * 各数组整块复制到坐标区与列式属性表, 返回的Mif不依赖缓存文件
+ * @param layer_path 图层路径, 不带后缀
+ * @param options 加载选项, 支持mid_only、num_threads、columnar_attrs与lazy_geo
+ * @param res 返回的Mif对象
+ * @return 成功返回0, 文件不存在、版本或字节序不符、校验失败、记录的图层文件已变化或不存在时返回-1
+ */
+int ReadBinaryCache(const std::string& layer_path, const LoadOptions& options, Mif& res);
+
+}  // namespace io
+}  // namespace gmif
+
+#endif  // GMIF_SRC_BINARY_CACHE_H_
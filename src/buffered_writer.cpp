@@ -0,0 +1,252 @@
+#include "buffered_writer.h"
+#include <fcntl.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gmif {
+namespace io {
+
+//! 最小缓冲区大小, 保证单个数值可直接格式化到缓冲区
+static const size_t kMinBufferSize = 4096;
+
+//! 后台写出状态: 调用线程提交写满的缓冲区, I/O线程按提交顺序写入文件后归还为空闲缓冲区
+struct BufferedWriter::Async {
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::deque<std::pair<std::unique_ptr<char[]>, size_t>> pending;
+  std::vector<std::unique_ptr<char[]>> free_bufs;
+  size_t queue_depth = 1;
+  size_t in_flight = 0;  // 等待及正在写出的缓冲区数
+  bool stop = false;
+};
+
+BufferedWriter::BufferedWriter()
+    : file_(nullptr),
+      capacity_(0),
+      size_(0),
+      trim_zeros_(false),
+      drop_cache_(false),
+      failed_(false),
+      file_size_(0),
+      dropped_size_(0) {}
+
+BufferedWriter::~BufferedWriter() {
+  Close();
+}
+
+bool BufferedWriter::Open(const std::string& path, size_t buffer_size, bool trim_zeros) {
+  Close();
+  // 与此前的std::ofstream一致以文本模式打开
+  file_ = std::fopen(path.c_str(), "w");
+  if (file_ == nullptr) {
+    LOG_ERROR << "open '" << path << "' for writing failed" << std::endl;
+    return false;
+  }
+  setvbuf(file_, nullptr, _IONBF, 0);  // 已自行缓冲
+  capacity_ = std::max(buffer_size, kMinBufferSize);
+  buf_.reset(new char[capacity_]);
+  size_ = 0;
+  trim_zeros_ = trim_zeros;
+  failed_ = false;
+  file_size_ = 0;
+  dropped_size_ = 0;
+  return true;
+}
+
+void BufferedWriter::StartAsync(size_t queue_depth) {
+  if (file_ == nullptr || async_ != nullptr) {
+    return;
+  }
+  async_.reset(new Async);
+  async_->queue_depth = std::max<size_t>(queue_depth, 1);
+  async_->thread = std::thread([this]() {
+    Async& async = *async_;
+    std::unique_lock<std::mutex> lock(async.mutex);
+    while (true) {
+      async.cond.wait(lock, [&]() { return async.stop || !async.pending.empty(); });
+      if (async.pending.empty()) {
+        return;  // 已停止且全部写出
+      }
+      auto block = std::move(async.pending.front());
+      async.pending.pop_front();
+      lock.unlock();
+      WriteBlock(block.first.get(), block.second);
+      lock.lock();
+      async.free_bufs.push_back(std::move(block.first));
+      --async.in_flight;
+      async.cond.notify_all();
+    }
+  });
+}
+
+bool BufferedWriter::setCompression(Compression compression, int level) {
+  compressor_.reset();
+  if (compression == Compression::kNone) {
+    return true;
+  }
+  std::unique_ptr<Compressor> compressor(new Compressor);
+  if (!compressor->Init(compression, level,
+                        [this](const char* data, size_t size) { return WriteFile(data, size); })) {
+    return false;
+  }
+  compressor_ = std::move(compressor);
+  return true;
+}
+
+void BufferedWriter::OpenMemory(size_t buffer_size, bool trim_zeros) {
+  Close();
+  capacity_ = std::max(buffer_size, kMinBufferSize);
+  buf_.reset(new char[capacity_]);
+  size_ = 0;
+  trim_zeros_ = trim_zeros;
+  failed_ = false;
+}
+
+bool BufferedWriter::Close() {
+  if (file_ != nullptr) {
+    Flush();
+    if (async_ != nullptr) {
+      {
+        std::lock_guard<std::mutex> lock(async_->mutex);
+        async_->stop = true;
+      }
+      async_->cond.notify_all();
+      async_->thread.join();
+      async_.reset();
+    }
+    if (compressor_ != nullptr) {
+      if (!failed_ && !compressor_->Finish()) {
+        failed_ = true;
+      }
+      compressor_.reset();
+    }
+    if (std::fclose(file_) != 0) {
+      failed_ = true;
+    }
+    file_ = nullptr;
+  }
+  buf_.reset();
+  capacity_ = 0;
+  size_ = 0;
+  return !failed_;
+}
+
+bool BufferedWriter::Flush() {
+  if (file_ == nullptr) {
+    return !failed_;
+  }
+  Spill();
+  if (async_ != nullptr) {
+    std::unique_lock<std::mutex> lock(async_->mutex);
+    async_->cond.wait(lock, [&]() { return async_->in_flight == 0; });
+  }
+  return !failed_;
+}
+
+void BufferedWriter::Spill() {
+  if (size_ == 0) {
+    return;
+  }
+  if (async_ == nullptr) {
+    WriteBlock(buf_.get(), size_);
+    size_ = 0;  // 失败后丢弃数据, 保证后续写入有可用空间
+    return;
+  }
+  std::unique_lock<std::mutex> lock(async_->mutex);
+  async_->cond.wait(lock, [&]() { return async_->in_flight < async_->queue_depth; });
+  async_->pending.emplace_back(std::move(buf_), size_);
+  ++async_->in_flight;
+  if (async_->free_bufs.empty()) {
+    buf_.reset(new char[capacity_]);  // 缓冲区按需分配, 总数不超过queue_depth + 1
+  } else {
+    buf_ = std::move(async_->free_bufs.back());
+    async_->free_bufs.pop_back();
+  }
+  size_ = 0;
+  async_->cond.notify_all();
+}
+
+void BufferedWriter::WriteBlock(const char* data, size_t size) {
+  if (failed_) {
+    return;
+  }
+  if (compressor_ != nullptr ? !compressor_->Write(data, size) : !WriteFile(data, size)) {
+    failed_ = true;
+  }
+}
+
+bool BufferedWriter::WriteFile(const char* data, size_t size) {
+  if (std::fwrite(data, 1, size, file_) != size) {
+    return false;
+  }
+#ifdef POSIX_FADV_DONTNEED
+  if (drop_cache_ && file_size_ > dropped_size_) {
+    // 只能丢弃已回写的页, 每次提示上一个数据块的范围, 给回写留出一个数据块的时间
+    posix_fadvise(fileno(file_), dropped_size_, file_size_ - dropped_size_, POSIX_FADV_DONTNEED);
+    dropped_size_ = file_size_;
+  }
+#endif
+  file_size_ += size;
+  return true;
+}
+
+void BufferedWriter::MakeRoom(size_t size) {
+  if (file_ != nullptr) {
+    Spill();
+    return;
+  }
+  size_t capacity = std::max(capacity_ * 2, size_ + size);
+  std::unique_ptr<char[]> buf(new char[capacity]);
+  memcpy(buf.get(), buf_.get(), size_);
+  buf_ = std::move(buf);
+  capacity_ = capacity;
+}
+
+void BufferedWriter::WriteLarge(utils::StrView str) {
+  if (file_ == nullptr) {
+    MakeRoom(str.size());
+    memcpy(buf_.get() + size_, str.data(), str.size());
+    size_ += str.size();
+    return;
+  }
+  Spill();
+  if (str.size() > capacity_ && async_ == nullptr) {
+    WriteBlock(str.data(), str.size());
+    return;
+  }
+  // 后台写出时文件只由I/O线程访问, 按缓冲区大小分段提交
+  const char* p = str.data();
+  size_t left = str.size();
+  while (left > capacity_) {
+    memcpy(buf_.get(), p, capacity_);
+    size_ = capacity_;
+    Spill();
+    p += capacity_;
+    left -= capacity_;
+  }
+  memcpy(buf_.get(), p, left);
+  size_ = left;
+}
+
+void BufferedWriter::WriteFixed(double value, int precision) {
+  Reserve(utils::kFixedBufferSize);
+  char* p = buf_.get() + size_;
+  size_t len = utils::FormatFixed(value, precision, p);
+  if (trim_zeros_ && precision > 0 && memchr(p, '.', len) != nullptr) {
+    while (p[len - 1] == '0') {
+      --len;
+    }
+    if (p[len - 1] == '.') {
+      --len;
+    }
+  }
+  size_ += len;
+}
+
+}  // namespace io
+}  // namespace gmif
@@ -0,0 +1,169 @@
+#ifndef GMIF_SRC_BUFFERED_WRITER_H_
+#define GMIF_SRC_BUFFERED_WRITER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include "compression.h"
+#include "utils.h"
+
+namespace gmif {
+namespace io {
+
+/**
+ * @brief 带大块缓冲区的文本写出器, 整数与定点小数直接格式化到缓冲区, 不经过iostream与locale
+ *
+ * 文件模式下缓冲区满时整块写入文件, 写入失败后后续数据被丢弃, 由Close返回失败;
+ * 启用后台写出后, 写满的缓冲区交给后台I/O线程写入, 格式化与磁盘写入重叠进行;
+ * 内存模式下缓冲区不足时扩容, 数据保留在缓冲区中由data()/size()读取.
+ */
+class BufferedWriter {
+ public:
+  static const size_t kDefaultBufferSize = 1 << 20;
+
+  BufferedWriter();
+  ~BufferedWriter();
+
+  BufferedWriter(const BufferedWriter&) = delete;
+  BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+  /**
+   * @brief 创建文件, 已存在时截断
+   * @param path 文件路径
+   * @param buffer_size 缓冲区大小, 小于4KB时按4KB处理
+   * @param trim_zeros 是否去除定点小数末尾的0, 关闭时与printf("%.*f")逐字节一致
+   * @return 成功返回true, 失败返回false
+   */
+  bool Open(const std::string& path,
+            size_t buffer_size = kDefaultBufferSize,
+            bool trim_zeros = false);
+
+  /**
+   * @brief 启用后台写出, 需在Open成功后调用; 缓冲区满时交给后台I/O线程写入文件,
+   * 调用线程换用空闲缓冲区继续写入
+   * @param queue_depth 等待及正在写出的缓冲区数上限, 达到上限时调用线程等待, 小于1时按1处理
+   */
+  void StartAsync(size_t queue_depth);
+
+  /**
+   * @brief 设置是否在写出后提示内核丢弃已写出数据的页缓存(posix_fadvise), 避免大量导出挤占缓存;
+   * 仅为提示, 不支持的平台忽略
+   */
+  void setDropCache(bool drop_cache) { drop_cache_ = drop_cache; }
+
+  /**
+   * @brief 设置输出压缩格式, 需在Open成功后、写入数据前调用; 压缩数据在Close时写完
+   * @param compression 压缩格式
+   * @param level 压缩级别, 0表示使用压缩库的默认级别
+   * @return 成功返回true, 不支持该压缩格式返回false
+   */
+  bool setCompression(Compression compression, int level);
+
+  /**
+   * @brief 以内存模式打开, 数据只写入缓冲区
+   * @param buffer_size 初始缓冲区大小, 小于4KB时按4KB处理
+   * @param trim_zeros 是否去除定点小数末尾的0
+   */
+  void OpenMemory(size_t buffer_size = kDefaultBufferSize, bool trim_zeros = false);
+
+  /**
+   * @brief 写出缓冲区并关闭文件, 后台写出时等待全部数据写入并结束I/O线程; 内存模式下释放缓冲区
+   * @return 全部数据写入成功返回true, 失败返回false
+   */
+  bool Close();
+
+  //! 是否已打开
+  bool isOpen() const { return buf_ != nullptr; }
+
+  //! 写出缓冲区中的数据, 后台写出时等待已提交的数据全部写入; 失败返回false, 内存模式下不做处理
+  bool Flush();
+
+  //! 是否发生过写入失败
+  bool fail() const { return failed_; }
+
+  //! 缓冲区中的数据, 内存模式下为已写入的全部数据
+  const char* data() const { return buf_.get(); }
+  size_t size() const { return size_; }
+
+  //! 清空缓冲区中的数据, 保留缓冲区
+  void Clear() { size_ = 0; }
+
+  //! 写入字节
+  void Write(utils::StrView str) {
+    if (str.size() > capacity_ - size_) {
+      WriteLarge(str);
+      return;
+    }
+    memcpy(buf_.get() + size_, str.data(), str.size());
+    size_ += str.size();
+  }
+
+  //! 写入单个字符
+  void Put(char c) {
+    if (size_ == capacity_) {
+      MakeRoom(1);
+    }
+    buf_[size_++] = c;
+  }
+
+  //! 写入十进制整数
+  void WriteInt(int64_t value) {
+    Reserve(kMaxIntSize);
+    size_ += utils::FormatInt(value, buf_.get() + size_);
+  }
+
+  /**
+   * @brief 按定点小数写入浮点数
+   * @param value 浮点数
+   * @param precision 小数位数, 需在[0, 17]内
+   */
+  void WriteFixed(double value, int precision);
+
+ private:
+  //! 整数格式化所需的空间
+  static const size_t kMaxIntSize = 24;
+
+  //! 保证缓冲区剩余空间不小于size
+  void Reserve(size_t size) {
+    if (size > capacity_ - size_) {
+      MakeRoom(size);
+    }
+  }
+
+  struct Async;
+
+  //! 剩余空间不足size时, 文件模式下写出缓冲区, 内存模式下扩容
+  void MakeRoom(size_t size);
+
+  //! 写出缓冲区中的数据, 后台写出时提交给I/O线程并换用空闲缓冲区, 不等待写入完成
+  void Spill();
+
+  //! 将数据块写入文件, 设置压缩时先压缩; 后台写出时在I/O线程调用
+  void WriteBlock(const char* data, size_t size);
+
+  //! 将数据写入文件, 失败返回false
+  bool WriteFile(const char* data, size_t size);
+
+  //! 写入超过缓冲区剩余空间的数据
+  void WriteLarge(utils::StrView str);
+
+  FILE* file_;
+  std::unique_ptr<char[]> buf_;
+  size_t capacity_;
+  size_t size_;
+  bool trim_zeros_;
+  bool drop_cache_;
+  std::atomic<bool> failed_;
+  uint64_t file_size_;     // 已写入文件的字节数
+  uint64_t dropped_size_;  // 已提示丢弃页缓存的字节数
+  std::unique_ptr<Async> async_;
+  std::unique_ptr<Compressor> compressor_;
+};
+
+}  // namespace io
+}  // namespace gmif
+
+#endif  // GMIF_SRC_BUFFERED_WRITER_H_
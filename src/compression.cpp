@@ -0,0 +1,434 @@
+#include "compression.h"
+#include <cstring>
+#ifdef GMIF_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef GMIF_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#include "utils.h"
+
+namespace gmif {
+namespace io {
+
+//! 每次从压缩文件读取的字节数
+static const size_t kInputSize = 1 << 18;
+//! 压缩输出缓冲区大小
+static const size_t kOutputSize = 1 << 18;
+
+const char* CompressionExtension(Compression compression) {
+  switch (compression) {
+    case Compression::kGzip:
+      return ".gz";
+    case Compression::kZstd:
+      return ".zst";
+    default:
+      return "";
+  }
+}
+
+const char* CompressionName(Compression compression) {
+  switch (compression) {
+    case Compression::kGzip:
+      return "gzip";
+    case Compression::kZstd:
+      return "zstd";
+    default:
+      return "none";
+  }
+}
+
+bool CompressionSupported(Compression compression) {
+  switch (compression) {
+    case Compression::kNone:
+      return true;
+#ifdef GMIF_HAVE_ZLIB
+    case Compression::kGzip:
+      return true;
+#endif
+#ifdef GMIF_HAVE_ZSTD
+    case Compression::kZstd:
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+//! 解压状态机, 就地推进输入与输出位置
+class InflateCodec {
+ public:
+  virtual ~InflateCodec() {}
+
+  //! 解压一段数据, 返回0表示需继续, 1表示当前帧结束, -1表示数据错误
+  virtual int Run(const char*& in, size_t& in_size, char*& out, size_t& out_size) = 0;
+
+  //! 帧结束后开始解压下一帧
+  virtual void Reset() = 0;
+};
+
+//! 压缩状态机, 就地推进输入与输出位置
+class DeflateCodec {
+ public:
+  virtual ~DeflateCodec() {}
+
+  //! 压缩一段数据, 返回0表示需继续, 1表示finish时压缩流已结束, -1表示失败
+  virtual int Run(const char*& in, size_t& in_size, char*& out, size_t& out_size, bool finish) = 0;
+};
+
+#ifdef GMIF_HAVE_ZLIB
+class GzipInflate : public InflateCodec {
+ public:
+  GzipInflate() {
+    memset(&strm_, 0, sizeof(strm_));
+    ok_ = (inflateInit2(&strm_, 15 + 32) == Z_OK);  // 自动识别gzip与zlib头
+  }
+  ~GzipInflate() override { inflateEnd(&strm_); }
+
+  int Run(const char*& in, size_t& in_size, char*& out, size_t& out_size) override {
+    if (!ok_) {
+      return -1;
+    }
+    strm_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in));
+    strm_.avail_in = static_cast<uInt>(in_size);
+    strm_.next_out = reinterpret_cast<Bytef*>(out);
+    strm_.avail_out = static_cast<uInt>(out_size);
+    int ret = inflate(&strm_, Z_NO_FLUSH);
+    in = reinterpret_cast<const char*>(strm_.next_in);
+    in_size = strm_.avail_in;
+    out = reinterpret_cast<char*>(strm_.next_out);
+    out_size = strm_.avail_out;
+    if (ret == Z_STREAM_END) {
+      return 1;
+    }
+    return (ret == Z_OK || ret == Z_BUF_ERROR) ? 0 : -1;
+  }
+
+  void Reset() override { inflateReset(&strm_); }
+
+ private:
+  z_stream strm_;
+  bool ok_;
+};
+
+class GzipDeflate : public DeflateCodec {
+ public:
+  explicit GzipDeflate(int level) {
+    memset(&strm_, 0, sizeof(strm_));
+    ok_ = (deflateInit2(&strm_, level == 0 ? Z_DEFAULT_COMPRESSION : level, Z_DEFLATED, 15 + 16, 8,
+                        Z_DEFAULT_STRATEGY) == Z_OK);
+  }
+  ~GzipDeflate() override { deflateEnd(&strm_); }
+
+  bool ok() const { return ok_; }
+
+  int Run(const char*& in, size_t& in_size, char*& out, size_t& out_size, bool finish) override {
+    strm_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in));
+    strm_.avail_in = static_cast<uInt>(in_size);
+    strm_.next_out = reinterpret_cast<Bytef*>(out);
+    strm_.avail_out = static_cast<uInt>(out_size);
+    int ret = deflate(&strm_, finish ? Z_FINISH : Z_NO_FLUSH);
+    in = reinterpret_cast<const char*>(strm_.next_in);
+    in_size = strm_.avail_in;
+    out = reinterpret_cast<char*>(strm_.next_out);
+    out_size = strm_.avail_out;
+    if (ret == Z_STREAM_END) {
+      return 1;
+    }
+    return (ret == Z_OK || ret == Z_BUF_ERROR) ? 0 : -1;
+  }
+
+ private:
+  z_stream strm_;
+  bool ok_;
+};
+#endif
+
+#ifdef GMIF_HAVE_ZSTD
+class ZstdInflate : public InflateCodec {
+ public:
+  ZstdInflate() : dstream_(ZSTD_createDStream()) {
+    if (dstream_ != nullptr) {
+      ZSTD_initDStream(dstream_);
+    }
+  }
+  ~ZstdInflate() override { ZSTD_freeDStream(dstream_); }
+
+  int Run(const char*& in, size_t& in_size, char*& out, size_t& out_size) override {
+    if (dstream_ == nullptr) {
+      return -1;
+    }
+    ZSTD_inBuffer input = {in, in_size, 0};
+    ZSTD_outBuffer output = {out, out_size, 0};
+    size_t ret = ZSTD_decompressStream(dstream_, &output, &input);
+    in += input.pos;
+    in_size -= input.pos;
+    out += output.pos;
+    out_size -= output.pos;
+    if (ZSTD_isError(ret)) {
+      return -1;
+    }
+    return ret == 0 ? 1 : 0;  // 返回0表示帧已解压并全部输出
+  }
+
+  void Reset() override {}  // 帧结束后自动开始下一帧
+
+ private:
+  ZSTD_DStream* dstream_;
+};
+
+class ZstdDeflate : public DeflateCodec {
+ public:
+  explicit ZstdDeflate(int level) : cctx_(ZSTD_createCCtx()) {
+    if (cctx_ != nullptr && level != 0) {
+      ZSTD_CCtx_setParameter(cctx_, ZSTD_c_compressionLevel, level);
+    }
+  }
+  ~ZstdDeflate() override { ZSTD_freeCCtx(cctx_); }
+
+  bool ok() const { return cctx_ != nullptr; }
+
+  int Run(const char*& in, size_t& in_size, char*& out, size_t& out_size, bool finish) override {
+    ZSTD_inBuffer input = {in, in_size, 0};
+    ZSTD_outBuffer output = {out, out_size, 0};
+    size_t ret =
+        ZSTD_compressStream2(cctx_, &output, &input, finish ? ZSTD_e_end : ZSTD_e_continue);
+    in += input.pos;
+    in_size -= input.pos;
+    out += output.pos;
+    out_size -= output.pos;
+    if (ZSTD_isError(ret)) {
+      return -1;
+    }
+    return (finish && ret == 0) ? 1 : 0;
+  }
+
+ private:
+  ZSTD_CCtx* cctx_;
+};
+#endif
+
+static std::unique_ptr<InflateCodec> CreateInflate(Compression compression) {
+#ifdef GMIF_HAVE_ZLIB
+  if (compression == Compression::kGzip) {
+    return std::unique_ptr<InflateCodec>(new GzipInflate);
+  }
+#endif
+#ifdef GMIF_HAVE_ZSTD
+  if (compression == Compression::kZstd) {
+    return std::unique_ptr<InflateCodec>(new ZstdInflate);
+  }
+#endif
+  return nullptr;
+}
+
+static std::unique_ptr<DeflateCodec> CreateDeflate(Compression compression, int level) {
+#ifdef GMIF_HAVE_ZLIB
+  if (compression == Compression::kGzip) {
+    std::unique_ptr<GzipDeflate> codec(new GzipDeflate(level));
+    return codec->ok() ? std::move(codec) : nullptr;
+  }
+#endif
+#ifdef GMIF_HAVE_ZSTD
+  if (compression == Compression::kZstd) {
+    std::unique_ptr<ZstdDeflate> codec(new ZstdDeflate(level));
+    return codec->ok() ? std::move(codec) : nullptr;
+  }
+#endif
+  (void)level;
+  return nullptr;
+}
+
+Decompressor::Decompressor()
+    : file_(nullptr), chunk_size_(0), current_pos_(0), done_(true), stop_(false), failed_(false) {}
+
+Decompressor::~Decompressor() {
+  Close();
+}
+
+bool Decompressor::Open(const std::string& path, Compression compression, size_t chunk_size) {
+  Close();
+  file_ = std::fopen(path.c_str(), "rb");
+  if (file_ == nullptr) {
+    return false;
+  }
+  codec_ = CreateInflate(compression);
+  if (codec_ == nullptr) {
+    LOG_ERROR << "'" << path << "' is " << CompressionName(compression)
+              << " compressed, but gmif is built without " << CompressionName(compression)
+              << " support" << std::endl;
+    Close();
+    return false;
+  }
+  chunk_size_ = chunk_size;
+  done_ = false;
+  stop_ = false;
+  failed_ = false;
+  thread_ = std::thread(&Decompressor::Run, this);
+  return true;
+}
+
+void Decompressor::Close() {
+  if (thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cond_.notify_all();
+    thread_.join();
+  }
+  if (file_ != nullptr) {
+    std::fclose(file_);
+    file_ = nullptr;
+  }
+  codec_.reset();
+  chunks_.clear();
+  free_chunks_.clear();
+  current_.clear();
+  current_pos_ = 0;
+  done_ = true;
+}
+
+size_t Decompressor::Read(char* buf, size_t size) {
+  size_t total = 0;
+  while (total < size) {
+    if (current_pos_ == current_.size()) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [&]() { return !chunks_.empty() || done_; });
+      if (chunks_.empty()) {
+        break;
+      }
+      free_chunks_.push_back(std::move(current_));
+      current_ = std::move(chunks_.front());
+      chunks_.pop_front();
+      current_pos_ = 0;
+      cond_.notify_all();
+    }
+    size_t n = std::min(size - total, current_.size() - current_pos_);
+    memcpy(buf + total, current_.data() + current_pos_, n);
+    current_pos_ += n;
+    total += n;
+  }
+  return total;
+}
+
+bool Decompressor::Push(std::vector<char>& chunk) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [&]() { return stop_ || chunks_.size() < kQueueDepth; });
+  if (stop_) {
+    return false;
+  }
+  chunks_.push_back(std::move(chunk));
+  if (free_chunks_.empty()) {
+    chunk = std::vector<char>();
+  } else {
+    chunk = std::move(free_chunks_.back());
+    free_chunks_.pop_back();
+  }
+  cond_.notify_all();
+  return true;
+}
+
+void Decompressor::Run() {
+  std::vector<char> input(kInputSize);
+  const char* in = input.data();
+  size_t in_size = 0;
+  bool input_eof = false;
+  bool in_frame = false;  // 当前帧已开始且未结束, 此时数据结束说明文件被截断
+  std::vector<char> chunk(chunk_size_);
+  size_t filled = 0;
+  while (true) {
+    if (in_size == 0 && !input_eof) {
+      in_size = std::fread(input.data(), 1, input.size(), file_);
+      in = input.data();
+      if (in_size == 0) {
+        input_eof = true;
+        if (std::ferror(file_)) {
+          failed_ = true;
+          break;
+        }
+      }
+    }
+    if (in_size == 0 && input_eof) {
+      if (in_frame) {
+        failed_ = true;
+      }
+      break;
+    }
+    char* out = chunk.data() + filled;
+    size_t out_size = chunk_size_ - filled;
+    size_t prev_in = in_size;
+    int status = codec_->Run(in, in_size, out, out_size);
+    if (status < 0 || (status == 0 && in_size == prev_in && out_size == chunk_size_ - filled &&
+                       in_size > 0 && out_size > 0)) {
+      failed_ = true;  // 数据错误或无法推进
+      break;
+    }
+    filled = chunk_size_ - out_size;
+    in_frame = (status == 0);
+    if (status == 1) {
+      codec_->Reset();
+    }
+    if (filled == chunk_size_) {
+      chunk.resize(filled);
+      if (!Push(chunk)) {
+        break;
+      }
+      chunk.resize(chunk_size_);
+      filled = 0;
+    }
+  }
+  if (filled > 0 && !failed_) {
+    chunk.resize(filled);
+    Push(chunk);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  done_ = true;
+  cond_.notify_all();
+}
+
+Compressor::Compressor() {}
+
+Compressor::~Compressor() {}
+
+bool Compressor::Init(Compression compression, int level, const Sink& sink) {
+  codec_ = CreateDeflate(compression, level);
+  if (codec_ == nullptr) {
+    LOG_ERROR << "gmif is built without " << CompressionName(compression) << " support"
+              << std::endl;
+    return false;
+  }
+  sink_ = sink;
+  out_.resize(kOutputSize);
+  return true;
+}
+
+bool Compressor::Write(const char* data, size_t size) {
+  return Run(data, size, false);
+}
+
+bool Compressor::Finish() {
+  return Run(nullptr, 0, true);
+}
+
+bool Compressor::Run(const char* data, size_t size, bool finish) {
+  while (true) {
+    char* out = out_.data();
+    size_t out_size = out_.size();
+    int status = codec_->Run(data, size, out, out_size, finish);
+    if (status < 0) {
+      LOG_ERROR << "compress data failed" << std::endl;
+      return false;
+    }
+    size_t n = out_.size() - out_size;
+    if (n > 0 && !sink_(out_.data(), n)) {
+      return false;
+    }
+    if (finish ? status == 1 : (size == 0 && out_size > 0)) {
+      return true;  // 输出缓冲区未满说明已处理完全部输入
+    }
+  }
+}
+
+}  // namespace io
+}  // namespace gmif
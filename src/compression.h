@@ -0,0 +1,132 @@
+#ifndef GMIF_SRC_COMPRESSION_H_
+#define GMIF_SRC_COMPRESSION_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gmif/gmif.h"
+
+namespace gmif {
+namespace io {
+
+//! 压缩格式对应的文件名后缀, 含"."; kNone返回空串
+const char* CompressionExtension(Compression compression);
+
+//! 压缩格式的名称, 用于日志
+const char* CompressionName(Compression compression);
+
+//! 当前构建是否支持该压缩格式(GMIF_HAVE_ZLIB/GMIF_HAVE_ZSTD), kNone总是支持
+bool CompressionSupported(Compression compression);
+
+class InflateCodec;
+class DeflateCodec;
+
+/**
+ * @brief 流式解压器: 后台线程读取压缩文件并解压为固定大小的数据块, 调用线程按顺序读取,
+ * 解压与解析重叠进行. 支持多成员gzip与多帧zstd
+ */
+class Decompressor {
+ public:
+  //! 已解压未读取的数据块数上限
+  static const size_t kQueueDepth = 4;
+
+  Decompressor();
+  ~Decompressor();
+
+  Decompressor(const Decompressor&) = delete;
+  Decompressor& operator=(const Decompressor&) = delete;
+
+  /**
+   * @brief 打开压缩文件并启动解压线程
+   * @param path 文件路径
+   * @param compression 压缩格式, 不可为kNone
+   * @param chunk_size 解压数据块大小
+   * @return 成功返回true, 文件不存在或不支持该压缩格式返回false
+   */
+  bool Open(const std::string& path, Compression compression, size_t chunk_size);
+
+  /**
+   * @brief 读取解压后的数据, 数据不足时等待解压线程
+   * @param buf 输出缓冲区
+   * @param size 最多读取的字节数
+   * @return 读取的字节数, 小于size表示数据结束或解压失败
+   */
+  size_t Read(char* buf, size_t size);
+
+  //! 是否发生读取或解压错误(含数据被截断)
+  bool fail() const { return failed_; }
+
+  //! 停止解压线程并关闭文件
+  void Close();
+
+ private:
+  //! 解压线程主循环
+  void Run();
+
+  //! 将解压出的数据块交给读取方, 队列满时等待, 已停止返回false
+  bool Push(std::vector<char>& chunk);
+
+  FILE* file_;
+  std::unique_ptr<InflateCodec> codec_;
+  size_t chunk_size_;
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<std::vector<char>> chunks_;       // 已解压未读取的数据块
+  std::vector<std::vector<char>> free_chunks_;  // 已读取可复用的数据块
+  std::vector<char> current_;                   // 正在读取的数据块
+  size_t current_pos_;
+  bool done_;  // 解压线程已结束
+  bool stop_;
+  std::atomic<bool> failed_;
+};
+
+/**
+ * @brief 流式压缩器, 压缩后的数据经由输出函数写出, 输出按固定大小的块进行
+ */
+class Compressor {
+ public:
+  //! 压缩数据输出函数, 失败返回false
+  typedef std::function<bool(const char*, size_t)> Sink;
+
+  Compressor();
+  ~Compressor();
+
+  Compressor(const Compressor&) = delete;
+  Compressor& operator=(const Compressor&) = delete;
+
+  /**
+   * @brief 初始化压缩流
+   * @param compression 压缩格式, 不可为kNone
+   * @param level 压缩级别, 0表示使用压缩库的默认级别
+   * @param sink 压缩数据输出函数
+   * @return 成功返回true, 不支持该压缩格式返回false
+   */
+  bool Init(Compression compression, int level, const Sink& sink);
+
+  //! 压缩数据, 失败返回false
+  bool Write(const char* data, size_t size);
+
+  //! 结束压缩流并输出剩余数据, 失败返回false
+  bool Finish();
+
+ private:
+  //! 压缩一段输入, finish为true时结束压缩流
+  bool Run(const char* data, size_t size, bool finish);
+
+  std::unique_ptr<DeflateCodec> codec_;
+  Sink sink_;
+  std::vector<char> out_;
+};
+
+}  // namespace io
+}  // namespace gmif
+
+#endif  // GMIF_SRC_COMPRESSION_H_
@@ -0,0 +1,379 @@
+#include "filter.h"
+#include <algorithm>
+#include <cctype>
+
+namespace gmif {
+namespace io {
+
+//! 表达式词法单元
+struct FilterToken {
+  enum Kind { kIdent, kNumber, kString, kSymbol, kEnd };
+
+  Kind kind;
+  std::string text;
+};
+
+//! 标识符字符, 非ASCII字节视为标识符的一部分以支持中文列名
+static inline bool IsIdentChar(char c, bool first) {
+  unsigned char uc = static_cast<unsigned char>(c);
+  if (isalpha(uc) || c == '_' || uc >= 0x80) {
+    return true;
+  }
+  return !first && (isdigit(uc) || c == '-');
+}
+
+/**
+ * 切分表达式
+ * @return 成功返回true, 存在无法识别的字符或未闭合的字符串时返回false
+ */
+static bool Tokenize(const std::string& expr, std::vector<FilterToken>& res, std::string& err) {
+  const char* p = expr.data();
+  const char* end = p + expr.size();
+  while (true) {
+    while (p != end && isspace(static_cast<unsigned char>(*p))) ++p;
+    if (p == end) {
+      break;
+    }
+    FilterToken token;
+    const char* start = p;
+    bool signed_num = (*p == '-' || *p == '+') && p + 1 != end &&
+                      (isdigit(static_cast<unsigned char>(p[1])) || p[1] == '.');
+    if (isdigit(static_cast<unsigned char>(*p)) || *p == '.' || signed_num) {
+      double v = 0;
+      p = utils::ParseDouble(p, end, v);
+      if (p == start) {
+        err = "illegal number at: " + std::string(start, end);
+        return false;
+      }
+      token.kind = FilterToken::kNumber;
+    } else if (IsIdentChar(*p, true)) {
+      while (p != end && IsIdentChar(*p, false)) ++p;
+      token.kind = FilterToken::kIdent;
+    } else if (*p == '\'' || *p == '"') {
+      const char* close = std::find(p + 1, end, *p);
+      if (close == end) {
+        err = "unterminated string at: " + std::string(start, end);
+        return false;
+      }
+      token.kind = FilterToken::kString;
+      token.text.assign(p + 1, close);
+      p = close + 1;
+      res.push_back(token);
+      continue;
+    } else if (strchr("(),", *p) != nullptr) {
+      ++p;
+      token.kind = FilterToken::kSymbol;
+    } else if (strchr("=!<>", *p) != nullptr) {
+      ++p;
+      if (p != end && (*p == '=' || (*start == '<' && *p == '>'))) {
+        ++p;
+      }
+      token.kind = FilterToken::kSymbol;
+    } else {
+      err = "unexpected character at: " + std::string(start, end);
+      return false;
+    }
+    token.text.assign(start, p);
+    res.push_back(token);
+  }
+  FilterToken token;
+  token.kind = FilterToken::kEnd;
+  res.push_back(token);
+  return true;
+}
+
+//! 递归下降解析, 节点按后序追加到RowFilter::nodes_
+class RowFilter::Parser {
+ public:
+  Parser(const std::vector<FilterToken>& tokens, const MifHeader& header, RowFilter& filter)
+      : tokens_(tokens), header_(header), schema_(header), filter_(filter), pos_(0) {}
+
+  bool Parse(std::string& err) {
+    size_t root = 0;
+    if (!ParseOr(root)) {
+      err = err_;
+      return false;
+    }
+    if (peek().kind != FilterToken::kEnd) {
+      err = "unexpected token: '" + peek().text + "'";
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  const FilterToken& peek() const { return tokens_[pos_]; }
+
+  bool IsKeyword(const char* keyword) const {
+    return peek().kind == FilterToken::kIdent && utils::StrEqualNoCase(peek().text, keyword);
+  }
+
+  bool IsSymbol(const char* symbol) const {
+    return peek().kind == FilterToken::kSymbol && peek().text == symbol;
+  }
+
+  bool Fail(const std::string& msg) {
+    err_ = msg + ", got: '" + (peek().kind == FilterToken::kEnd ? "<end>" : peek().text) + "'";
+    return false;
+  }
+
+  size_t AddNode(Op op, size_t lhs, size_t rhs) {
+    Node node;
+    node.op = op;
+    node.lhs = lhs;
+    node.rhs = rhs;
+    node.type = ColType::kStr;
+    filter_.nodes_.push_back(node);
+    return filter_.nodes_.size() - 1;
+  }
+
+  bool ParseOr(size_t& res) {
+    if (!ParseAnd(res)) {
+      return false;
+    }
+    while (IsKeyword("or")) {
+      ++pos_;
+      size_t rhs = 0;
+      if (!ParseAnd(rhs)) {
+        return false;
+      }
+      res = AddNode(Op::kOr, res, rhs);
+    }
+    return true;
+  }
+
+  bool ParseAnd(size_t& res) {
+    if (!ParseNot(res)) {
+      return false;
+    }
+    while (IsKeyword("and")) {
+      ++pos_;
+      size_t rhs = 0;
+      if (!ParseNot(rhs)) {
+        return false;
+      }
+      res = AddNode(Op::kAnd, res, rhs);
+    }
+    return true;
+  }
+
+  bool ParseNot(size_t& res) {
+    if (IsKeyword("not")) {
+      ++pos_;
+      size_t child = 0;
+      if (!ParseNot(child)) {
+        return false;
+      }
+      res = AddNode(Op::kNot, child, 0);
+      return true;
+    }
+    if (IsSymbol("(")) {
+      ++pos_;
+      if (!ParseOr(res)) {
+        return false;
+      }
+      if (!IsSymbol(")")) {
+        return Fail("expect ')'");
+      }
+      ++pos_;
+      return true;
+    }
+    return ParseCompare(res);
+  }
+
+  bool ParseCompare(size_t& res) {
+    if (peek().kind != FilterToken::kIdent) {
+      return Fail("expect column name");
+    }
+    std::string lower_name(peek().text);
+    utils::StrLower(lower_name);
+    int32_t field = header_.getColumnIndex(lower_name);
+    if (field < 0) {
+      return Fail("column not found");
+    }
+    ++pos_;
+
+    bool negate = false;
+    if (IsKeyword("not")) {
+      ++pos_;
+      negate = true;
+      if (!IsKeyword("in")) {
+        return Fail("expect 'in' after 'not'");
+      }
+    }
+    Node node;
+    node.lhs = static_cast<size_t>(field);
+    node.rhs = 0;
+    node.type = schema_[field].type;
+    if (IsKeyword("in")) {
+      ++pos_;
+      node.op = Op::kIn;
+      if (!IsSymbol("(")) {
+        return Fail("expect '(' after 'in'");
+      }
+      do {
+        ++pos_;
+        if (!ParseLiteral(node)) {
+          return false;
+        }
+      } while (IsSymbol(","));
+      if (!IsSymbol(")")) {
+        return Fail("expect ')' or ','");
+      }
+      ++pos_;
+    } else {
+      static const std::pair<const char*, Op> kOps[] = {
+          {"=", Op::kEq},  {"==", Op::kEq}, {"!=", Op::kNe}, {"<>", Op::kNe},
+          {"<", Op::kLt},  {"<=", Op::kLe}, {">", Op::kGt},  {">=", Op::kGe}};
+      const std::pair<const char*, Op>* op = nullptr;
+      for (const auto& item : kOps) {
+        if (IsSymbol(item.first)) {
+          op = &item;
+        }
+      }
+      if (op == nullptr) {
+        return Fail("expect comparison operator");
+      }
+      ++pos_;
+      node.op = op->second;
+      if (!ParseLiteral(node)) {
+        return false;
+      }
+    }
+
+    filter_.nodes_.push_back(node);
+    filter_.max_field_ = std::max(filter_.max_field_, node.lhs + 1);
+    res = filter_.nodes_.size() - 1;
+    if (negate) {
+      res = AddNode(Op::kNot, res, 0);
+    }
+    return true;
+  }
+
+  //! 按比较列的类型转换字面量
+  bool ParseLiteral(Node& node) {
+    const FilterToken& token = peek();
+    if (token.kind != FilterToken::kNumber && token.kind != FilterToken::kString) {
+      return Fail("expect literal");
+    }
+    if (node.type == ColType::kStr) {
+      node.strs.push_back(token.text);
+    } else {
+      const char* begin = token.text.data();
+      const char* end = begin + token.text.size();
+      double v = 0;
+      if (begin == end || utils::ParseDouble(begin, end, v) != end) {
+        return Fail("expect number for numeric column");
+      }
+      node.nums.push_back(v);
+    }
+    ++pos_;
+    return true;
+  }
+
+  const std::vector<FilterToken>& tokens_;
+  const MifHeader& header_;
+  ColumnSchema schema_;
+  RowFilter& filter_;
+  size_t pos_;
+  std::string err_;
+};
+
+int RowFilter::Compile(const std::string& expr, const MifHeader& header) {
+  nodes_.clear();
+  max_field_ = 0;
+  std::vector<FilterToken> tokens;
+  std::string err;
+  if (!Tokenize(expr, tokens, err)) {
+    LOG_ERROR << "compile filter failed, " << err << std::endl;
+    return -1;
+  }
+  if (tokens.size() == 1) {  // 空表达式
+    return 0;
+  }
+  if (!Parser(tokens, header, *this).Parse(err)) {
+    LOG_ERROR << "compile filter failed, " << err << ", expr: " << expr << std::endl;
+    nodes_.clear();
+    max_field_ = 0;
+    return -1;
+  }
+  return 0;
+}
+
+//! 字段的数值, 与读取时的类型转换一致
+static inline double FieldNumber(ColType type, const utils::StrView& item) {
+  if (item.empty()) {
+    return 0;
+  }
+  if (type == ColType::kInt) {
+    return static_cast<int32_t>(utils::to_int(item));
+  }
+  return utils::to_double(item);
+}
+
+//! 字符串按字节比较, 返回值同memcmp
+static inline int CompareStr(const utils::StrView& lhs, const std::string& rhs) {
+  size_t len = std::min(lhs.size(), rhs.size());
+  int res = len == 0 ? 0 : memcmp(lhs.data(), rhs.data(), len);
+  if (res != 0) {
+    return res;
+  }
+  return lhs.size() < rhs.size() ? -1 : (lhs.size() > rhs.size() ? 1 : 0);
+}
+
+bool RowFilter::Eval(size_t index, const std::vector<utils::StrView>& items) const {
+  const Node& node = nodes_[index];
+  switch (node.op) {
+    case Op::kOr:
+      return Eval(node.lhs, items) || Eval(node.rhs, items);
+    case Op::kAnd:
+      return Eval(node.lhs, items) && Eval(node.rhs, items);
+    case Op::kNot:
+      return !Eval(node.lhs, items);
+    default:
+      break;
+  }
+
+  const utils::StrView& item = items[node.lhs];
+  int cmp = 0;
+  if (node.type == ColType::kStr) {
+    if (node.op == Op::kIn) {
+      for (const auto& str : node.strs) {
+        if (item == utils::StrView(str)) {
+          return true;
+        }
+      }
+      return false;
+    }
+    cmp = CompareStr(item, node.strs[0]);
+  } else {
+    double v = FieldNumber(node.type, item);
+    if (node.op == Op::kIn) {
+      for (double num : node.nums) {
+        if (utils::DoubleEqual(v, num)) {
+          return true;
+        }
+      }
+      return false;
+    }
+    cmp = utils::DoubleEqual(v, node.nums[0]) ? 0 : (v < node.nums[0] ? -1 : 1);
+  }
+
+  switch (node.op) {
+    case Op::kEq:
+      return cmp == 0;
+    case Op::kNe:
+      return cmp != 0;
+    case Op::kLt:
+      return cmp < 0;
+    case Op::kLe:
+      return cmp <= 0;
+    case Op::kGt:
+      return cmp > 0;
+    default:
+      return cmp >= 0;
+  }
+}
+
+}  // namespace io
+}  // namespace gmif
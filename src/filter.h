@@ -0,0 +1,76 @@
+#ifndef GMIF_SRC_FILTER_H_
+#define GMIF_SRC_FILTER_H_
+
+#include "gmif/gmif.h"
+#include <string>
+#include <vector>
+#include "schema.h"
+#include "utils.h"
+
+namespace gmif {
+namespace io {
+
+/**
+ * @brief 属性过滤表达式, 编译后直接在切分出的MID字段上求值, 被拒绝的行不做类型转换
+ *
+ * 语法(关键字不区分大小写):
+ *   expr     := and_expr {"or" and_expr}
+ *   and_expr := not_expr {"and" not_expr}
+ *   not_expr := "not" not_expr | "(" expr ")" | compare
+ *   compare  := column op literal | column ["not"] "in" "(" literal {"," literal} ")"
+ *   op       := "=" | "==" | "!=" | "<>" | "<" | "<=" | ">" | ">="
+ *   literal  := 数字 | '字符串' | "字符串"
+ * 数值列按数值比较, 字符串列按字节比较; 数值列与非数字字符串比较视为编译错误.
+ */
+class RowFilter {
+ public:
+  RowFilter() : max_field_(0) {}
+
+  /**
+   * @brief 编译过滤表达式
+   * @param expr 表达式
+   * @param header MIF头, 列下标为MID行中的字段位置
+   * @return 成功返回0, 语法错误或列不存在返回-1
+   */
+  int Compile(const std::string& expr, const MifHeader& header);
+
+  //! 是否为空表达式(接受所有行)
+  bool empty() const { return nodes_.empty(); }
+
+  //! 求值所需的字段数, 即引用的最大字段下标加1
+  size_t getMaxField() const { return max_field_; }
+
+  /**
+   * @brief 对单行求值
+   * @param items MID行切分结果, 至少包含getMaxField()个字段
+   * @return 接受返回true
+   */
+  bool Match(const std::vector<utils::StrView>& items) const {
+    return nodes_.empty() || Eval(nodes_.size() - 1, items);
+  }
+
+ private:
+  enum class Op : uint8_t { kOr, kAnd, kNot, kEq, kNe, kLt, kLe, kGt, kGe, kIn };
+
+  //! 表达式节点, 子节点位于nodes_中靠前的位置, 根节点为最后一个
+  struct Node {
+    Op op;
+    size_t lhs;                        // 逻辑运算的左(或唯一)子节点; 比较运算的字段下标
+    size_t rhs;                        // 逻辑运算的右子节点
+    ColType type;                      // 比较列的类型
+    std::vector<double> nums;          // 数值列的比较值
+    std::vector<std::string> strs;     // 字符串列的比较值
+  };
+
+  class Parser;
+
+  bool Eval(size_t index, const std::vector<utils::StrView>& items) const;
+
+  std::vector<Node> nodes_;
+  size_t max_field_;
+};
+
+}  // namespace io
+}  // namespace gmif
+
+#endif  // GMIF_SRC_FILTER_H_
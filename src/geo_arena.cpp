@@ -0,0 +1,289 @@
+#include <geos/geom/CoordinateArraySequence.h>
+#include <geos/geom/GeometryFactory.h>
+#include <geos/geom/LineString.h>
+#include <geos/geom/MultiLineString.h>
+#include <geos/geom/MultiPolygon.h>
+#include <geos/geom/Point.h>
+#include <geos/geom/Polygon.h>
+#include "gmif/gmif.h"
+#include "utils.h"
+
+using namespace geos::geom;
+
+namespace gmif {
+
+GeoArena::GeoArena() : elem_parts_(1, 0), part_rings_(1, 0), ring_coords_(1, 0) {}
+
+bool GeoArena::append(const Geometry* geo) {
+  if (geo == nullptr) {
+    beginGeometry(-1);
+    endGeometry();
+    return true;
+  }
+  GeometryTypeId geo_type = geo->getGeometryTypeId();
+  switch (geo_type) {
+    case GEOS_POINT:
+      if (geo->getCoordinates()->size() != 1) {
+        LOG_ERROR << "can`t support empty Point" << std::endl;
+        return false;
+      }
+      break;
+    case GEOS_LINESTRING:
+    case GEOS_POLYGON:
+    case GEOS_MULTILINESTRING:
+    case GEOS_MULTIPOLYGON:
+      break;
+    default:
+      LOG_ERROR << "can`t support GeometryType: '" << geo->getGeometryType() << "'" << std::endl;
+      return false;
+  }
+
+  size_t num_parts = part_rings_.size();
+  size_t num_rings = ring_coords_.size();
+  size_t num_coords = coords_.size();
+  beginGeometry(geo_type);
+  if (geo_type == GEOS_POINT) {
+    addRing(*geo->getCoordinates());
+    endPart();
+  } else if (geo_type == GEOS_LINESTRING || geo_type == GEOS_MULTILINESTRING) {
+    for (size_t i = 0; i < geo->getNumGeometries(); ++i) {
+      auto line = static_cast<const LineString*>(geo->getGeometryN(i));
+      addRing(*line->getCoordinatesRO());
+      endPart();
+    }
+  } else {
+    for (size_t i = 0; i < geo->getNumGeometries(); ++i) {
+      auto polygon = static_cast<const Polygon*>(geo->getGeometryN(i));
+      addRing(*polygon->getExteriorRing()->getCoordinatesRO());
+      for (size_t j = 0; j < polygon->getNumInteriorRing(); ++j) {
+        addRing(*polygon->getInteriorRingN(j)->getCoordinatesRO());
+      }
+      endPart();
+    }
+  }
+  endGeometry();
+  if (!checkGeometry(size() - 1)) {  // 空线、空面或环的坐标数不足, 回退
+    LOG_ERROR << "coordinate size of " << geo->getGeometryType() << " is illegal" << std::endl;
+    types_.pop_back();
+    elem_parts_.pop_back();
+    part_rings_.resize(num_parts);
+    ring_coords_.resize(num_rings);
+    coords_.resize(num_coords);
+    return false;
+  }
+  return true;
+}
+
+void GeoArena::append(const GeoArena& other, size_t i) {
+  beginGeometry(other.types_[i]);
+  for (uint64_t part = other.elem_parts_[i]; part < other.elem_parts_[i + 1]; ++part) {
+    for (uint64_t ring = other.part_rings_[part]; ring < other.part_rings_[part + 1]; ++ring) {
+      const double* xy = other.coords_.data();
+      coords_.insert(coords_.end(), xy + other.ring_coords_[ring] * 2,
+                     xy + other.ring_coords_[ring + 1] * 2);
+      ring_coords_.push_back(coords_.size() / 2);
+    }
+    endPart();
+  }
+  endGeometry();
+}
+
+void GeoArena::append(const GeoArena& other) {
+  // 偏移数组平移后拼接, 坐标整体复制
+  uint64_t part_base = part_rings_.size() - 1;
+  uint64_t ring_base = ring_coords_.size() - 1;
+  uint64_t coord_base = coords_.size() / 2;
+  types_.insert(types_.end(), other.types_.begin(), other.types_.end());
+  for (size_t i = 1; i < other.elem_parts_.size(); ++i) {
+    elem_parts_.push_back(other.elem_parts_[i] + part_base);
+  }
+  for (size_t i = 1; i < other.part_rings_.size(); ++i) {
+    part_rings_.push_back(other.part_rings_[i] + ring_base);
+  }
+  for (size_t i = 1; i < other.ring_coords_.size(); ++i) {
+    ring_coords_.push_back(other.ring_coords_[i] + coord_base);
+  }
+  coords_.insert(coords_.end(), other.coords_.begin(), other.coords_.end());
+}
+
+void GeoArena::beginGeometry(int geo_type) {
+  types_.push_back(geo_type);
+}
+
+void GeoArena::addRing(const std::vector<Coordinate>& pts) {
+  for (const auto& pt : pts) {
+    coords_.push_back(pt.x);
+    coords_.push_back(pt.y);
+  }
+  ring_coords_.push_back(coords_.size() / 2);
+}
+
+void GeoArena::addRing(const CoordinateSequence& seq) {
+  for (size_t i = 0; i < seq.size(); ++i) {
+    coords_.push_back(seq.getX(i));
+    coords_.push_back(seq.getY(i));
+  }
+  ring_coords_.push_back(coords_.size() / 2);
+}
+
+void GeoArena::endPart() {
+  part_rings_.push_back(ring_coords_.size() - 1);
+}
+
+void GeoArena::endGeometry() {
+  elem_parts_.push_back(part_rings_.size() - 1);
+}
+
+//! 偏移数组非空、首个为0、非递减且末尾为total
+static bool CheckOffsets(const std::vector<uint64_t>& offsets, uint64_t total) {
+  if (offsets.empty() || offsets.front() != 0 || offsets.back() != total) {
+    return false;
+  }
+  for (size_t i = 1; i < offsets.size(); ++i) {
+    if (offsets[i - 1] > offsets[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool GeoArena::assign(std::vector<int32_t>&& types,
+                      std::vector<uint64_t>&& elem_parts,
+                      std::vector<uint64_t>&& part_rings,
+                      std::vector<uint64_t>&& ring_coords,
+                      std::vector<double>&& coords) {
+  if (elem_parts.size() != types.size() + 1 || coords.size() % 2 != 0 ||
+      !CheckOffsets(ring_coords, coords.size() / 2) ||
+      !CheckOffsets(part_rings, ring_coords.size() - 1) ||
+      !CheckOffsets(elem_parts, part_rings.size() - 1)) {
+    return false;
+  }
+  GeoArena arena;
+  arena.types_ = std::move(types);
+  arena.elem_parts_ = std::move(elem_parts);
+  arena.part_rings_ = std::move(part_rings);
+  arena.ring_coords_ = std::move(ring_coords);
+  arena.coords_ = std::move(coords);
+  for (size_t i = 0; i < arena.size(); ++i) {
+    if (!arena.checkGeometry(i)) {
+      return false;
+    }
+  }
+  *this = std::move(arena);
+  return true;
+}
+
+void GeoArena::getEnvelope(size_t i, Envelope& env) const {
+  // 同一几何对象的坐标连续存放
+  uint64_t begin = ring_coords_[part_rings_[elem_parts_[i]]];
+  uint64_t end = ring_coords_[part_rings_[elem_parts_[i + 1]]];
+  env = Envelope();
+  for (uint64_t j = begin; j < end; ++j) {
+    env.expandToInclude(coords_[j * 2], coords_[j * 2 + 1]);
+  }
+}
+
+bool GeoArena::checkGeometry(size_t i) const {
+  uint64_t part = elem_parts_[i];
+  uint64_t part_end = elem_parts_[i + 1];
+  int geo_type = types_[i];
+  if (geo_type < 0) {
+    return part == part_end;
+  }
+  if (geo_type == GEOS_POINT) {
+    uint64_t ring = part_rings_[part];
+    return part_end - part == 1 && part_rings_[part + 1] - ring == 1 &&
+           ring_coords_[ring + 1] - ring_coords_[ring] == 1;
+  }
+  if (geo_type == GEOS_LINESTRING || geo_type == GEOS_POLYGON) {
+    if (part_end - part != 1) {
+      return false;
+    }
+  } else if (geo_type != GEOS_MULTILINESTRING && geo_type != GEOS_MULTIPOLYGON) {
+    return false;
+  }
+  // 线的每个部件只有1个不少于2点的环, 面的每个环不少于4点(首尾相同)
+  bool is_polygon = (geo_type == GEOS_POLYGON || geo_type == GEOS_MULTIPOLYGON);
+  for (; part < part_end; ++part) {
+    uint64_t ring = part_rings_[part];
+    uint64_t ring_end = part_rings_[part + 1];
+    if (ring == ring_end || (!is_polygon && ring_end - ring != 1)) {
+      return false;
+    }
+    for (; ring < ring_end; ++ring) {
+      if (ring_coords_[ring + 1] - ring_coords_[ring] < (is_polygon ? 4u : 2u)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static std::unique_ptr<CoordinateArraySequence> CreateSeq(const std::vector<uint64_t>& ring_coords,
+                                                          const std::vector<double>& coords,
+                                                          uint64_t ring) {
+  uint64_t begin = ring_coords[ring];
+  std::vector<Coordinate> pts(ring_coords[ring + 1] - begin);
+  const double* xy = coords.data() + begin * 2;
+  for (size_t i = 0; i < pts.size(); ++i) {
+    pts[i].x = xy[i * 2];
+    pts[i].y = xy[i * 2 + 1];
+  }
+  return std::unique_ptr<CoordinateArraySequence>(new CoordinateArraySequence(std::move(pts)));
+}
+
+int GeoArena::toGeometry(size_t i, GeometryPtr& res, const GeometryFactory* geos_factory) const {
+  res = nullptr;
+  if (!checkGeometry(i)) {
+    return -1;
+  }
+  int geo_type = types_[i];
+  if (geo_type < 0) {
+    return 0;
+  }
+  GeometryFactory::Ptr own_factory;
+  if (geos_factory == nullptr) {
+    PrecisionModel pm(GMIF_COORD_PRECISION, 0, 0);
+    own_factory = GeometryFactory::create(&pm, -1);
+    geos_factory = own_factory.get();
+  }
+  if (geo_type == GEOS_POINT) {
+    const double* xy = coords_.data() + ring_coords_[part_rings_[elem_parts_[i]]] * 2;
+    res = GeometryPtr(geos_factory->createPoint(Coordinate(xy[0], xy[1])));
+    return 0;
+  }
+
+  bool is_polygon = (geo_type == GEOS_POLYGON || geo_type == GEOS_MULTIPOLYGON);
+  std::vector<std::unique_ptr<Geometry>> geos;
+  for (uint64_t part = elem_parts_[i]; part < elem_parts_[i + 1]; ++part) {
+    uint64_t ring = part_rings_[part];
+    if (!is_polygon) {
+      geos.push_back(geos_factory->createLineString(CreateSeq(ring_coords_, coords_, ring)));
+      continue;
+    }
+    auto shell = geos_factory->createLinearRing(CreateSeq(ring_coords_, coords_, ring));
+    std::vector<std::unique_ptr<LinearRing>> holes;
+    for (++ring; ring < part_rings_[part + 1]; ++ring) {
+      holes.push_back(geos_factory->createLinearRing(CreateSeq(ring_coords_, coords_, ring)));
+    }
+    geos.push_back(geos_factory->createPolygon(std::move(shell), std::move(holes)));
+  }
+  if (geo_type == GEOS_LINESTRING || geo_type == GEOS_POLYGON) {
+    res = std::move(geos[0]);
+  } else if (is_polygon) {
+    res = geos_factory->createMultiPolygon(std::move(geos));
+  } else {
+    res = geos_factory->createMultiLineString(std::move(geos));
+  }
+  return 0;
+}
+
+void GeoArena::shrink() {
+  types_.shrink_to_fit();
+  elem_parts_.shrink_to_fit();
+  part_rings_.shrink_to_fit();
+  ring_coords_.shrink_to_fit();
+  coords_.shrink_to_fit();
+}
+
+}  // namespace gmif
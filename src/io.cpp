@@ -7,6 +7,7 @@
 #include <geos/geom/MultiPolygon.h>
 #include <geos/geom/Point.h>
 #include <geos/geom/Polygon.h>
+#include <algorithm>
 #include <string>
 #include <vector>
 #include "check.h"
@@ -26,40 +27,39 @@ using namespace geos::algorithm;
 namespace gmif {
 namespace io {
 
-enum class ColType { kStr, kDouble, kInt };
+//! MID浮点属性的小数位数, 与此前iostream写出时的默认精度一致
+static const int kMidDoublePrecision = 6;
 
-ColType GetColType(const std::string& lower_col_type_str) {
-  if (lower_col_type_str.compare(0, 7, "integer") == 0 ||
-      lower_col_type_str.compare(0, 8, "smallint") == 0) {
-    return ColType::kInt;
-  } else if (lower_col_type_str.compare(0, 7, "decimal") == 0 ||
-             lower_col_type_str.compare(0, 5, "float") == 0) {
-    return ColType::kDouble;
-  }
-  return ColType::kStr;
-};
-
-template <typename T>
-void out_vec(std::ofstream& of, const std::vector<T>& v) {
+static void out_vec(BufferedWriter& out, const std::vector<size_t>& v) {
   for (size_t i = 0; i < v.size(); ++i) {
     if (i != 0)
-      of << ",";
-    of << v[i];
+      out.Put(',');
+    out.WriteInt(v[i]);
   }
 }
 
 bool TryOpenFile(const std::string& base_name,
                  const std::vector<std::string>& ext_names,
-                 std::ifstream& ifs) {
+                 bool use_mmap,
+                 TextReader& reader) {
   std::string fpath;
   for (const auto& ext : ext_names) {
     fpath = base_name + "." + ext;
-    ifs.open(fpath.c_str());
-    if (ifs.fail()) {
-      ifs.close();
-      continue;
+    if (use_mmap && reader.OpenMapped(fpath)) {
+      return true;
+    }
+    if (reader.OpenBuffered(fpath)) {
+      return true;
+    }
+  }
+  // 未找到未压缩文件时查找压缩文件
+  for (Compression compression : {Compression::kGzip, Compression::kZstd}) {
+    for (const auto& ext : ext_names) {
+      fpath = base_name + "." + ext + CompressionExtension(compression);
+      if (reader.OpenCompressed(fpath, compression)) {
+        return true;
+      }
     }
-    return true;
   }
 
   std::cerr << "can`t open file \"" << base_name << ".[";
@@ -72,12 +72,38 @@ bool TryOpenFile(const std::string& base_name,
   return false;
 }
 
-int ReadHeader(std::ifstream& mif_ifs, MifHeader& header) {
+bool TryMapFile(const std::string& base_name,
+                const std::vector<std::string>& ext_names,
+                MappedFile& file) {
+  for (const auto& ext : ext_names) {
+    if (file.Open(base_name + "." + ext)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ResolveFile(const std::string& base_name,
+                 const std::vector<std::string>& ext_names,
+                 std::string& path) {
+  for (const auto& ext : ext_names) {
+    path = base_name + "." + ext;
+    std::ifstream ifs(path.c_str(), std::ios_base::in | std::ios_base::binary);
+    if (ifs.is_open()) {
+      return true;
+    }
+  }
+  path.clear();
+  return false;
+}
+
+int ReadHeader(TextReader& mif_reader, MifHeader& header) {
+  utils::StrView line_view;
   std::string line;
   std::vector<std::string> items;
   int col_num(-1);
-  while (mif_ifs.good()) {
-    getline(mif_ifs, line);
+  while (mif_reader.ReadLine(line_view)) {
+    line.assign(line_view.data(), line_view.size());
     utils::StrTrimRightSpace(line);
     if (line.empty())
       continue;
@@ -155,105 +181,438 @@ int ReadHeader(std::ifstream& mif_ifs, MifHeader& header) {
   return 0;
 }
 
+//! 当前线程复用的分词缓冲区, 避免逐行分配
+static std::vector<utils::StrView>& TokenBuffer() {
+  static thread_local std::vector<utils::StrView> items;
+  return items;
+}
+
+//! 驻留的字符串数超过该值且超过行数一半时停止驻留, 避免高基数列维护驻留池
+static const size_t kPoolMaxDistinct = 4096;
+
+int ProjectHeader(MifHeader& header,
+                  const std::vector<std::string>& columns,
+                  Projection& projection) {
+  projection = Projection();
+  projection.num_fields = header.getColumnSize();
+  if (columns.empty()) {
+    return 0;
+  }
+
+  std::vector<bool> selected(header.getColumnSize(), false);
+  for (const auto& column : columns) {
+    std::string lower_name(column);
+    utils::StrLower(lower_name);
+    int32_t index = header.getColumnIndex(lower_name);
+    if (index < 0) {
+      LOG_ERROR << "projected column '" << column << "' not found" << std::endl;
+      return -1;
+    }
+    selected[index] = true;
+  }
+
+  MifHeader projected(header);
+  while (projected.getColumnSize() > 0) {
+    projected.deleteColumnByIndex(projected.getColumnSize() - 1);
+  }
+  std::vector<size_t> new_pos(header.getColumnSize(), 0);  // 选中列的新位置(从1开始)
+  for (size_t i = 0; i < header.getColumnSize(); ++i) {
+    if (selected[i]) {
+      projected.addColumn(header.getColumnName(i), header.getColumnType(i));
+      projection.source_index.push_back(i);
+      new_pos[i] = projection.source_index.size();
+    }
+  }
+  // Unique/Index按从1开始的列序号记录
+  auto remap = [&new_pos](std::vector<size_t>& vec) {
+    std::vector<size_t> res;
+    for (size_t col : vec) {
+      if (col >= 1 && col <= new_pos.size() && new_pos[col - 1] > 0) {
+        res.push_back(new_pos[col - 1]);
+      }
+    }
+    vec.swap(res);
+  };
+  remap(projected.getUniqueVec());
+  remap(projected.getIndexVec());
+  header = std::move(projected);
+  return 0;
+}
+
+int PlanRead(MifHeader& header, const LoadOptions& options, ReadPlan& plan) {
+  plan = ReadPlan();
+  if (!options.filter.empty()) {
+    std::shared_ptr<RowFilter> filter = std::make_shared<RowFilter>();
+    if (filter->Compile(options.filter, header) != 0) {
+      return -1;
+    }
+    if (!filter->empty()) {
+      plan.filter = filter;
+    }
+  }
+  return ProjectHeader(header, options.columns, plan.projection);
+}
+
+ReadContext::ReadContext(const MifHeader& header, const LoadOptions& options, const ReadPlan& plan)
+    : schema(header),
+      projection(plan.projection),
+      filter(plan.filter),
+      predicate(options.predicate),
+      bbox(options.bbox),
+      max_fields(SIZE_MAX),
+      mid_only(options.mid_only),
+      rows(0) {
+  if (projection.source_index.empty()) {
+    projection.num_fields = schema.size();
+  } else {
+    // 仅需扫描到所选列与过滤表达式引用的最后一个字段
+    size_t need = projection.source_index.back() + 1;
+    if (filter != nullptr) {
+      need = std::max(need, filter->getMaxField());
+    }
+    if (need < projection.num_fields) {
+      max_fields = need;
+    }
+  }
+  if (options.columnar_attrs) {
+    table = std::make_shared<AttrTable>(header);
+  } else if (options.intern_strings) {
+    pools.resize(schema.size());
+  }
+  if (options.lazy_geo && !options.mid_only) {
+    arena = std::make_shared<GeoArena>();
+  }
+}
+
+//! 按列类型解码单个字段, 内联容量以外的字符串优先从驻留池获取
+static inline void DecodeField(const ColumnSpec& spec,
+                               const utils::StrView& item,
+                               StrPool* pool,
+                               size_t rows,
+                               AttrValue& val) {
+  switch (spec.type) {
+    case ColType::kInt:
+      val = item.empty() ? 0 : static_cast<int32_t>(utils::to_int(item));
+      break;
+    case ColType::kDouble:
+      val = item.empty() ? 0.0 : utils::to_double(item);
+      break;
+    default:
+      if (pool != nullptr && pool->isEnabled() && item.size() > AttrValue::kInlineCapacity) {
+        val.setStr(*pool->Intern(item));
+        if (pool->size() > kPoolMaxDistinct && pool->size() * 2 > rows) {
+          pool->Disable();
+        }
+      } else {
+        val.setStr(item.data(), item.size());
+      }
+      break;
+  }
+}
+
+//! ReadAttrItems返回值: 该行未通过过滤表达式
+static const int kRowRejected = 2;
+
 /**
- * 读取单行属性
- * @param mid_ifs
- * @param header
- * @param res
- * @return 成功返回0, 失败返回-1, 文件结束返回1
+ * 读取单行MID并切分字段, 先按过滤表达式求值, 再按投影仅保留所选字段
+ * @param mid_reader
+ * @param ctx
+ * @param items 切分结果, 指向读取器缓冲区
+ * @return 成功返回0, 失败返回-1, 文件结束返回1, 未通过过滤返回kRowRejected
  */
-int ReadSingleAttr(std::ifstream& mid_ifs, const MifHeader& header, AttrMap& res) {
-  std::string line;
-  while (line.empty() && mid_ifs.good()) {
-    getline(mid_ifs, line);
+static int ReadAttrItems(TextReader& mid_reader,
+                         ReadContext& ctx,
+                         std::vector<utils::StrView>& items) {
+  utils::StrView line;
+  do {
+    if (!mid_reader.ReadLine(line)) {
+      return 1;
+    }
     utils::StrTrimSpace(line);
-  }
-  if (line.empty() && mid_ifs.eof()) {
-    return 1;
-  }
+  } while (line.empty());
 
-  std::vector<std::string> items;
-  utils::StrSplitKeepQuot(line, header.getDelimiter(), items);
-  if (header.getColumnSize() != items.size()) {
-    LOG_ERROR << "mif header column-num(" << header.getColumnSize() << ") != mid items-size("
-              << items.size() << "), items:" << items << std::endl;
+  char delimiter = ctx.schema.getDelimiter();
+  utils::StrSplitUnquote(line, delimiter, items, ctx.max_fields);
+  size_t num_items = items.size();
+  if (num_items == ctx.max_fields && ctx.max_fields < ctx.projection.num_fields) {
+    num_items = utils::StrCountFields(line, delimiter);  // 切分提前结束, 仍需校验整行字段数
+  }
+  if (num_items != ctx.projection.num_fields) {
+    LOG_ERROR << "mif header column-num(" << ctx.projection.num_fields << ") != mid items-size("
+              << num_items << "), items:" << items << std::endl;
     return -1;
   }
-  res.clear();
-  for (size_t i = 0; i < items.size(); ++i) {
-    const std::string& col_name = header.getColumnName(i);
-    ColType col_type = GetColType(header.getColumnType(i));
-    utils::StrTrim(items[i], "\"");
-    if (col_type == ColType::kInt) {
-      AttrValue val = items[i].empty() ? 0 : atoi(items[i].c_str());
-      res.insert(std::make_pair(col_name, std::move(val)));
-    } else if (col_type == ColType::kDouble) {
-      AttrValue val = items[i].empty() ? 0.0 : strtod(items[i].c_str(), nullptr);
-      res.insert(std::make_pair(col_name, std::move(val)));
-    } else {
-      res.insert(std::make_pair(col_name, items[i]));
+  ++ctx.rows;
+  if (ctx.filter != nullptr && !ctx.filter->Match(items)) {
+    return kRowRejected;
+  }
+
+  const std::vector<size_t>& source_index = ctx.projection.source_index;
+  if (!source_index.empty()) {  // 下标递增, 可原地前移
+    for (size_t i = 0; i < source_index.size(); ++i) {
+      items[i] = items[source_index[i]];
     }
+    items.resize(source_index.size());
   }
   return 0;
 }
 
+int SkipAttrLine(TextReader& mid_reader) {
+  utils::StrView line;
+  do {
+    if (!mid_reader.ReadLine(line)) {
+      return 1;
+    }
+    utils::StrTrimSpace(line);
+  } while (line.empty());
+  return 0;
+}
+
+/**
+ * 解码单行属性, res中已有相同字段时原地更新, 复用map节点与字符串容量
+ * @param ctx
+ * @param items ReadAttrItems的切分结果
+ * @param res
+ */
+static void DecodeAttrs(ReadContext& ctx, const std::vector<utils::StrView>& items, AttrMap& res) {
+  const ColumnSchema& schema = ctx.schema;
+  size_t rows = ctx.rows;
+  auto decode = [&](size_t index, AttrValue& val) {
+    StrPool* pool = ctx.pools.empty() ? nullptr : &ctx.pools[index];
+    DecodeField(schema[index], items[index], pool, rows, val);
+  };
+
+  // AttrMap与read_order同为列名升序, 同步遍历即可完成匹配
+  const std::vector<size_t>& order = schema.getReadOrder();
+  if (res.size() == order.size()) {
+    auto it = res.begin();
+    size_t k = 0;
+    for (; k < order.size() && it->first == schema[order[k]].name; ++k, ++it) {
+      decode(order[k], it->second);
+    }
+    if (k == order.size()) {
+      return;
+    }
+  }
+  res.clear();  // 原有字段与表头不一致, 重新构建
+  for (size_t index : order) {
+    auto it = res.emplace_hint(res.end(), schema[index].name, AttrValue());
+    decode(index, it->second);
+  }
+}
+
 //! 判断样式关键字
-bool IsStyleKeyWord(const std::string& lower_word) {
-  if (lower_word.compare(0, 3, "pen") == 0)
+bool IsStyleKeyWord(utils::StrView word) {
+  if (utils::StrStartsWithNoCase(word, "pen"))
     return true;
-  if (lower_word.compare(0, 5, "brush") == 0)
+  if (utils::StrStartsWithNoCase(word, "brush"))
     return true;
-  if (lower_word.compare(0, 6, "symbol") == 0)
+  if (utils::StrStartsWithNoCase(word, "symbol"))
     return true;
-  if (lower_word.compare(0, 4, "font") == 0)
+  if (utils::StrStartsWithNoCase(word, "font"))
     return true;
-  if (lower_word.compare(0, 6, "center") == 0)
+  if (utils::StrStartsWithNoCase(word, "center"))
     return true;
   return false;
 }
 
-std::unique_ptr<CoordinateArraySequence> ReadCoordSeq(std::ifstream& mif_ifs, int num_pts = -1) {
-  if (num_pts < 0) {
-    mif_ifs >> num_pts;
+//! 解析出的几何坐标, 通过范围判断后再构造GEOS几何对象
+struct RawGeo {
+  enum Type { kNone, kPoint, kLineString, kMultiLineString, kPolygon, kMultiPolygon, kRect };
+
+  Type type;
+  size_t num_parts;                            // 有效的坐标序列数
+  std::vector<std::vector<Coordinate>> parts;  // 各坐标序列, 跨元素复用容量
+  Envelope env;                                // 坐标范围, 仅在需要时计算
+};
+
+//! 各RawGeo::Type构造出的GEOS几何类型, 无几何为-1
+static const int kRawGeoTypes[] = {-1, GEOS_POINT, GEOS_LINESTRING, GEOS_MULTILINESTRING,
+                                   GEOS_POLYGON, GEOS_MULTIPOLYGON, GEOS_POLYGON};
+
+//! 当前线程复用的几何坐标缓冲区
+static RawGeo& RawGeoBuffer() {
+  static thread_local RawGeo raw;
+  return raw;
+}
+
+//! 追加一个坐标序列
+static std::vector<Coordinate>& NextPart(RawGeo& raw) {
+  if (raw.num_parts == raw.parts.size()) {
+    raw.parts.emplace_back();
+  }
+  return raw.parts[raw.num_parts++];
+}
+
+/**
+ * 解析坐标序列
+ * @param mif_reader MIF读取器
+ * @param num_pts 坐标数, 小于0时从读取器中读取
+ * @param pts 返回的坐标
+ * @param env 不为nullptr时在解析的同时扩展坐标范围
+ * @return 成功返回true
+ */
+static bool ReadCoordSeq(TextReader& mif_reader,
+                         int num_pts,
+                         std::vector<Coordinate>& pts,
+                         Envelope* env) {
+  utils::StrView token;
+  if (num_pts < 0 && mif_reader.ReadToken(token)) {
+    num_pts = static_cast<int>(utils::to_int(token));
   }
   if (num_pts < 0) {
     LOG_ERROR << "read coordinate sequence failed, illegal num_pts: " << num_pts << std::endl;
-    return nullptr;
+    return false;
   }
-  double x(0), y(0);
-  auto coords = std::unique_ptr<CoordinateArraySequence>(new CoordinateArraySequence(num_pts));
-  for (int i = 0; i < num_pts; ++i) {
-    mif_ifs >> x >> y;
-    coords->setAt(Coordinate(x, y), i);
+  // 坐标直接解析到连续数组, 构造时再整体移交给坐标序列
+  pts.resize(num_pts);
+  for (auto& pt : pts) {
+    if (!(mif_reader.ReadDouble(pt.x) && mif_reader.ReadDouble(pt.y))) {
+      LOG_ERROR << "read coordinate sequence failed, expect " << num_pts << " points" << std::endl;
+      return false;
+    }
+    if (env != nullptr) {
+      env->expandToInclude(pt.x, pt.y);
+    }
   }
-  return coords;
+  return true;
 }
 
-std::unique_ptr<LineString> ReadLineString(const GeometryFactory::Ptr& geos_factory,
-                                           std::ifstream& mif_ifs,
-                                           int num_pts = -1) {
-  auto coords = ReadCoordSeq(mif_ifs, num_pts);
-  if (coords == nullptr) {
-    return nullptr;
+/**
+ * 解析单个几何对象的坐标, 不构造GEOS几何对象
+ * @param mif_reader MIF读取器
+ * @param with_env 是否计算坐标范围
+ * @param raw 返回的几何坐标
+ * @return 成功返回0, 失败返回-1, 文件结束返回1
+ */
+static int ReadRawGeo(TextReader& mif_reader, bool with_env, RawGeo& raw) {
+  // https://baike.baidu.com/item/MIF/1416600
+
+  raw.type = RawGeo::kNone;
+  raw.num_parts = 0;
+  raw.env.setToNull();
+  Envelope* env = with_env ? &raw.env : nullptr;
+
+  utils::StrView line;
+  std::vector<utils::StrView>& items = TokenBuffer();
+
+  while (mif_reader.ReadLine(line)) {
+    utils::StrTrimSpace(line);
+    if (line.empty()) {
+      continue;
+    }
+    utils::StrSplitSpace(line, items);
+    const utils::StrView& keyword = items[0];
+
+    if (utils::StrEqualNoCase(keyword, "none")) {
+      return 0;
+    } else if (utils::StrEqualNoCase(keyword, "point")) {
+      CHECK_ITEMS_SIZE(items, 3);
+      raw.type = RawGeo::kPoint;
+      NextPart(raw).assign(1, Coordinate(utils::to_double(items[1]), utils::to_double(items[2])));
+    } else if (utils::StrEqualNoCase(keyword, "line")) {
+      CHECK_ITEMS_SIZE(items, 5);
+      raw.type = RawGeo::kLineString;
+      std::vector<Coordinate>& pts = NextPart(raw);
+      pts.resize(2);
+      pts[0] = Coordinate(utils::to_double(items[1]), utils::to_double(items[2]));
+      pts[1] = Coordinate(utils::to_double(items[3]), utils::to_double(items[4]));
+    } else if (utils::StrEqualNoCase(keyword, "pline")) {
+      if (items.size() == 1) {
+        raw.type = RawGeo::kLineString;
+        if (!ReadCoordSeq(mif_reader, -1, NextPart(raw), env)) {
+          return -1;
+        }
+        return 0;
+      } else if (items.size() == 2) {  // PLINE <coords_num>
+        raw.type = RawGeo::kLineString;
+        if (!ReadCoordSeq(mif_reader, utils::to_int(items[1]), NextPart(raw), env)) {
+          return -1;
+        }
+        return 0;
+      } else if (items.size() == 3) {  // PLINE MULTIPLE <geo_num>
+        raw.type = RawGeo::kMultiLineString;
+        int geo_num = utils::to_int(items[2]);
+        for (int i = 0; i < geo_num; ++i) {
+          if (!ReadCoordSeq(mif_reader, -1, NextPart(raw), env)) {
+            return -1;
+          }
+        }
+        return 0;
+      } else {
+        LOG_ERROR << "PLINE format illegal: " << items << std::endl;
+        return -1;
+      }
+    } else if (utils::StrEqualNoCase(keyword, "region")) {
+      CHECK_ITEMS_SIZE(items, 2);
+      int geo_num = utils::to_int(items[1]);
+      if (geo_num < 1) {
+        LOG_ERROR << "REGION format illegal: " << items << std::endl;
+        return -1;
+      }
+      raw.type = (geo_num == 1) ? RawGeo::kPolygon : RawGeo::kMultiPolygon;
+      for (int i = 0; i < geo_num; ++i) {
+        if (!ReadCoordSeq(mif_reader, -1, NextPart(raw), env)) {
+          return -1;
+        }
+      }
+      return 0;
+    } else if (utils::StrEqualNoCase(keyword, "rect")) {
+      CHECK_ITEMS_SIZE(items, 5);
+      double x1(utils::to_double(items[1]));
+      double y1(utils::to_double(items[2]));
+      double x2(utils::to_double(items[3]));
+      double y2(utils::to_double(items[4]));
+      raw.type = RawGeo::kRect;
+      std::vector<Coordinate>& pts = NextPart(raw);
+      pts.resize(5);
+      pts[0] = Coordinate(x1, y1);
+      pts[1] = Coordinate(x2, y1);
+      pts[2] = Coordinate(x2, y2);
+      pts[3] = Coordinate(x1, y2);
+      pts[4] = Coordinate(x1, y1);
+    } else if (IsStyleKeyWord(keyword)) {
+      // ignore and skip style line
+      continue;
+    } else {
+      LOG_ERROR << "can`t support mif keyword: '" << keyword << "'" << std::endl;
+      return -1;
+    }
+
+    // 单行几何对象
+    if (env != nullptr) {
+      for (const auto& pt : raw.parts[0]) {
+        env->expandToInclude(pt.x, pt.y);
+      }
+    }
+    return 0;
   }
-  if (coords->getSize() < 2) {
-    LOG_ERROR << "read LineString coordinate size illegal: " << coords->getSize() << std::endl;
+  return 1;
+}
+
+std::unique_ptr<LineString> CreateLineString(const GeometryFactory::Ptr& geos_factory,
+                                             std::vector<Coordinate>& pts) {
+  if (pts.size() < 2) {
+    LOG_ERROR << "read LineString coordinate size illegal: " << pts.size() << std::endl;
     return nullptr;
   }
+  auto coords =
+      std::unique_ptr<CoordinateArraySequence>(new CoordinateArraySequence(std::move(pts)));
   return geos_factory->createLineString(std::move(coords));
 }
 
-std::unique_ptr<Polygon> ReadPolygon(const GeometryFactory::Ptr& geos_factory,
-                                     std::ifstream& mif_ifs,
-                                     int num_pts = -1) {
-  auto coords = ReadCoordSeq(mif_ifs, num_pts);
-  if (coords == nullptr) {
-    return nullptr;
-  }
-  if (coords->getSize() < 3) {
-    LOG_ERROR << "read Polygon coordinate size illegal: " << coords->getSize() << std::endl;
+/**
+ * 由面的坐标构造环的坐标序列, 坐标移交给坐标序列
+ * @param pts 面的坐标
+ * @return 修正闭环并统一为顺时针的坐标序列, 坐标数不合法返回nullptr
+ */
+static std::unique_ptr<CoordinateArraySequence> CreateRingSeq(std::vector<Coordinate>& pts) {
+  if (pts.size() < 3) {
+    LOG_ERROR << "read Polygon coordinate size illegal: " << pts.size() << std::endl;
     return nullptr;
   }
+  auto coords =
+      std::unique_ptr<CoordinateArraySequence>(new CoordinateArraySequence(std::move(pts)));
 
   // 修正闭环
   if (coords->front() != coords->back()) {
@@ -264,258 +623,557 @@ std::unique_ptr<Polygon> ReadPolygon(const GeometryFactory::Ptr& geos_factory,
   if (Orientation::isCCW(coords.get())) {
     CoordinateSequence::reverse(coords.get());
   }
+  return coords;
+}
 
+std::unique_ptr<Polygon> CreatePolygon(const GeometryFactory::Ptr& geos_factory,
+                                       std::vector<Coordinate>& pts) {
+  auto coords = CreateRingSeq(pts);
+  if (coords == nullptr) {
+    return nullptr;
+  }
   auto ring = geos_factory->createLinearRing(std::move(coords));
   return geos_factory->createPolygon(std::move(ring));
 }
 
 /**
- * 读取单个几何对象
+ * 由解析出的坐标构造GEOS几何对象, 坐标移交给几何对象; 面修正闭环并统一为顺时针
  * @param geos_factory GEOS工厂对象
- * @param mif_ifs MIF输入流
- * @param res 返回的几何对象指针
- * @return 成功返回0, 失败返回-1, 文件结束返回1
+ * @param raw 几何坐标
+ * @param res 返回的几何对象指针, kNone时为nullptr
+ * @return 成功返回0, 坐标数不合法返回-1
  */
-int ReadSingleGeo(const GeometryFactory::Ptr& geos_factory,
-                  std::ifstream& mif_ifs,
-                  GeometryPtr& res) {
-  // https://baike.baidu.com/item/MIF/1416600
+static int BuildGeo(const GeometryFactory::Ptr& geos_factory, RawGeo& raw, GeometryPtr& res) {
+  switch (raw.type) {
+    case RawGeo::kNone:
+      res = nullptr;
+      return 0;
+    case RawGeo::kPoint:
+      res = GeometryPtr(geos_factory->createPoint(raw.parts[0][0]));
+      return 0;
+    case RawGeo::kLineString:
+      res = CreateLineString(geos_factory, raw.parts[0]);
+      return (res == nullptr) ? -1 : 0;
+    case RawGeo::kPolygon:
+      res = CreatePolygon(geos_factory, raw.parts[0]);
+      return (res == nullptr) ? -1 : 0;
+    case RawGeo::kRect: {
+      auto coords = std::unique_ptr<CoordinateArraySequence>(
+          new CoordinateArraySequence(std::move(raw.parts[0])));
+      auto ring = geos_factory->createLinearRing(std::move(coords));
+      res = geos_factory->createPolygon(std::move(ring));
+      return (res == nullptr) ? -1 : 0;
+    }
+    default:
+      break;
+  }
 
-  std::string line;
-  std::vector<std::string> items;
+  auto geos = std::vector<std::unique_ptr<Geometry>>(raw.num_parts);
+  for (size_t i = 0; i < raw.num_parts; ++i) {
+    if (raw.type == RawGeo::kMultiLineString) {
+      geos[i] = CreateLineString(geos_factory, raw.parts[i]);
+    } else {
+      geos[i] = CreatePolygon(geos_factory, raw.parts[i]);
+    }
+    if (geos[i] == nullptr) {
+      return -1;
+    }
+  }
+  if (raw.type == RawGeo::kMultiLineString) {
+    res = geos_factory->createMultiLineString(std::move(geos));
+  } else {
+    res = geos_factory->createMultiPolygon(std::move(geos));
+  }
+  return 0;
+}
+
+/**
+ * 将解析出的坐标追加到坐标区, 与BuildGeo做相同的坐标数检查与面的闭环、方向修正
+ * @param raw 几何坐标, 面的坐标被移交
+ * @param arena 坐标区
+ * @return 成功返回0, 坐标数不合法返回-1
+ */
+static int AppendRawGeo(RawGeo& raw, GeoArena& arena) {
+  bool is_line = (raw.type == RawGeo::kLineString || raw.type == RawGeo::kMultiLineString);
+  bool is_polygon = (raw.type == RawGeo::kPolygon || raw.type == RawGeo::kMultiPolygon);
+  if (is_line) {
+    for (size_t i = 0; i < raw.num_parts; ++i) {
+      if (raw.parts[i].size() < 2) {
+        LOG_ERROR << "read LineString coordinate size illegal: " << raw.parts[i].size()
+                  << std::endl;
+        return -1;
+      }
+    }
+  }
+  std::vector<std::unique_ptr<CoordinateArraySequence>> rings;
+  if (is_polygon) {
+    rings.resize(raw.num_parts);
+    for (size_t i = 0; i < raw.num_parts; ++i) {
+      rings[i] = CreateRingSeq(raw.parts[i]);
+      if (rings[i] == nullptr) {
+        return -1;
+      }
+    }
+  }
+
+  arena.beginGeometry(kRawGeoTypes[raw.type]);
+  for (size_t i = 0; i < raw.num_parts; ++i) {
+    if (is_polygon) {
+      arena.addRing(*rings[i]);
+    } else {
+      arena.addRing(raw.parts[i]);
+    }
+    arena.endPart();
+  }
+  arena.endGeometry();
+  return 0;
+}
+
+int ReadGeoEnvelope(TextReader& mif_reader, Envelope& env, int& geo_type) {
+  RawGeo& raw = RawGeoBuffer();
+  int status = ReadRawGeo(mif_reader, true, raw);
+  if (status != 0) {
+    return status;
+  }
+  env = raw.env;
+  geo_type = kRawGeoTypes[raw.type];
+  return 0;
+}
 
-  while (mif_ifs.good() && !mif_ifs.eof()) {
-    getline(mif_ifs, line);
+//! 跳过坐标序列, 只切分词元不解析坐标
+static int SkipCoordSeq(TextReader& mif_reader, int num_pts = -1) {
+  utils::StrView token;
+  if (num_pts < 0 && mif_reader.ReadToken(token)) {
+    num_pts = static_cast<int>(utils::to_int(token));
+  }
+  if (num_pts < 0) {
+    LOG_ERROR << "skip coordinate sequence failed, illegal num_pts: " << num_pts << std::endl;
+    return -1;
+  }
+  for (int i = 0; i < num_pts * 2; ++i) {
+    if (!mif_reader.ReadToken(token)) {
+      LOG_ERROR << "skip coordinate sequence failed, expect " << num_pts << " points" << std::endl;
+      return -1;
+    }
+  }
+  return 0;
+}
+
+int SkipSingleGeo(TextReader& mif_reader) {
+  utils::StrView line;
+  std::vector<utils::StrView>& items = TokenBuffer();
+
+  while (mif_reader.ReadLine(line)) {
     utils::StrTrimSpace(line);
     if (line.empty()) {
       continue;
     }
-    utils::StrSplit(line, " ", items);
-    utils::StrLower(items[0]);
+    utils::StrSplitSpace(line, items);
+    const utils::StrView& keyword = items[0];
 
-    if (items[0] == "none") {
-      res = nullptr;
+    if (utils::StrEqualNoCase(keyword, "none")) {
       return 0;
-    } else if (items[0] == "point") {
+    } else if (utils::StrEqualNoCase(keyword, "point")) {
       CHECK_ITEMS_SIZE(items, 3);
-      Coordinate p(utils::to_double(items[1]), utils::to_double(items[2]));
-      res = GeometryPtr(geos_factory->createPoint(p));
       return 0;
-    } else if (items[0] == "line") {
+    } else if (utils::StrEqualNoCase(keyword, "line") || utils::StrEqualNoCase(keyword, "rect")) {
       CHECK_ITEMS_SIZE(items, 5);
-      auto coords = std::unique_ptr<CoordinateArraySequence>(new CoordinateArraySequence(2));
-      coords->setAt(Coordinate(utils::to_double(items[1]), utils::to_double(items[2])), 0);
-      coords->setAt(Coordinate(utils::to_double(items[3]), utils::to_double(items[4])), 1);
-      res = geos_factory->createLineString(std::move(coords));
       return 0;
-    } else if (items[0] == "pline") {
+    } else if (utils::StrEqualNoCase(keyword, "pline")) {
       if (items.size() == 1) {
-        res = ReadLineString(geos_factory, mif_ifs);
-        return (res == nullptr) ? -1 : 0;
+        return SkipCoordSeq(mif_reader);
       } else if (items.size() == 2) {  // PLINE <coords_num>
-        res = ReadLineString(geos_factory, mif_ifs, utils::to_int(items[1]));
-        return (res == nullptr) ? -1 : 0;
+        return SkipCoordSeq(mif_reader, utils::to_int(items[1]));
       } else if (items.size() == 3) {  // PLINE MULTIPLE <geo_num>
         int geo_num = utils::to_int(items[2]);
-        auto lines = std::vector<std::unique_ptr<Geometry>>(geo_num);
         for (int i = 0; i < geo_num; ++i) {
-          lines[i] = ReadLineString(geos_factory, mif_ifs);
-          if (lines[i] == nullptr) {
+          if (SkipCoordSeq(mif_reader) != 0) {
             return -1;
           }
         }
-        res = geos_factory->createMultiLineString(std::move(lines));
         return 0;
       } else {
         LOG_ERROR << "PLINE format illegal: " << items << std::endl;
         return -1;
       }
-    } else if (items[0] == "region") {
+    } else if (utils::StrEqualNoCase(keyword, "region")) {
       CHECK_ITEMS_SIZE(items, 2);
       int geo_num = utils::to_int(items[1]);
-      if (geo_num == 1) {
-        res = ReadPolygon(geos_factory, mif_ifs);
-        return (res == nullptr) ? -1 : 0;
-      } else if (geo_num > 1) {
-        auto regions = std::vector<std::unique_ptr<Geometry>>(geo_num);
-        for (int i = 0; i < geo_num; ++i) {
-          regions[i] = ReadPolygon(geos_factory, mif_ifs);
-          if (regions[i] == nullptr) {
-            return -1;
-          }
-        }
-        res = geos_factory->createMultiPolygon(std::move(regions));
-        return 0;
-      } else {
+      if (geo_num < 1) {
         LOG_ERROR << "REGION format illegal: " << items << std::endl;
         return -1;
       }
-    } else if (items[0] == "rect") {
-      CHECK_ITEMS_SIZE(items, 5);
-      double x1(utils::to_double(items[1]));
-      double y1(utils::to_double(items[2]));
-      double x2(utils::to_double(items[3]));
-      double y2(utils::to_double(items[4]));
-      auto coords = std::unique_ptr<CoordinateArraySequence>(new CoordinateArraySequence(5));
-      coords->setAt(Coordinate(x1, y1), 0);
-      coords->setAt(Coordinate(x2, y1), 1);
-      coords->setAt(Coordinate(x2, y2), 2);
-      coords->setAt(Coordinate(x1, y2), 3);
-      coords->setAt(Coordinate(x1, y1), 4);
-      auto ring = geos_factory->createLinearRing(std::move(coords));
-      res = geos_factory->createPolygon(std::move(ring));
-      return (res == nullptr) ? -1 : 0;
-    } else if (IsStyleKeyWord(items[0])) {
+      for (int i = 0; i < geo_num; ++i) {
+        if (SkipCoordSeq(mif_reader) != 0) {
+          return -1;
+        }
+      }
+      return 0;
+    } else if (IsStyleKeyWord(keyword)) {
       // ignore and skip style line
     } else {
-      LOG_ERROR << "can`t support mif keyword: '" << items[0] << "'" << std::endl;
+      LOG_ERROR << "can`t support mif keyword: '" << keyword << "'" << std::endl;
       return -1;
     }
   }
   return 1;
 }
 
-int ReadSingleElement(const GeometryFactory::Ptr& geos_factory,
-                      std::ifstream& mif_ifs,
-                      std::ifstream& mid_ifs,
-                      const MifHeader& header,
-                      bool mid_only,
-                      MifElement& elem) {
-  AttrMap attr_map;
-  int status = ReadSingleAttr(mid_ifs, header, attr_map);
-  if (status == 0) {
-    elem.setAttrsMap(std::move(attr_map));
-  } else {
-    return status;
+//! 由解析出的坐标设置元素几何, 延迟构造时只将坐标追加到坐标区, 无几何的元素也占一项
+static int SetElementGeo(const GeometryFactory::Ptr& geos_factory,
+                         ReadContext& ctx,
+                         RawGeo& raw,
+                         MifElement& elem) {
+  if (ctx.arena != nullptr) {
+    if (AppendRawGeo(raw, *ctx.arena) != 0) {
+      return -1;
+    }
+    if (raw.type == RawGeo::kNone) {
+      elem.setGeo(nullptr);
+    } else {
+      elem.setLazyGeo(ctx.arena, ctx.arena->size() - 1);
+    }
+    return 0;
   }
+  GeometryPtr geo;
+  if (BuildGeo(geos_factory, raw, geo) != 0) {
+    return -1;
+  }
+  elem.setGeo(geo);
+  return 0;
+}
 
-  if (mid_only) {  // 仅读取MID属性, 几何对象置空
+//! 读取元素几何, 仅读取MID时几何置空
+static int ReadElementGeo(const GeometryFactory::Ptr& geos_factory,
+                          TextReader& mif_reader,
+                          ReadContext& ctx,
+                          MifElement& elem) {
+  if (ctx.mid_only) {  // 仅读取MID属性, 几何对象置空
     elem.setGeo(nullptr);
     return 0;
   }
 
-  GeometryPtr geo;
-  status = ReadSingleGeo(geos_factory, mif_ifs, geo);
-  if (status == 0) {
-    elem.setGeo(geo);
-  } else {
+  RawGeo& raw = RawGeoBuffer();
+  if (ReadRawGeo(mif_reader, false, raw) != 0) {
     return -1;  // 属性读取成功但几何读取失败, 整体失败
   }
+  return SetElementGeo(geos_factory, ctx, raw, elem);
+}
 
-  return 0;
+//! 读取下一个元素, 返回值同ReadSingleElement
+static int ReadNextElement(const GeometryFactory::Ptr& geos_factory,
+                           TextReader& mif_reader,
+                           TextReader& mid_reader,
+                           ReadContext& ctx,
+                           MifElement& elem) {
+  std::vector<utils::StrView>& items = TokenBuffer();
+  RawGeo& raw = RawGeoBuffer();
+  bool by_window = !ctx.bbox.isNull();
+  while (true) {
+    if (by_window) {
+      // 先解析坐标做范围判断, 范围外元素的MID行不切分也不解码
+      int status = ReadRawGeo(mif_reader, true, raw);
+      if (status != 0) {
+        return status;
+      }
+      if (!raw.env.intersects(ctx.bbox)) {
+        status = SkipAttrLine(mid_reader);
+        if (status != 0) {
+          return status;
+        }
+        continue;
+      }
+    }
+
+    int status = ReadAttrItems(mid_reader, ctx, items);
+    bool decoded = false;
+    if (status == 0 && ctx.predicate) {
+      // 过滤函数需要解码后的属性, 列式存储时先解码到临时属性, 通过后再追加到属性表
+      AttrMap& attrs = (ctx.table != nullptr) ? ctx.attrs : elem.mutableAttrsMap();
+      DecodeAttrs(ctx, items, attrs);
+      decoded = true;
+      if (!ctx.predicate(attrs)) {
+        status = kRowRejected;
+      }
+    }
+    if (status == kRowRejected) {
+      if (!by_window && !ctx.mid_only && SkipSingleGeo(mif_reader) != 0) {
+        LOG_ERROR << "skip geometry of filtered row failed" << std::endl;
+        return -1;
+      }
+      continue;
+    }
+    if (status != 0) {
+      return status;
+    }
+
+    if (ctx.table != nullptr) {
+      elem.setAttrRow(ctx.table, ctx.table->appendRow(items));
+    } else if (!decoded) {
+      DecodeAttrs(ctx, items, elem.mutableAttrsMap());
+    }
+    if (!by_window) {
+      return ReadElementGeo(geos_factory, mif_reader, ctx, elem);
+    }
+    if (ctx.mid_only) {
+      elem.setGeo(nullptr);
+      return 0;
+    }
+    return SetElementGeo(geos_factory, ctx, raw, elem);
+  }
+}
+
+int ReadSingleElement(const GeometryFactory::Ptr& geos_factory,
+                      TextReader& mif_reader,
+                      TextReader& mid_reader,
+                      ReadContext& ctx,
+                      MifElement& elem) {
+  int status = ReadNextElement(geos_factory, mif_reader, mid_reader, ctx, elem);
+  if (status == 1 && (mif_reader.fail() || mid_reader.fail())) {
+    LOG_ERROR << "read data failed before end of file" << std::endl;
+    return -1;
+  }
+  return status;
+}
+
+bool OpenDumpFile(const std::string& path, const DumpOptions& options, BufferedWriter& out) {
+  if (!out.Open(path + CompressionExtension(options.compression), options.buffer_size,
+                !options.compat_format)) {
+    return false;
+  }
+  if (options.compression != Compression::kNone &&
+      !out.setCompression(options.compression, options.compression_level)) {
+    out.Close();
+    return false;
+  }
+  out.setDropCache(options.drop_cache);
+  if (options.async_write) {
+    out.StartAsync(options.queue_depth);
+  }
+  return true;
 }
 
-int WriteHeader(std::ofstream& mif_ofs, const MifHeader& header) {
+int WriteHeader(BufferedWriter& mif_out, const MifHeader& header) {
   if (!check::CheckMifHeaderValid(header)) {
     return -1;
   }
 
-  mif_ofs << "Version " << header.getVersion() << "\n";
-  mif_ofs << "Charset \"" << header.getCharset() << "\"\n";
-  mif_ofs << "Delimiter \"" << header.getDelimiter() << "\"\n";
+  mif_out.Write("Version ");
+  mif_out.WriteInt(header.getVersion());
+  mif_out.Write("\nCharset \"");
+  mif_out.Write(header.getCharset());
+  mif_out.Write("\"\nDelimiter \"");
+  mif_out.Put(header.getDelimiter());
+  mif_out.Write("\"\n");
   if (!header.getUniqueVec().empty()) {
-    mif_ofs << "Unique ";
-    out_vec(mif_ofs, header.getUniqueVec());
-    mif_ofs << "\n";
+    mif_out.Write("Unique ");
+    out_vec(mif_out, header.getUniqueVec());
+    mif_out.Put('\n');
   }
   if (!header.getIndexVec().empty()) {
-    mif_ofs << "Index ";
-    out_vec(mif_ofs, header.getIndexVec());
-    mif_ofs << "\n";
+    mif_out.Write("Index ");
+    out_vec(mif_out, header.getIndexVec());
+    mif_out.Put('\n');
   }
-  mif_ofs << header.getCoordsys() << "\n";
+  mif_out.Write(header.getCoordsys());
+  mif_out.Put('\n');
   if (!header.getTransform().empty()) {
-    mif_ofs << header.getTransform() << "\n";
+    mif_out.Write(header.getTransform());
+    mif_out.Put('\n');
   }
-  mif_ofs << "Columns " << header.getColumnSize() << "\n";
+  mif_out.Write("Columns ");
+  mif_out.WriteInt(header.getColumnSize());
+  mif_out.Put('\n');
   for (size_t i = 0; i < header.getColumnSize(); ++i) {
-    mif_ofs << "    " << header.getColumnName(i) << " " << header.getColumnType(i) << "\n";
+    mif_out.Write("    ");
+    mif_out.Write(header.getColumnName(i));
+    mif_out.Put(' ');
+    mif_out.Write(header.getColumnType(i));
+    mif_out.Put('\n');
   }
-  mif_ofs << "Data\n";
+  mif_out.Write("Data\n");
 
   return 0;
 }
 
-bool WriteElementAttr(std::ofstream& mid_ofs, const MifHeader& header, MifElement& elem) {
-  char delimiter = header.getDelimiter();
-  size_t col_size = header.getColumnSize();
-  for (size_t i = 0; i < col_size; ++i) {
-    if (i != 0) {
-      mid_ofs << delimiter;
+//! 按列类型写出单个字段, val为nullptr时写出默认值
+static inline void WriteField(BufferedWriter& mid_out, ColType type, const AttrValue* val) {
+  switch (type) {
+    case ColType::kInt:
+      mid_out.WriteInt(val != nullptr ? val->getInt() : 0);
+      break;
+    case ColType::kDouble:
+      mid_out.WriteFixed(val != nullptr ? val->getDouble() : 0.0, kMidDoublePrecision);
+      break;
+    default:
+      mid_out.Put('"');
+      if (val != nullptr && val->getKind() == AttrValue::Kind::kStr) {
+        mid_out.Write(utils::StrView(val->getStrData(), val->getStrSize()));
+      } else if (val != nullptr) {
+        mid_out.Write(val->getStr());
+      }
+      mid_out.Put('"');
+      break;
+  }
+}
+
+/**
+ * 按列名归并, 得到各输出列在源中的位置
+ * @param schema 输出列表
+ * @param begin 源中按名称升序排列的元素起始
+ * @param end 源元素结束
+ * @param name_of 获取源元素的列名
+ * @param res 各输出列对应的源元素, 缺失列的first为false
+ */
+template <typename Iter, typename NameOf>
+static void MatchColumns(const ColumnSchema& schema,
+                         Iter begin,
+                         Iter end,
+                         NameOf name_of,
+                         std::vector<std::pair<bool, Iter>>& res) {
+  res.assign(schema.size(), std::make_pair(false, end));
+  Iter it = begin;
+  for (size_t index : schema.getNameOrder()) {
+    const std::string& name = schema[index].name;
+    while (it != end && name_of(it) < name) ++it;
+    if (it == end) {
+      break;
     }
+    if (name_of(it) == name) {
+      res[index] = std::make_pair(true, it);
+    }
+  }
+}
 
-    AttrValue val;
-    bool has_col = elem.getAttr(header.getColumnName(i), val);
+//! 写出列式属性表中的一行, 列类型一致时直接格式化, 否则经由AttrValue转换
+static void WriteTableRow(BufferedWriter& mid_out,
+                          const ColumnSchema& schema,
+                          const AttrTable& table,
+                          size_t row) {
+  typedef std::vector<size_t>::const_iterator Iter;
+  static thread_local std::vector<std::pair<bool, Iter>> matches;
+  const std::vector<size_t>& order = table.schema().getReadOrder();
+  MatchColumns(schema, order.begin(), order.end(),
+               [&table](Iter it) -> const std::string& { return table.schema()[*it].name; },
+               matches);
 
-    ColType col_type = GetColType(header.getColumnType(i));
-    if (col_type == ColType::kInt) {
-      mid_ofs << (has_col ? val.getInt() : 0);
-    } else if (col_type == ColType::kDouble) {
-      mid_ofs << std::fixed << (has_col ? val.getDouble() : 0.0);
+  static thread_local AttrValue val;
+  char delimiter = schema.getDelimiter();
+  for (size_t i = 0; i < schema.size(); ++i) {
+    if (i != 0) {
+      mid_out.Put(delimiter);
+    }
+    if (!matches[i].first) {
+      WriteField(mid_out, schema[i].type, nullptr);
+      continue;
+    }
+    size_t col = *matches[i].second;
+    ColType type = schema[i].type;
+    if (type != table.schema()[col].type) {
+      table.getValue(col, row, val);
+      WriteField(mid_out, type, &val);
+    } else if (type == ColType::kInt) {
+      mid_out.WriteInt(table.getInt(col, row));
+    } else if (type == ColType::kDouble) {
+      mid_out.WriteFixed(table.getDouble(col, row), kMidDoublePrecision);
     } else {
-      mid_ofs << "\"" << (has_col ? val.getStr() : "") << "\"";
+      mid_out.Put('"');
+      mid_out.Write(table.getStr(col, row));
+      mid_out.Put('"');
+    }
+  }
+  mid_out.Put('\n');
+}
+
+bool WriteElementAttr(BufferedWriter& mid_out, const ColumnSchema& schema, MifElement& elem) {
+  if (elem.getAttrTable() != nullptr) {
+    WriteTableRow(mid_out, schema, *elem.getAttrTable(), elem.getAttrRow());
+    return true;
+  }
+
+  // 按列名与AttrMap归并, 得到各列的值
+  typedef AttrMap::const_iterator Iter;
+  static thread_local std::vector<std::pair<bool, Iter>> matches;
+  const AttrMap& attrs = elem.mutableAttrsMap();
+  MatchColumns(schema, attrs.begin(), attrs.end(),
+               [](Iter it) -> const std::string& { return it->first; }, matches);
+
+  char delimiter = schema.getDelimiter();
+  for (size_t i = 0; i < schema.size(); ++i) {
+    if (i != 0) {
+      mid_out.Put(delimiter);
     }
+    WriteField(mid_out, schema[i].type, matches[i].first ? &matches[i].second->second : nullptr);
   }
-  mid_ofs << "\n";
+  mid_out.Put('\n');
   return true;
 }
 
-bool WriteElementGeo(std::ofstream& mif_ofs, const GeometryPtr& geo) {
+//! 写出坐标行
+static inline void WriteCoord(BufferedWriter& mif_out, double x, double y) {
+  mif_out.WriteFixed(x, GMIF_COORD_PRECISION);
+  mif_out.Put(' ');
+  mif_out.WriteFixed(y, GMIF_COORD_PRECISION);
+  mif_out.Put('\n');
+}
+
+//! 写出坐标数行及各坐标行
+static void WriteCoordSeq(BufferedWriter& mif_out, const CoordinateSequence& coords) {
+  mif_out.Write("  ");
+  mif_out.WriteInt(coords.size());
+  mif_out.Put('\n');
+  for (size_t i = 0; i < coords.size(); ++i) {
+    WriteCoord(mif_out, coords.getX(i), coords.getY(i));
+  }
+}
+
+bool WriteElementGeo(BufferedWriter& mif_out, const GeometryPtr& geo) {
   if (geo == nullptr) {
-    mif_ofs << "NONE\n";
+    mif_out.Write("NONE\n");
     return true;
   }
   GeometryTypeId geo_type = geo->getGeometryTypeId();
   if (geo_type == GEOS_POINT) {
     auto point = std::dynamic_pointer_cast<Point>(geo);
-    mif_ofs << "POINT " << point->getX() << " " << point->getY() << "\n";
+    mif_out.Write("POINT ");
+    WriteCoord(mif_out, point->getX(), point->getY());
   } else if (geo_type == GEOS_LINESTRING) {
     auto line = std::dynamic_pointer_cast<LineString>(geo);
-    auto coords = line->getCoordinates();
+    const CoordinateSequence* coords = line->getCoordinatesRO();
     size_t coords_size = coords->size();
     if (coords_size == 2) {
-      mif_ofs << "LINE ";
-      mif_ofs << coords->getX(0) << " " << coords->getY(0) << " ";
-      mif_ofs << coords->getX(1) << " " << coords->getY(1) << "\n";
+      mif_out.Write("LINE ");
+      mif_out.WriteFixed(coords->getX(0), GMIF_COORD_PRECISION);
+      mif_out.Put(' ');
+      mif_out.WriteFixed(coords->getY(0), GMIF_COORD_PRECISION);
+      mif_out.Put(' ');
+      WriteCoord(mif_out, coords->getX(1), coords->getY(1));
     } else if (coords_size > 2) {
-      mif_ofs << "PLINE " << coords_size << "\n";
+      mif_out.Write("PLINE ");
+      mif_out.WriteInt(coords_size);
+      mif_out.Put('\n');
       for (size_t i = 0; i < coords_size; ++i) {
-        mif_ofs << coords->getX(i) << " " << coords->getY(i) << "\n";
+        WriteCoord(mif_out, coords->getX(i), coords->getY(i));
       }
     } else {
       LOG_ERROR << "LineString size is illegal: " << coords_size << std::endl;
       return false;
     }
   } else if (geo_type == GEOS_MULTILINESTRING) {
-    auto multi_line = std::dynamic_pointer_cast<MultiLineString>(geo);
-    size_t geo_num = multi_line->getNumGeometries();
-    mif_ofs << "PLINE MULTIPLE " << geo_num << "\n";
+    size_t geo_num = geo->getNumGeometries();
+    mif_out.Write("PLINE MULTIPLE ");
+    mif_out.WriteInt(geo_num);
+    mif_out.Put('\n');
     for (size_t i = 0; i < geo_num; ++i) {
-      auto coords = multi_line->getGeometryN(i)->getCoordinates();
-      mif_ofs << "  " << coords->size() << "\n";
-      for (size_t j = 0; j < coords->size(); ++j) {
-        mif_ofs << coords->getX(j) << " " << coords->getY(j) << "\n";
-      }
+      WriteCoordSeq(mif_out, *geo->getGeometryN(i)->getCoordinates());
     }
-  } else if (geo_type == GEOS_POLYGON) {
-    auto polygon = std::dynamic_pointer_cast<Polygon>(geo);
-    auto coords = polygon->getCoordinates();
-    size_t coords_size = coords->size();
-    mif_ofs << "REGION 1\n";
-    mif_ofs << "  " << coords_size << "\n";
-    for (size_t i = 0; i < coords_size; ++i) {
-      mif_ofs << coords->getX(i) << " " << coords->getY(i) << "\n";
-    }
-  } else if (geo_type == GEOS_MULTIPOLYGON) {
-    auto multi_polygon = std::dynamic_pointer_cast<MultiPolygon>(geo);
-    size_t geo_num = multi_polygon->getNumGeometries();
-    mif_ofs << "REGION " << geo_num << "\n";
+  } else if (geo_type == GEOS_POLYGON || geo_type == GEOS_MULTIPOLYGON) {
+    size_t geo_num = geo->getNumGeometries();
+    mif_out.Write("REGION ");
+    mif_out.WriteInt(geo_num);
+    mif_out.Put('\n');
     for (size_t i = 0; i < geo_num; ++i) {
-      auto coords = multi_polygon->getGeometryN(i)->getCoordinates();
-      mif_ofs << "  " << coords->size() << "\n";
-      for (size_t j = 0; j < coords->size(); ++j) {
-        mif_ofs << coords->getX(j) << " " << coords->getY(j) << "\n";
-      }
+      WriteCoordSeq(mif_out, *geo->getGeometryN(i)->getCoordinates());
     }
   } else {
     LOG_ERROR << "can`t support dump GeometryType: '" << geo->getGeometryType() << "'" << std::endl;
@@ -524,14 +1182,92 @@ bool WriteElementGeo(std::ofstream& mif_ofs, const GeometryPtr& geo) {
   return true;
 }
 
-int WriteSingleElement(std::ofstream& mif_ofs,
-                       std::ofstream& mid_ofs,
-                       const MifHeader& header,
+/**
+ * 由坐标区写出几何对象, 输出与WriteElementGeo写出构造后的几何对象一致, 不构造GEOS几何对象
+ * @param mif_out MIF写出器
+ * @param arena 坐标区
+ * @param index 在坐标区中的编号
+ * @return 成功返回true
+ */
+static bool WriteArenaGeo(BufferedWriter& mif_out, const GeoArena& arena, size_t index) {
+  const std::vector<uint64_t>& elem_parts = arena.getElemParts();
+  const std::vector<uint64_t>& part_rings = arena.getPartRings();
+  const std::vector<uint64_t>& ring_coords = arena.getRingCoords();
+  const double* xy = arena.getCoords().data();
+  uint64_t part = elem_parts[index];
+  uint64_t num_parts = elem_parts[index + 1] - part;
+  // 部件内各环的坐标连续存放, 依次写出即与面的getCoordinates一致
+  auto part_begin = [&](uint64_t p) { return ring_coords[part_rings[p]]; };
+  auto write_parts = [&]() {
+    for (uint64_t p = part; p < part + num_parts; ++p) {
+      mif_out.Write("  ");
+      mif_out.WriteInt(part_begin(p + 1) - part_begin(p));
+      mif_out.Put('\n');
+      for (uint64_t i = part_begin(p); i < part_begin(p + 1); ++i) {
+        WriteCoord(mif_out, xy[i * 2], xy[i * 2 + 1]);
+      }
+    }
+  };
+
+  int geo_type = arena.getType(index);
+  if (geo_type < 0) {
+    mif_out.Write("NONE\n");
+  } else if (geo_type == GEOS_POINT) {
+    const double* pt = xy + part_begin(part) * 2;
+    mif_out.Write("POINT ");
+    WriteCoord(mif_out, pt[0], pt[1]);
+  } else if (geo_type == GEOS_LINESTRING) {
+    uint64_t begin = part_begin(part);
+    uint64_t coords_size = part_begin(part + 1) - begin;
+    if (coords_size == 2) {
+      const double* pts = xy + begin * 2;
+      mif_out.Write("LINE ");
+      mif_out.WriteFixed(pts[0], GMIF_COORD_PRECISION);
+      mif_out.Put(' ');
+      mif_out.WriteFixed(pts[1], GMIF_COORD_PRECISION);
+      mif_out.Put(' ');
+      WriteCoord(mif_out, pts[2], pts[3]);
+    } else if (coords_size > 2) {
+      mif_out.Write("PLINE ");
+      mif_out.WriteInt(coords_size);
+      mif_out.Put('\n');
+      for (uint64_t i = begin; i < begin + coords_size; ++i) {
+        WriteCoord(mif_out, xy[i * 2], xy[i * 2 + 1]);
+      }
+    } else {
+      LOG_ERROR << "LineString size is illegal: " << coords_size << std::endl;
+      return false;
+    }
+  } else if (geo_type == GEOS_MULTILINESTRING) {
+    mif_out.Write("PLINE MULTIPLE ");
+    mif_out.WriteInt(num_parts);
+    mif_out.Put('\n');
+    write_parts();
+  } else if (geo_type == GEOS_POLYGON || geo_type == GEOS_MULTIPOLYGON) {
+    mif_out.Write("REGION ");
+    mif_out.WriteInt(num_parts);
+    mif_out.Put('\n');
+    write_parts();
+  } else {
+    LOG_ERROR << "can`t support dump GeometryTypeId: " << geo_type << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int WriteSingleElement(BufferedWriter& mif_out,
+                       BufferedWriter& mid_out,
+                       const ColumnSchema& schema,
                        MifElement& elem) {
-  if (WriteElementAttr(mid_ofs, header, elem) && WriteElementGeo(mif_ofs, elem.getGeo())) {
-    return 0;
+  if (!WriteElementAttr(mid_out, schema, elem)) {
+    return -1;
   }
-  return -1;
+  // 尚未构造的几何对象直接由坐标区写出
+  std::shared_ptr<const GeoArena> arena;
+  size_t index = 0;
+  bool geo_ok = elem.getLazyGeo(arena, index) ? WriteArenaGeo(mif_out, *arena, index)
+                                              : WriteElementGeo(mif_out, elem.getGeo());
+  return geo_ok ? 0 : -1;
 }
 
 }  // namespace io
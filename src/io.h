@@ -4,65 +4,207 @@
 #include "gmif/gmif.h"
 #include <fstream>
 #include <geos/geom/GeometryFactory.h>
+#include "attr_table.h"
+#include "buffered_writer.h"
+#include "filter.h"
+#include "schema.h"
+#include "text_reader.h"
 
 namespace gmif {
 namespace io {
 
 /**
- * @brief 尝试打开文件, 匹配可能的扩展名
+ * @brief 尝试打开文件, 匹配可能的扩展名; 均不存在时查找加".gz"/".zst"后缀的压缩文件并流式解压
  * @param base_name 文件基础名
  * @param ext_names 备选文件扩展名几何
- * @param fin 打开的文件输入流
+ * @param use_mmap 是否优先使用内存映射, 映射失败时回退为分块读取
+ * @param reader 打开的文本读取器
  * @return 成功返回true, 失败返回false
  */
 bool TryOpenFile(const std::string& base_name,
                  const std::vector<std::string>& ext_names,
-                 std::ifstream& ifs);
+                 bool use_mmap,
+                 TextReader& reader);
+
+/**
+ * @brief 尝试内存映射文件, 匹配可能的扩展名, 失败时不输出错误
+ * @param base_name 文件基础名
+ * @param ext_names 备选文件扩展名几何
+ * @param file 映射的文件
+ * @return 成功返回true, 失败返回false
+ */
+bool TryMapFile(const std::string& base_name,
+                const std::vector<std::string>& ext_names,
+                MappedFile& file);
+
+/**
+ * @brief 查找存在的文件, 匹配可能的扩展名
+ * @param base_name 文件基础名
+ * @param ext_names 备选文件扩展名集合
+ * @param path 返回的文件路径
+ * @return 找到返回true, 否则返回false
+ */
+bool ResolveFile(const std::string& base_name,
+                 const std::vector<std::string>& ext_names,
+                 std::string& path);
 
 /**
  * @brief 读取MIF头信息
- * @param mif_ifs MIF输入流
+ * @param mif_reader MIF读取器
  * @param header MIF头对象
  * @return 成功返回0, 失败返回-1, 文件结束返回1
  */
-int ReadHeader(std::ifstream& mif_ifs, MifHeader& header);
+int ReadHeader(TextReader& mif_reader, MifHeader& header);
+
+//! 列投影: 所选列在MID行中的位置
+struct Projection {
+  Projection() : num_fields(0) {}
+
+  std::vector<size_t> source_index;  // 投影后各列在MID行中的下标, 为空表示不投影
+  size_t num_fields;                 // MID行的字段数
+};
+
+/**
+ * @brief 按列名投影MIF头, 所选列保持文件中的顺序, Unique/Index中未选中的列被移除
+ * @param header MIF头, 成功时替换为仅含所选列的MIF头
+ * @param columns 所选列名(不区分大小写), 为空表示全部列
+ * @param projection 返回的列投影
+ * @return 成功返回0, 存在未知列返回-1
+ */
+int ProjectHeader(MifHeader& header,
+                  const std::vector<std::string>& columns,
+                  Projection& projection);
+
+//! 读取计划: 列投影与属性过滤, 每次加载编译一次, 可在线程间共享
+struct ReadPlan {
+  Projection projection;                    // 列投影
+  std::shared_ptr<const RowFilter> filter;  // 属性过滤表达式, 未设置时为nullptr
+};
+
+/**
+ * @brief 编译读取计划: 先在完整的MIF头上编译过滤表达式, 再按所选列投影MIF头
+ * @param header MIF头, 成功时替换为投影后的MIF头
+ * @param options 加载选项
+ * @param plan 返回的读取计划
+ * @return 成功返回0, 失败返回-1
+ */
+int PlanRead(MifHeader& header, const LoadOptions& options, ReadPlan& plan);
+
+//! 单个读取流的属性解码状态, 不可跨线程共享
+struct ReadContext {
+  /**
+   * @param header MIF头, 启用投影时为投影后的MIF头
+   * @param options 加载选项
+   * @param plan 读取计划
+   */
+  ReadContext(const MifHeader& header,
+              const LoadOptions& options,
+              const ReadPlan& plan = ReadPlan());
+
+  ColumnSchema schema;                            // 由MIF头编译的列表
+  Projection projection;                          // 列投影
+  std::shared_ptr<const RowFilter> filter;        // 属性过滤表达式, 未设置时为nullptr
+  std::function<bool(const AttrMap&)> predicate;  // 属性过滤函数, 未设置时为空
+  geos::geom::Envelope bbox;                      // 查询范围, 为空时不做范围过滤
+  size_t max_fields;                              // 每行切分的字段数上限, 其后的字段只计数不切分
+  bool mid_only;                                  // 是否只解析MID数据
+  std::shared_ptr<AttrTable> table;               // 列式属性表, 未启用列式存储时为nullptr
+  std::vector<StrPool> pools;                     // 各列字符串驻留池, 未启用驻留时为空
+  std::shared_ptr<GeoArena> arena;                // 延迟构造几何时的坐标区, 否则为nullptr
+  AttrMap attrs;                                  // 列式存储时供过滤函数求值的临时属性
+  size_t rows;                                    // 已读取的属性行数
+};
+
+/**
+ * @brief 读取单个几何对象的类型与外包框, 不构造GEOS几何对象
+ * @param mif_reader MIF读取器
+ * @param env 返回的外包框, 无几何时为空
+ * @param geo_type 返回将构造的GEOS几何类型(GeometryTypeId), 无几何时为-1
+ * @return 成功返回0, 失败返回-1, 文件结束返回1
+ */
+int ReadGeoEnvelope(TextReader& mif_reader, geos::geom::Envelope& env, int& geo_type);
+
+/**
+ * @brief 跳过单行MID, 不切分字段
+ * @param mid_reader MID读取器
+ * @return 成功返回0, 文件结束返回1
+ */
+int SkipAttrLine(TextReader& mid_reader);
+
+/**
+ * @brief 跳过单个几何对象, 只扫描坐标词元, 不解析坐标也不构造几何对象
+ * @param mif_reader MIF读取器
+ * @return 成功返回0, 失败返回-1, 文件结束返回1
+ */
+int SkipSingleGeo(TextReader& mif_reader);
 
 /**
- * @brief 读取单个元素
+ * @brief 读取单个元素, 启用列式存储时属性追加到属性表, 元素关联新增的行;
+ * 未通过范围过滤或属性过滤的元素被跳过, 继续读取下一个元素.
+ * 设置查询范围时先解析几何坐标, 范围相交后才读取MID行并构造GEOS几何对象
  * @param geos_factory GEOS工厂对象
- * @param mif_ifs MIF输入流
- * @param mid_ifs MID输入流
- * @param header MIF头对象
- * @param mid_only 是否只解析MID数据
+ * @param mif_reader MIF读取器
+ * @param mid_reader MID读取器
+ * @param ctx 解码状态
  * @param elem 返回的元素对象
- * @return 成功返回0, 失败返回-1, 文件结束返回1
+ * @return 成功返回0, 失败(含数据源读取或解压失败)返回-1, 文件结束返回1
  */
 int ReadSingleElement(const geos::geom::GeometryFactory::Ptr& geos_factory,
-                      std::ifstream& mif_ifs,
-                      std::ifstream& mid_ifs,
-                      const MifHeader& header,
-                      bool mid_only,
+                      TextReader& mif_reader,
+                      TextReader& mid_reader,
+                      ReadContext& ctx,
                       MifElement& elem);
 
+/**
+ * @brief 多线程并行加载图层: 预扫描记录边界, 分块并行解析后按原顺序合并
+ * @param layer_path 图层路径, 不带MID/MIF后缀
+ * @param options 加载选项
+ * @param res 返回的Mif对象
+ * @param error 返回的失败原因
+ * @return 成功返回0, 失败返回-1, 文件无法内存映射返回1(调用方应回退为顺序加载)
+ */
+int LoadParallel(const std::string& layer_path,
+                 const LoadOptions& options,
+                 Mif& res,
+                 std::string& error);
+
+/**
+ * @brief 多线程保存: 工作线程将连续的元素段分别格式化到内存缓冲区, 调用线程按元素顺序写入文件
+ * @param mif Mif对象
+ * @param out_layer_path 图层路径, 不带MIF/MID后缀
+ * @param options 保存选项
+ * @return 成功返回0, 失败返回-1
+ */
+int DumpParallel(Mif& mif, const std::string& out_layer_path, const DumpOptions& options);
+
+/**
+ * @brief 按保存选项创建写出文件
+ * @param path 文件路径, 压缩输出时追加压缩格式的后缀
+ * @param options 保存选项
+ * @param out 写出器
+ * @return 成功返回true, 失败返回false
+ */
+bool OpenDumpFile(const std::string& path, const DumpOptions& options, BufferedWriter& out);
+
 /**
  * @brief 写入MIF头信息
- * @param mif_ofs MIF输出流
+ * @param mif_out MIF写出器
  * @param header MIF头对象
  * @return 成功返回0, 失败返回-1
  */
-int WriteHeader(std::ofstream& mif_ofs, const MifHeader& header);
+int WriteHeader(BufferedWriter& mif_out, const MifHeader& header);
 
 /**
  * @brief 写入MIF元素信息
- * @param mif_ofs MIF输出流
- * @param mid_ofs MID输出流
- * @param header MIF头对象
+ * @param mif_out MIF写出器
+ * @param mid_out MID写出器
+ * @param schema 由MIF头编译的列表
  * @param elem MIF元素对象
  * @return 成功返回0, 失败返回-1
  */
-int WriteSingleElement(std::ofstream& mif_ofs,
-                       std::ofstream& mid_ofs,
-                       const MifHeader& header,
+int WriteSingleElement(BufferedWriter& mif_out,
+                       BufferedWriter& mid_out,
+                       const ColumnSchema& schema,
                        MifElement& elem);
 }  // namespace io
 }  // namespace gmif
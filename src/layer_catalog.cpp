@@ -0,0 +1,238 @@
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "gmif/gmif.h"
+#include "attr_table.h"
+#include "offset_index.h"
+#include "utils.h"
+
+namespace gmif {
+
+//! 缓存项, 加载期间已在目录中登记, 用于合并同一图层的并发加载
+struct CatalogEntry {
+  io::FileStamp mif_stamp;
+  io::FileStamp mid_stamp;
+  std::shared_ptr<const Mif> mif;  // 加载失败时为nullptr
+  size_t base_charge = 0;          // 加载后估计的内存占用
+  size_t charge = 0;               // 计入预算的内存占用, 含列式属性表的行解码缓存
+  std::vector<const AttrTable*> tables;  // 图层关联的列式属性表
+  bool loading = true;
+  bool cached = false;  // 是否在LRU链表中
+  std::list<std::string>::iterator lru_pos;
+};
+
+struct LayerCatalog::Impl {
+  //! 移除缓存项, 需持有锁
+  void Erase(std::unordered_map<std::string, std::shared_ptr<CatalogEntry>>::iterator it);
+  //! 重新计入各缓存项的行解码缓存, 再按最近最少使用淘汰缓存项直到不超出预算, 需持有锁
+  void Evict();
+
+  LayerCatalogOptions options;
+  mutable std::mutex mutex;
+  std::condition_variable loaded;
+  std::unordered_map<std::string, std::shared_ptr<CatalogEntry>> entries;
+  std::list<std::string> lru;  // 已缓存的图层路径, 最近使用的在前
+  size_t usage = 0;
+};
+
+void LayerCatalog::Impl::Erase(
+    std::unordered_map<std::string, std::shared_ptr<CatalogEntry>>::iterator it) {
+  CatalogEntry& entry = *it->second;
+  if (entry.cached) {
+    lru.erase(entry.lru_pos);
+    usage -= entry.charge;
+    entry.cached = false;
+  }
+  entries.erase(it);
+}
+
+void LayerCatalog::Impl::Evict() {
+  for (const std::string& layer_path : lru) {
+    CatalogEntry& entry = *entries.find(layer_path)->second;
+    size_t charge = entry.base_charge;
+    for (const AttrTable* table : entry.tables) {
+      charge += table->cacheMemory();
+    }
+    usage = usage - entry.charge + charge;
+    entry.charge = charge;
+  }
+  while (options.memory_budget > 0 && usage > options.memory_budget && !lru.empty()) {
+    Erase(entries.find(lru.back()));
+  }
+}
+
+//! 元素对象及其共享指针控制块的估计大小
+static const size_t kElementOverhead = sizeof(MifElement) + 2 * sizeof(void*);
+//! 每个GEOS几何对象及其坐标序列的估计开销, 不含坐标
+static const size_t kGeometryOverhead = 160;
+
+//! 坐标区占用的内存字节数(按容量计)
+static size_t ArenaMemory(const GeoArena& arena) {
+  return sizeof(GeoArena) + arena.getTypes().capacity() * sizeof(int32_t) +
+         (arena.getElemParts().capacity() + arena.getPartRings().capacity() +
+          arena.getRingCoords().capacity()) *
+             sizeof(uint64_t) +
+         arena.getCoords().capacity() * sizeof(double);
+}
+
+/**
+ * @brief 估计图层占用的内存, 按容量计入元素、属性、GEOS几何对象以及共享的坐标区与列式属性表;
+ * 共享字符串不计入. 列式属性表的行解码缓存随只读访问增长, 由调用方按tables另行计入
+ * @param mif 图层
+ * @param tables 返回图层关联的列式属性表
+ * @return 估计的字节数
+ */
+static size_t EstimateMemory(const Mif& mif, std::vector<const AttrTable*>& tables) {
+  ConstElementsView elements = mif.elements();
+  size_t usage = sizeof(Mif) + elements.size() * sizeof(std::shared_ptr<MifElement>);
+  std::unordered_set<const GeoArena*> arenas;
+  std::unordered_set<const AttrTable*> table_set;
+  if (mif.arena() != nullptr) {
+    arenas.insert(mif.arena());
+  }
+  for (size_t i = 0; i < elements.size(); ++i) {
+    const MifElement* elem = elements.get(i);
+    if (elem == nullptr) {
+      continue;
+    }
+    usage += kElementOverhead;
+    if (elem->getAttrTable() != nullptr) {
+      table_set.insert(elem->getAttrTable().get());
+    } else {
+      usage += AttrMapMemory(elem->getAttrsMap());
+    }
+    std::shared_ptr<const GeoArena> arena;
+    size_t index = 0;
+    if (elem->getLazyGeo(arena, index)) {  // 坐标在坐标区中, 不构造几何对象
+      arenas.insert(arena.get());
+    } else if (elem->getGeo() != nullptr) {
+      const geos::geom::Geometry& geo = *elem->getGeo();
+      usage += geo.getNumGeometries() * kGeometryOverhead +
+               geo.getNumPoints() * sizeof(geos::geom::Coordinate);
+    }
+  }
+  for (const GeoArena* arena : arenas) {
+    usage += ArenaMemory(*arena);
+  }
+  tables.assign(table_set.begin(), table_set.end());
+  for (const AttrTable* table : tables) {
+    usage += table->memoryUsage();
+  }
+  return usage;
+}
+
+LayerCatalog::LayerCatalog(const LayerCatalogOptions& options) : impl_(new Impl) {
+  impl_->options = options;
+}
+
+LayerCatalog::~LayerCatalog() = default;
+
+std::shared_ptr<const Mif> LayerCatalog::Get(const std::string& layer_path) {
+  io::FileStamp mif_stamp;
+  io::FileStamp mid_stamp;
+  if (io::StatLayerFiles(layer_path, mif_stamp, mid_stamp) != 0) {
+    LOG_ERROR << "can`t stat layer: '" << layer_path << ".[mid/mif]'" << std::endl;
+    Invalidate(layer_path);
+    return nullptr;
+  }
+
+  Impl& impl = *impl_;
+  std::unique_lock<std::mutex> lock(impl.mutex);
+  std::shared_ptr<CatalogEntry> entry;
+  while (true) {
+    auto it = impl.entries.find(layer_path);
+    if (it == impl.entries.end()) {
+      break;
+    }
+    entry = it->second;
+    bool fresh = entry->mif_stamp == mif_stamp && entry->mid_stamp == mid_stamp;
+    if (entry->loading) {
+      impl.loaded.wait(lock, [&]() { return !entry->loading; });
+      if (fresh) {
+        return entry->mif;  // 合并到同一次加载, 失败时同样返回nullptr
+      }
+      continue;  // 等待的是旧版本文件的加载, 重新查找
+    }
+    if (fresh) {
+      impl.lru.splice(impl.lru.begin(), impl.lru, entry->lru_pos);
+      impl.Evict();  // 只读访问可能产生了新的行解码缓存
+      return entry->mif;
+    }
+    impl.Erase(it);  // 图层文件已变化
+    break;
+  }
+
+  entry = std::make_shared<CatalogEntry>();
+  entry->mif_stamp = mif_stamp;
+  entry->mid_stamp = mid_stamp;
+  impl.entries[layer_path] = entry;
+  lock.unlock();
+
+  std::shared_ptr<const Mif> mif;
+  try {
+    mif = Mif::Load(layer_path, impl.options.load);
+  } catch (...) {
+    lock.lock();
+    entry->loading = false;
+    auto it = impl.entries.find(layer_path);
+    if (it != impl.entries.end() && it->second == entry) {
+      impl.entries.erase(it);
+    }
+    impl.loaded.notify_all();
+    throw;
+  }
+
+  std::vector<const AttrTable*> tables;
+  size_t charge = (mif == nullptr) ? 0 : EstimateMemory(*mif, tables);
+  lock.lock();
+  entry->mif = mif;
+  entry->base_charge = charge;
+  entry->charge = charge;
+  entry->tables = std::move(tables);
+  entry->loading = false;
+  auto it = impl.entries.find(layer_path);
+  if (it != impl.entries.end() && it->second == entry) {  // 加载期间未被移除
+    if (mif == nullptr) {
+      impl.entries.erase(it);  // 不缓存失败结果, 下次获取时重新加载
+    } else {
+      impl.lru.push_front(layer_path);
+      entry->lru_pos = impl.lru.begin();
+      entry->cached = true;
+      impl.usage += entry->charge;
+      impl.Evict();
+    }
+  }
+  impl.loaded.notify_all();
+  return mif;
+}
+
+void LayerCatalog::Invalidate(const std::string& layer_path) {
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  auto it = impl_->entries.find(layer_path);
+  if (it != impl_->entries.end()) {
+    impl_->Erase(it);
+  }
+}
+
+void LayerCatalog::Clear() {
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  impl_->entries.clear();
+  impl_->lru.clear();
+  impl_->usage = 0;
+}
+
+size_t LayerCatalog::size() const {
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  return impl_->lru.size();
+}
+
+size_t LayerCatalog::memoryUsage() const {
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  impl_->Evict();
+  return impl_->usage;
+}
+
+}  // namespace gmif
@@ -0,0 +1,56 @@
+#include "mapped_file.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace gmif {
+namespace io {
+
+bool MappedFile::Open(const std::string& path) {
+  Close();
+#ifdef _WIN32
+  return false;
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close(fd);
+    return false;
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_ > 0) {
+    void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      close(fd);
+      size_ = 0;
+      return false;
+    }
+    madvise(addr, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(addr);
+  }
+  close(fd);  // 映射建立后即可关闭描述符
+  is_open_ = true;
+  return true;
+#endif
+}
+
+void MappedFile::Close() {
+#ifndef _WIN32
+  if (data_ != nullptr) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+#endif
+  data_ = nullptr;
+  size_ = 0;
+  is_open_ = false;
+}
+
+}  // namespace io
+}  // namespace gmif
@@ -0,0 +1,42 @@
+#ifndef GMIF_SRC_MAPPED_FILE_H_
+#define GMIF_SRC_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+namespace gmif {
+namespace io {
+
+//! 只读内存映射文件
+class MappedFile {
+ public:
+  MappedFile() : data_(nullptr), size_(0), is_open_(false) {}
+  ~MappedFile() { Close(); }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /**
+   * @brief 映射整个文件
+   * @param path 文件路径
+   * @return 成功返回true, 失败(文件不存在或平台不支持)返回false
+   */
+  bool Open(const std::string& path);
+
+  //! 解除映射
+  void Close();
+
+  bool isOpen() const { return is_open_; }
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  const char* data_;
+  size_t size_;
+  bool is_open_;
+};
+
+}  // namespace io
+}  // namespace gmif
+
+#endif  // GMIF_SRC_MAPPED_FILE_H_
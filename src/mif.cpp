@@ -1,8 +1,23 @@
 #include <geos/geom/GeometryFactory.h>
-#include <iomanip>
 #include "gmif/gmif.h"
+#include "binary_cache.h"
+#include "compression.h"
 #include "io.h"
+#include "offset_index.h"
+#include "parallel.h"
 #include "utils.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <glob.h>
+#endif
 
 #ifdef GMIF_SHOW_TIME
 #include <chrono>
@@ -12,77 +27,311 @@ using namespace geos::geom;
 
 namespace gmif {
 
+//! 行号区间[first, second)
+typedef std::pair<size_t, size_t> RowRange;
+
+/**
+ * 单线程逐个读取元素
+ * @param layer_path 图层路径
+ * @param options 加载选项
+ * @param index 偏移索引, 为nullptr时读取整个图层
+ * @param ranges 依次读取的行号区间, 仅在index不为nullptr时使用
+ * @param res 返回的Mif对象
+ * @param error 返回的失败原因
+ * @return 成功返回0, 失败返回-1
+ */
+static int LoadSequential(const std::string& layer_path,
+                          const LoadOptions& options,
+                          const io::OffsetIndex* index,
+                          const std::vector<RowRange>& ranges,
+                          Mif& res,
+                          std::string& error) {
+  io::TextReader mif_reader;
+  io::TextReader mid_reader;
+  if (!(io::TryOpenFile(layer_path, {"mif", "MIF", "Mif"}, options.use_mmap, mif_reader) &&
+        io::TryOpenFile(layer_path, {"mid", "MID", "Mid"}, options.use_mmap, mid_reader))) {
+    error = "can't open mif/mid file";
+    return -1;
+  }
+  if (io::ReadHeader(mif_reader, res.header()) != 0) {
+    error = "read header failed";
+    LOG_ERROR << error << std::endl;
+    return -1;
+  }
+  io::ReadPlan plan;
+  if (io::PlanRead(res.header(), options, plan) != 0) {
+    error = "compile filter or resolve columns failed";
+    return -1;
+  }
+
+  PrecisionModel pm(GMIF_COORD_PRECISION, 0, 0);
+  auto geos_factory = GeometryFactory::create(&pm, -1);
+  io::ReadContext ctx(res.header(), options, plan);
+  size_t num_ranges = (index == nullptr) ? 1 : ranges.size();
+  for (size_t k = 0; k < num_ranges; ++k) {
+    size_t first_row = (index == nullptr) ? 0 : ranges[k].first;
+    size_t range_rows = ctx.rows;  // 本区间之前已读取的MID行数
+    if (index != nullptr) {  // 读取器限定在区间内, 读到区间结束即视为数据结束
+      const RowRange& range = ranges[k];
+      if (!(mif_reader.Seek(index->getMifOffset(range.first), index->getMifOffset(range.second)) &&
+            mid_reader.Seek(index->getMidOffset(range.first), index->getMidOffset(range.second)))) {
+        error = "seek to row " + std::to_string(range.first) + " failed";
+        LOG_ERROR << error << std::endl;
+        return -1;
+      }
+    }
+    while (true) {
+      std::shared_ptr<MifElement> elem = std::make_shared<MifElement>();
+      int status = io::ReadSingleElement(geos_factory, mif_reader, mid_reader, ctx, *elem);
+      if (status == 0) {
+        res.elements().push_back(elem);
+      } else if (status == 1) {
+        break;  // eof
+      } else {
+        error = "read feature failed near row " + std::to_string(first_row + ctx.rows - range_rows);
+        LOG_ERROR << error << std::endl;
+        return -1;
+      }
+    }
+  }
+  if (ctx.table != nullptr) {
+    ctx.table->Shrink();
+  }
+  if (ctx.arena != nullptr) {
+    ctx.arena->shrink();
+    res.setArena(ctx.arena);
+  }
+  return 0;
+}
+
 std::unique_ptr<Mif> Mif::Load(const std::string& layer_path, bool mid_only) {
+  LoadOptions options;
+  options.mid_only = mid_only;
+  return Load(layer_path, options);
+}
+
+/**
+ * 加载整个图层, 同Mif::Load
+ * @param layer_path 图层路径
+ * @param options 加载选项
+ * @param error 返回的失败原因
+ * @return 成功返回Mif对象指针, 失败返回nullptr
+ */
+static std::unique_ptr<Mif> LoadLayer(const std::string& layer_path,
+                                      const LoadOptions& options,
+                                      std::string& error) {
 #ifdef GMIF_SHOW_TIME
   auto start = std::chrono::system_clock::now();
 #endif
-  std::ifstream mif_ifs;
-  std::ifstream mid_ifs;
-  if (!(io::TryOpenFile(layer_path, {"mif", "MIF", "Mif"}, mif_ifs) &&
-        io::TryOpenFile(layer_path, {"mid", "MID", "Mid"}, mid_ifs))) {
+  std::unique_ptr<Mif> res = std::unique_ptr<Mif>(new Mif);
+  int status = 1;
+  if (options.num_threads != 1 && options.use_mmap) {
+    status = io::LoadParallel(layer_path, options, *res, error);
+    if (status < 0) {
+      return nullptr;
+    }
+  }
+  // 单线程或无法内存映射
+  if (status == 1 && LoadSequential(layer_path, options, nullptr, {}, *res, error) != 0) {
     return nullptr;
   }
+#ifdef GMIF_SHOW_TIME
+  auto end = std::chrono::system_clock::now();
+  auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+  auto etime = double(duration.count()) * std::chrono::microseconds::period::num /
+               std::chrono::microseconds::period::den;
+  std::cout << "load mif '" << layer_path << "' elapsed time: " << etime << "s" << std::endl;
+#endif
+  return res;
+}
+
+std::unique_ptr<Mif> Mif::Load(const std::string& layer_path, const LoadOptions& options) {
+  std::string error;
+  return LoadLayer(layer_path, options, error);
+}
+
+std::vector<LayerLoadResult> Mif::LoadBatch(const std::vector<std::string>& layer_paths,
+                                            const BatchLoadOptions& options) {
+  std::vector<LayerLoadResult> res(layer_paths.size());
+  LoadBatch(layer_paths, options, [&](size_t i, LayerLoadResult& result) {
+    res[i] = std::move(result);
+  });
+  return res;
+}
+
+size_t Mif::LoadBatch(const std::vector<std::string>& layer_paths,
+                      const BatchLoadOptions& options,
+                      const std::function<void(size_t, LayerLoadResult&)>& on_loaded) {
+  // GEOS工厂的引用计数非线程安全, 且图层可能交给其他线程释放, 各图层仍使用Load内的独立工厂
+  std::atomic<size_t> num_failed(0);
+  parallel::ParallelFor(layer_paths.size(), options.num_threads, [&](size_t i) {
+    LayerLoadResult result;
+    result.layer_path = layer_paths[i];
+    try {
+      result.mif = LoadLayer(layer_paths[i], options.load, result.error);
+    } catch (const std::exception& e) {
+      result.mif.reset();
+      result.error = e.what();
+    }
+    if (result.mif == nullptr) {
+      LOG_ERROR << "load layer '" << layer_paths[i] << "' failed: " << result.error << std::endl;
+      ++num_failed;
+    }
+    on_loaded(i, result);
+  });
+  return num_failed;
+}
+
+/**
+ * 按通配符匹配文件, 无匹配或读取目录失败时返回空列表
+ * @param pattern 文件路径通配符, Windows下只有最后一级可含通配符
+ * @return 匹配的文件路径
+ */
+static std::vector<std::string> MatchFiles(const std::string& pattern) {
+  std::vector<std::string> paths;
+#ifdef _WIN32
+  size_t pos = pattern.find_last_of("/\\");
+  std::string dir = (pos == std::string::npos) ? "" : pattern.substr(0, pos + 1);
+  WIN32_FIND_DATAA data;
+  HANDLE handle = FindFirstFileA(pattern.c_str(), &data);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return paths;
+  }
+  do {
+    if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
+      paths.push_back(dir + data.cFileName);
+    }
+  } while (FindNextFileA(handle, &data));
+  FindClose(handle);
+#else
+  glob_t matches;
+  if (glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+    paths.assign(matches.gl_pathv, matches.gl_pathv + matches.gl_pathc);
+  }
+  globfree(&matches);
+#endif
+  return paths;
+}
 
+std::vector<std::string> Mif::ListLayers(const std::string& pattern) {
+  std::vector<std::string> layers;
+  for (std::string path : MatchFiles(pattern)) {
+    for (Compression compression : {Compression::kGzip, Compression::kZstd}) {
+      std::string ext = io::CompressionExtension(compression);
+      if (path.size() > ext.size() &&
+          path.compare(path.size() - ext.size(), ext.size(), ext) == 0) {
+        path.resize(path.size() - ext.size());
+        break;
+      }
+    }
+    // 与加载时查找的后缀一致
+    for (const char* ext : {".mif", ".MIF", ".Mif"}) {
+      if (path.size() > 4 && path.compare(path.size() - 4, 4, ext) == 0) {
+        layers.push_back(path.substr(0, path.size() - 4));
+        break;
+      }
+    }
+  }
+  std::sort(layers.begin(), layers.end());
+  layers.erase(std::unique(layers.begin(), layers.end()), layers.end());
+  return layers;
+}
+
+bool Mif::BuildOffsetIndex(const std::string& layer_path) {
+  io::OffsetIndex index;
+  return index.Build(layer_path) == 0 && index.Save(layer_path) == 0;
+}
+
+std::unique_ptr<Mif> Mif::LoadRange(const std::string& layer_path,
+                                    size_t begin,
+                                    size_t count,
+                                    const LoadOptions& options) {
+  io::OffsetIndex index;
+  if (index.Load(layer_path) != 0) {
+    return nullptr;
+  }
+  if (begin > index.size()) {
+    LOG_ERROR << "row " << begin << " out of range " << index.size() << std::endl;
+    return nullptr;
+  }
+  std::vector<RowRange> ranges(1, RowRange(begin, begin + std::min(count, index.size() - begin)));
   std::unique_ptr<Mif> res = std::unique_ptr<Mif>(new Mif);
-  if (io::ReadHeader(mif_ifs, res->header()) != 0) {
-    LOG_ERROR << "read header failed" << std::endl;
+  std::string error;
+  if (LoadSequential(layer_path, options, &index, ranges, *res, error) != 0) {
     return nullptr;
   }
+  return res;
+}
 
-  PrecisionModel pm(GMIF_COORD_PRECISION, 0, 0);
-  auto geos_factory = GeometryFactory::create(&pm, -1);
-
-  while (mid_ifs.good() && !mid_ifs.eof()) {
-    std::shared_ptr<MifElement> elem = std::make_shared<MifElement>();
-    int status =
-        io::ReadSingleElement(geos_factory, mif_ifs, mid_ifs, res->header(), mid_only, *elem);
-    if (status == 0) {
-      res->elements_.push_back(elem);
-    } else if (status == 1) {
-      break;  // eof
-    } else {
-      LOG_ERROR << "read feature failed" << std::endl;
+std::unique_ptr<Mif> Mif::LoadRows(const std::string& layer_path,
+                                   const std::vector<size_t>& rows,
+                                   const LoadOptions& options) {
+  io::OffsetIndex index;
+  if (index.Load(layer_path) != 0) {
+    return nullptr;
+  }
+  std::vector<RowRange> ranges;
+  ranges.reserve(rows.size());
+  for (size_t row : rows) {
+    if (row >= index.size()) {
+      LOG_ERROR << "row " << row << " out of range " << index.size() << std::endl;
       return nullptr;
     }
+    ranges.emplace_back(row, row + 1);
+  }
+  std::unique_ptr<Mif> res = std::unique_ptr<Mif>(new Mif);
+  std::string error;
+  if (LoadSequential(layer_path, options, &index, ranges, *res, error) != 0) {
+    return nullptr;
+  }
+  return res;
+}
+
+std::unique_ptr<Mif> Mif::LoadBinary(const std::string& layer_path, const LoadOptions& options) {
+#ifdef GMIF_SHOW_TIME
+  auto start = std::chrono::system_clock::now();
+#endif
+  std::unique_ptr<Mif> res = std::unique_ptr<Mif>(new Mif);
+  if (io::ReadBinaryCache(layer_path, options, *res) != 0) {
+    return nullptr;
   }
 #ifdef GMIF_SHOW_TIME
   auto end = std::chrono::system_clock::now();
   auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
   auto etime = double(duration.count()) * std::chrono::microseconds::period::num /
                std::chrono::microseconds::period::den;
-  std::cout << "load mif '" << layer_path << "' elapsed time: " << etime << "s" << std::endl;
+  std::cout << "load binary '" << layer_path << "' elapsed time: " << etime << "s" << std::endl;
 #endif
   return res;
 }
 
-bool Mif::Dump(const std::string& out_layer_path) {
-  std::string mif_file = out_layer_path + ".mif";
-  std::string mid_file = out_layer_path + ".mid";
-
-  std::ofstream mif_fout(mif_file.c_str(), std::ios_base::out | std::ios_base::trunc);
-  std::ofstream mid_fout(mid_file.c_str(), std::ios_base::out | std::ios_base::trunc);
+void Mif::BuildIndex(size_t num_threads) {
+  std::shared_ptr<SpatialIndex> index = std::make_shared<SpatialIndex>();
+  index->Build(elements_, num_threads);
+  index_ = index;
+}
 
-  if (mif_fout.fail() || mid_fout.fail()) {
-    LOG_ERROR << "can`t open dump file: '" << out_layer_path << ".[mid/mif]'" << std::endl;
+bool Mif::Dump(const std::string& out_layer_path, const DumpOptions& options) {
+  if (options.num_threads != 1) {
+    return io::DumpParallel(*this, out_layer_path, options) == 0;
+  }
+  MifOStream ofs;
+  if (!ofs.Open(out_layer_path, header_, options)) {
     return false;
   }
 
-  mif_fout << std::setprecision(GMIF_COORD_PRECISION) << std::fixed;
-
-  io::WriteHeader(mif_fout, header_);
-
   for (size_t i = 0; i < elements_.size(); ++i) {
-    if (elements_[i] == nullptr) {
+    if (elements_[i] == nullptr || ofs.Write(*(elements_[i])) != 0) {
       LOG_ERROR << "dump element[" << i << "] failed." << std::endl;
       return false;
     }
-    io::WriteSingleElement(mif_fout, mid_fout, header_, *(elements_[i]));
   }
 
-  mif_fout.close();
-  mid_fout.close();
+  return ofs.Close();
+}
 
-  return true;
+bool Mif::DumpBinary(const std::string& out_layer_path) {
+  return io::WriteBinaryCache(*this, out_layer_path) == 0;
 }
 
 }  // namespace gmif
\ No newline at end of file
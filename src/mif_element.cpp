@@ -1,12 +1,210 @@
 #include "gmif/gmif.h"
+#include <mutex>
+#include <stdexcept>
+#include "attr_table.h"
 
 namespace gmif {
 
-bool MifElement::hasColumn(const std::string& col_lower_name) noexcept {
+//! 按元素地址分片的互斥锁, 保护延迟几何对象的构造与属性表行的解码缓存
+static std::mutex& GeoMutex(const MifElement* elem) {
+  static std::mutex mutexes[64];
+  return mutexes[(reinterpret_cast<uintptr_t>(elem) / sizeof(void*)) % 64];
+}
+
+MifElement::MifElement(const MifElement& rhs)
+    : geo_index_(0),
+      geo_pending_(false),
+      attr_table_(rhs.attr_table_),
+      attr_row_(rhs.attr_row_),
+      attrs_cached_(false) {
+  std::lock_guard<std::mutex> lock(GeoMutex(&rhs));
+  geo_ = rhs.geo_;
+  geo_arena_ = rhs.geo_arena_;
+  geo_index_ = rhs.geo_index_;
+  geo_pending_.store(rhs.geo_pending_.load(std::memory_order_relaxed), std::memory_order_release);
+  if (attr_table_ == nullptr || rhs.attrs_cached_.load(std::memory_order_relaxed)) {
+    attrs_map_ = rhs.attrs_map_;
+    attrs_cached_.store(attr_table_ != nullptr, std::memory_order_release);
+  }
+  if (attrs_cached_.load(std::memory_order_relaxed)) {
+    attr_table_->addCacheMemory(AttrMapMemory(attrs_map_));
+  }
+}
+
+MifElement& MifElement::operator=(const MifElement& rhs) {
+  if (this == &rhs) {
+    return *this;
+  }
+  GeometryPtr geo;
+  std::shared_ptr<const GeoArena> geo_arena;
+  size_t geo_index = 0;
+  bool pending = false;
+  AttrMap attrs;
+  bool cached = false;
+  {
+    std::lock_guard<std::mutex> lock(GeoMutex(&rhs));
+    geo = rhs.geo_;
+    geo_arena = rhs.geo_arena_;
+    geo_index = rhs.geo_index_;
+    pending = rhs.geo_pending_.load(std::memory_order_relaxed);
+    cached = rhs.attrs_cached_.load(std::memory_order_relaxed);
+    if (rhs.attr_table_ == nullptr || cached) {
+      attrs = rhs.attrs_map_;
+    }
+  }
+  geo_ = std::move(geo);
+  geo_arena_ = std::move(geo_arena);
+  geo_index_ = geo_index;
+  geo_pending_.store(pending, std::memory_order_release);
+  releaseAttrsCache();
+  attrs_map_ = std::move(attrs);
+  attr_table_ = rhs.attr_table_;
+  attr_row_ = rhs.attr_row_;
+  attrs_cached_.store(cached, std::memory_order_release);
+  if (cached) {
+    attr_table_->addCacheMemory(AttrMapMemory(attrs_map_));
+  }
+  return *this;
+}
+
+MifElement::~MifElement() {
+  releaseAttrsCache();
+}
+
+const GeometryPtr& MifElement::getGeo() const {
+  if (geo_pending_.load(std::memory_order_acquire)) {
+    materializeGeo();
+  }
+  return geo_;
+}
+
+void MifElement::setGeo(const GeometryPtr& geo) {
+  geo_ = geo;
+  geo_arena_.reset();
+  geo_pending_.store(false, std::memory_order_release);
+}
+
+void MifElement::setLazyGeo(const std::shared_ptr<const GeoArena>& arena, size_t index) {
+  geo_.reset();
+  geo_arena_ = arena;
+  geo_index_ = index;
+  geo_pending_.store(arena != nullptr, std::memory_order_release);
+}
+
+bool MifElement::getLazyGeo(std::shared_ptr<const GeoArena>& arena, size_t& index) const {
+  if (!geo_pending_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(GeoMutex(this));
+  if (!geo_pending_.load(std::memory_order_relaxed)) {
+    return false;  // 已由其他线程构造
+  }
+  arena = geo_arena_;
+  index = geo_index_;
+  return true;
+}
+
+void MifElement::materializeGeo() const {
+  std::lock_guard<std::mutex> lock(GeoMutex(this));
+  if (!geo_pending_.load(std::memory_order_relaxed)) {
+    return;  // 已由其他线程构造
+  }
+  if (geo_arena_->toGeometry(geo_index_, geo_) != 0) {
+    LOG_ERROR << "build lazy geometry[" << geo_index_ << "] failed" << std::endl;
+    geo_.reset();
+  }
+  geo_arena_.reset();
+  geo_pending_.store(false, std::memory_order_release);
+}
+
+const AttrMap& MifElement::getAttrsMap() const {
+  if (attr_table_ != nullptr && !attrs_cached_.load(std::memory_order_acquire)) {
+    cacheAttrs();
+  }
+  return attrs_map_;
+}
+
+AttrMap& MifElement::mutableAttrsMap() {
+  materialize();
+  return attrs_map_;
+}
+
+void MifElement::setAttrsMap(const AttrMap& attrs_map) {
+  releaseAttrsCache();
+  attr_table_.reset();
+  attrs_cached_.store(false, std::memory_order_release);
+  attrs_map_ = attrs_map;
+}
+
+void MifElement::setAttrsMap(AttrMap&& attrs_map) {
+  releaseAttrsCache();
+  attr_table_.reset();
+  attrs_cached_.store(false, std::memory_order_release);
+  attrs_map_ = std::move(attrs_map);
+}
+
+void MifElement::setAttrRow(const std::shared_ptr<const AttrTable>& table, size_t row) {
+  releaseAttrsCache();
+  attrs_map_.clear();
+  attrs_cached_.store(false, std::memory_order_release);
+  attr_table_ = table;
+  attr_row_ = row;
+}
+
+void MifElement::materialize() {
+  if (attr_table_ == nullptr) {
+    return;
+  }
+  if (attrs_cached_.load(std::memory_order_acquire)) {
+    releaseAttrsCache();  // 缓存转为元素自有的属性
+  } else {
+    decodeAttrRow(attrs_map_);
+  }
+  attr_table_.reset();
+  attrs_cached_.store(false, std::memory_order_release);
+}
+
+void MifElement::cacheAttrs() const {
+  std::lock_guard<std::mutex> lock(GeoMutex(this));
+  if (attrs_cached_.load(std::memory_order_relaxed)) {
+    return;  // 已由其他线程解码
+  }
+  decodeAttrRow(attrs_map_);
+  attr_table_->addCacheMemory(AttrMapMemory(attrs_map_));
+  attrs_cached_.store(true, std::memory_order_release);
+}
+
+void MifElement::releaseAttrsCache() {
+  if (attr_table_ != nullptr && attrs_cached_.load(std::memory_order_acquire)) {
+    attr_table_->subCacheMemory(AttrMapMemory(attrs_map_));
+  }
+}
+
+void MifElement::decodeAttrRow(AttrMap& res) const {
+  res.clear();
+  const io::ColumnSchema& schema = attr_table_->schema();
+  for (size_t col : schema.getReadOrder()) {
+    auto it = res.emplace_hint(res.end(), schema[col].name, AttrValue());
+    attr_table_->getValue(col, attr_row_, it->second);
+  }
+}
+
+bool MifElement::hasColumn(const std::string& col_lower_name) const noexcept {
+  if (attr_table_ != nullptr) {
+    return attr_table_->schema().findColumn(col_lower_name) >= 0;
+  }
   return attrs_map_.count(col_lower_name) > 0;
 }
 
-bool MifElement::getAttr(const std::string& col_lower_name, AttrValue& res_val) noexcept {
+bool MifElement::getAttr(const std::string& col_lower_name, AttrValue& res_val) const noexcept {
+  if (attr_table_ != nullptr) {
+    int32_t col = attr_table_->schema().findColumn(col_lower_name);
+    if (col < 0) {
+      return false;
+    }
+    attr_table_->getValue(col, attr_row_, res_val);
+    return true;
+  }
   if (!hasColumn(col_lower_name)) {
     return false;
   }
@@ -15,11 +213,26 @@ bool MifElement::getAttr(const std::string& col_lower_name, AttrValue& res_val)
 }
 
 AttrValue& MifElement::getAttr(const std::string& col_lower_name) {
+  materialize();
+  return attrs_map_.at(col_lower_name);
+}
+
+AttrValue MifElement::getAttr(const std::string& col_lower_name) const {
+  if (attr_table_ != nullptr) {
+    int32_t col = attr_table_->schema().findColumn(col_lower_name);
+    if (col < 0) {
+      throw std::out_of_range("no column: " + col_lower_name);
+    }
+    AttrValue res_val;
+    attr_table_->getValue(col, attr_row_, res_val);
+    return res_val;
+  }
   return attrs_map_.at(col_lower_name);
 }
 
 void MifElement::addOrUpdateAttr(const std::string& col_lower_name, const AttrValue& val) noexcept {
+  materialize();
   attrs_map_[col_lower_name] = val;
 }
 
-}  // namespace gmif
\ No newline at end of file
+}  // namespace gmif
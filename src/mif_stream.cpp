@@ -0,0 +1,163 @@
+#include <geos/geom/GeometryFactory.h>
+#include "gmif/gmif.h"
+#include "io.h"
+#include "offset_index.h"
+#include "utils.h"
+
+using namespace geos::geom;
+
+namespace gmif {
+
+struct MifIStream::Impl {
+  Impl() : pm(GMIF_COORD_PRECISION, 0, 0), geos_factory(GeometryFactory::create(&pm, -1)) {}
+
+  PrecisionModel pm;
+  GeometryFactory::Ptr geos_factory;
+  io::TextReader mif_reader;
+  io::TextReader mid_reader;
+  std::unique_ptr<io::ReadContext> ctx;
+  std::unique_ptr<io::OffsetIndex> index;  // 偏移索引, 首次Seek时加载
+};
+
+MifIStream::MifIStream() = default;
+
+MifIStream::~MifIStream() = default;
+
+bool MifIStream::Open(const std::string& layer_path, const LoadOptions& options) {
+  Close();
+  std::unique_ptr<Impl> impl(new Impl);
+  if (!(io::TryOpenFile(layer_path, {"mif", "MIF", "Mif"}, options.use_mmap, impl->mif_reader) &&
+        io::TryOpenFile(layer_path, {"mid", "MID", "Mid"}, options.use_mmap, impl->mid_reader))) {
+    return false;
+  }
+  if (io::ReadHeader(impl->mif_reader, header_) != 0) {
+    LOG_ERROR << "read header failed" << std::endl;
+    header_ = MifHeader();
+    return false;
+  }
+  io::ReadPlan plan;
+  if (io::PlanRead(header_, options, plan) != 0) {
+    header_ = MifHeader();
+    return false;
+  }
+  options_ = options;
+  options_.columnar_attrs = false;  // 流式读取不累积属性表
+  impl->ctx.reset(new io::ReadContext(header_, options_, plan));
+  impl_ = std::move(impl);
+  layer_path_ = layer_path;
+  return true;
+}
+
+void MifIStream::Close() {
+  impl_.reset();
+  layer_path_.clear();
+  header_ = MifHeader();
+}
+
+bool MifIStream::isOpen() const {
+  return impl_ != nullptr;
+}
+
+int MifIStream::Read(MifElement& elem) {
+  if (impl_ == nullptr) {
+    LOG_ERROR << "read from unopened MifIStream" << std::endl;
+    return -1;
+  }
+  if (impl_->ctx->arena != nullptr) {
+    // 返回的元素可能交给其他线程, 每个元素使用独立的坐标区, 避免与后续读取共享
+    impl_->ctx->arena = std::make_shared<GeoArena>();
+  }
+  return io::ReadSingleElement(impl_->geos_factory, impl_->mif_reader, impl_->mid_reader,
+                               *impl_->ctx, elem);
+}
+
+bool MifIStream::Seek(size_t row) {
+  if (impl_ == nullptr) {
+    LOG_ERROR << "seek in unopened MifIStream" << std::endl;
+    return false;
+  }
+  if (impl_->index == nullptr) {
+    std::unique_ptr<io::OffsetIndex> index(new io::OffsetIndex);
+    if (index->Load(layer_path_) != 0) {
+      return false;
+    }
+    impl_->index = std::move(index);
+  }
+  const io::OffsetIndex& index = *impl_->index;
+  if (row > index.size()) {
+    LOG_ERROR << "seek row " << row << " out of range " << index.size() << std::endl;
+    return false;
+  }
+  return impl_->mif_reader.Seek(index.getMifOffset(row)) &&
+         impl_->mid_reader.Seek(index.getMidOffset(row));
+}
+
+struct MifOStream::Impl {
+  io::BufferedWriter mif_out;
+  io::BufferedWriter mid_out;
+  io::ColumnSchema schema;
+};
+
+MifOStream::MifOStream() = default;
+
+MifOStream::~MifOStream() {
+  Close();
+}
+
+bool MifOStream::Open(const std::string& out_layer_path,
+                      const MifHeader& header,
+                      const DumpOptions& options) {
+  Close();
+  std::string mif_file = out_layer_path + ".mif";
+  std::string mid_file = out_layer_path + ".mid";
+
+  std::unique_ptr<Impl> impl(new Impl);
+  if (!io::OpenDumpFile(mif_file, options, impl->mif_out) ||
+      !io::OpenDumpFile(mid_file, options, impl->mid_out)) {
+    LOG_ERROR << "can`t open dump file: '" << out_layer_path << ".[mid/mif]'" << std::endl;
+    return false;
+  }
+
+  if (io::WriteHeader(impl->mif_out, header) != 0) {
+    LOG_ERROR << "write header failed: '" << out_layer_path << ".mif'" << std::endl;
+    return false;
+  }
+  impl->schema.Compile(header);
+  header_ = header;
+  impl_ = std::move(impl);
+  return true;
+}
+
+bool MifOStream::Flush() {
+  if (impl_ == nullptr) {
+    return false;
+  }
+  bool mif_ok = impl_->mif_out.Flush();
+  bool mid_ok = impl_->mid_out.Flush();
+  return mif_ok && mid_ok;
+}
+
+bool MifOStream::Close() {
+  if (impl_ == nullptr) {
+    return true;
+  }
+  bool mif_ok = impl_->mif_out.Close();
+  bool mid_ok = impl_->mid_out.Close();
+  impl_.reset();
+  header_ = MifHeader();
+  return mif_ok && mid_ok;
+}
+
+bool MifOStream::isOpen() const {
+  return impl_ != nullptr;
+}
+
+int MifOStream::Write(MifElement& elem) {
+  if (impl_ == nullptr) {
+    LOG_ERROR << "write to unopened MifOStream" << std::endl;
+    return -1;
+  }
+  return io::WriteSingleElement(impl_->mif_out, impl_->mid_out, impl_->schema, elem);
+}
+
+}  // namespace gmif
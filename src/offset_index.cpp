@@ -0,0 +1,209 @@
+#include "offset_index.h"
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <cstring>
+#include <fstream>
+#include "compression.h"
+#include "io.h"
+#include "utils.h"
+
+namespace gmif {
+namespace io {
+
+const char* const OffsetIndex::kExtension = "gmifx";
+
+static const char kIndexMagic[8] = {'G', 'M', 'I', 'F', 'X', '\0', '\0', '\0'};
+static const uint32_t kIndexVersion = 2;  // 2: 修改时间精确到纳秒
+
+//! 索引文件头
+struct IndexFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t entry_size;
+  FileStamp mif_stamp;
+  FileStamp mid_stamp;
+  uint64_t count;
+};
+
+int StatFile(const std::string& path, FileStamp& stamp) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {
+    return -1;
+  }
+  stamp.size = static_cast<uint64_t>(st.st_size);
+  stamp.mtime = static_cast<int64_t>(st.st_mtime) * 1000000000;
+#if defined(__APPLE__)
+  stamp.mtime += st.st_mtimespec.tv_nsec;
+#elif !defined(_WIN32)
+  stamp.mtime += st.st_mtim.tv_nsec;
+#endif
+  return 0;
+}
+
+//! 按扩展名查找图层文件并获取时间戳, 未压缩文件不存在时取压缩文件
+static int StatLayerFile(const std::string& layer_path,
+                         const std::vector<std::string>& ext_names,
+                         FileStamp& stamp) {
+  std::string path;
+  if (!ResolveFile(layer_path, ext_names, path)) {
+    for (Compression compression : {Compression::kGzip, Compression::kZstd}) {
+      std::vector<std::string> compressed_names;
+      for (const auto& ext : ext_names) {
+        compressed_names.push_back(ext + CompressionExtension(compression));
+      }
+      if (ResolveFile(layer_path, compressed_names, path)) {
+        break;
+      }
+    }
+  }
+  return path.empty() ? -1 : StatFile(path, stamp);
+}
+
+int StatLayerFiles(const std::string& layer_path, FileStamp& mif_stamp, FileStamp& mid_stamp) {
+  if (StatLayerFile(layer_path, {"mif", "MIF", "Mif"}, mif_stamp) != 0 ||
+      StatLayerFile(layer_path, {"mid", "MID", "Mid"}, mid_stamp) != 0) {
+    return -1;
+  }
+  return 0;
+}
+
+int OffsetIndex::StatLayer(const std::string& layer_path,
+                           FileStamp& mif_stamp,
+                           FileStamp& mid_stamp) {
+  std::string mif_path, mid_path;
+  if (!(ResolveFile(layer_path, {"mif", "MIF", "Mif"}, mif_path) &&
+        ResolveFile(layer_path, {"mid", "MID", "Mid"}, mid_path))) {
+    return -1;
+  }
+  if (StatFile(mif_path, mif_stamp) != 0 || StatFile(mid_path, mid_stamp) != 0) {
+    return -1;
+  }
+  return 0;
+}
+
+int OffsetIndex::Build(const std::string& layer_path) {
+  records_.clear();
+  if (StatLayer(layer_path, mif_stamp_, mid_stamp_) != 0) {
+    LOG_ERROR << "stat layer '" << layer_path << "' failed" << std::endl;
+    return -1;
+  }
+  TextReader mif_reader;
+  TextReader mid_reader;
+  if (!(TryOpenFile(layer_path, {"mif", "MIF", "Mif"}, true, mif_reader) &&
+        TryOpenFile(layer_path, {"mid", "MID", "Mid"}, true, mid_reader))) {
+    return -1;
+  }
+  MifHeader header;
+  if (ReadHeader(mif_reader, header) != 0) {
+    LOG_ERROR << "read header failed" << std::endl;
+    return -1;
+  }
+
+  geos::geom::Envelope env;
+  while (true) {
+    RecordEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.mif_offset = mif_reader.offset();
+    entry.mid_offset = mid_reader.offset();
+    int status = ReadGeoEnvelope(mif_reader, env, entry.geo_type);
+    if (status == 0) {
+      status = SkipAttrLine(mid_reader);
+    }
+    if (status == 1) {
+      break;
+    } else if (status != 0) {
+      LOG_ERROR << "scan record[" << records_.size() << "] failed" << std::endl;
+      records_.clear();
+      return -1;
+    }
+    if (env.isNull()) {
+      entry.minx = entry.miny = 0;
+      entry.maxx = entry.maxy = -1;
+    } else {
+      entry.minx = env.getMinX();
+      entry.miny = env.getMinY();
+      entry.maxx = env.getMaxX();
+      entry.maxy = env.getMaxY();
+    }
+    records_.push_back(entry);
+  }
+  return 0;
+}
+
+int OffsetIndex::Save(const std::string& layer_path) const {
+  std::string path = layer_path + "." + kExtension;
+  std::ofstream ofs(path.c_str(), std::ios_base::out | std::ios_base::binary);
+  if (!ofs.is_open()) {
+    LOG_ERROR << "open '" << path << "' failed" << std::endl;
+    return -1;
+  }
+  IndexFileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kIndexMagic, sizeof(kIndexMagic));
+  header.version = kIndexVersion;
+  header.entry_size = sizeof(RecordEntry);
+  header.mif_stamp = mif_stamp_;
+  header.mid_stamp = mid_stamp_;
+  header.count = records_.size();
+  ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  if (!records_.empty()) {
+    ofs.write(reinterpret_cast<const char*>(records_.data()),
+              records_.size() * sizeof(RecordEntry));
+  }
+  ofs.close();
+  if (ofs.fail()) {
+    LOG_ERROR << "write '" << path << "' failed" << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+int OffsetIndex::Load(const std::string& layer_path) {
+  records_.clear();
+  std::string path = layer_path + "." + kExtension;
+  std::ifstream ifs(path.c_str(), std::ios_base::in | std::ios_base::binary);
+  if (!ifs.is_open()) {
+    LOG_ERROR << "offset index '" << path << "' not found" << std::endl;
+    return -1;
+  }
+  ifs.seekg(0, std::ios_base::end);
+  uint64_t file_size = static_cast<uint64_t>(ifs.tellg());
+  ifs.seekg(0, std::ios_base::beg);
+  IndexFileHeader header;
+  ifs.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (ifs.gcount() != sizeof(header) || memcmp(header.magic, kIndexMagic, sizeof(kIndexMagic)) ||
+      header.version != kIndexVersion || header.entry_size != sizeof(RecordEntry) ||
+      (file_size - sizeof(header)) / sizeof(RecordEntry) != header.count) {
+    LOG_ERROR << "offset index '" << path << "' is invalid" << std::endl;
+    return -1;
+  }
+  FileStamp mif_stamp, mid_stamp;
+  if (StatLayer(layer_path, mif_stamp, mid_stamp) != 0 || !(mif_stamp == header.mif_stamp) ||
+      !(mid_stamp == header.mid_stamp)) {
+    LOG_ERROR << "offset index '" << path << "' is out of date" << std::endl;
+    return -1;
+  }
+  records_.resize(header.count);
+  if (header.count > 0) {
+    ifs.read(reinterpret_cast<char*>(records_.data()), header.count * sizeof(RecordEntry));
+    if (static_cast<uint64_t>(ifs.gcount()) != header.count * sizeof(RecordEntry)) {
+      LOG_ERROR << "read offset index '" << path << "' failed" << std::endl;
+      records_.clear();
+      return -1;
+    }
+  }
+  mif_stamp_ = mif_stamp;
+  mid_stamp_ = mid_stamp;
+  return 0;
+}
+
+uint64_t OffsetIndex::getMifOffset(size_t row) const {
+  return (row < records_.size()) ? records_[row].mif_offset : mif_stamp_.size;
+}
+
+uint64_t OffsetIndex::getMidOffset(size_t row) const {
+  return (row < records_.size()) ? records_[row].mid_offset : mid_stamp_.size;
+}
+
+}  // namespace io
+}  // namespace gmif
@@ -0,0 +1,97 @@
+#ifndef GMIF_SRC_OFFSET_INDEX_H_
+#define GMIF_SRC_OFFSET_INDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gmif {
+namespace io {
+
+//! 偏移索引中的单条记录
+struct RecordEntry {
+  uint64_t mif_offset;            // 几何对象在MIF中的起始偏移, 包含其前的样式行
+  uint64_t mid_offset;            // 属性行在MID中的起始偏移
+  double minx, miny, maxx, maxy;  // 几何外包框, 无几何时minx > maxx
+  int32_t geo_type;               // 将构造的GEOS几何类型(GeometryTypeId), 无几何时为-1
+  uint32_t reserved;
+};
+
+//! 文件大小与修改时间, 用于判断索引是否过期
+struct FileStamp {
+  uint64_t size;
+  int64_t mtime;  // 纳秒, 平台不支持时精确到秒
+
+  bool operator==(const FileStamp& rhs) const { return size == rhs.size && mtime == rhs.mtime; }
+};
+
+/**
+ * @brief 获取文件的大小与修改时间
+ * @param path 文件路径
+ * @param stamp 返回的时间戳
+ * @return 成功返回0, 失败返回-1
+ */
+int StatFile(const std::string& path, FileStamp& stamp);
+
+/**
+ * @brief 获取图层MIF与MID文件的时间戳, 未压缩文件不存在时取压缩文件, 与Mif::Load的查找顺序一致
+ * @param layer_path 图层路径, 不带后缀
+ * @param mif_stamp 返回的MIF文件时间戳
+ * @param mid_stamp 返回的MID文件时间戳
+ * @return 成功返回0, 任一文件不存在时返回-1
+ */
+int StatLayerFiles(const std::string& layer_path, FileStamp& mif_stamp, FileStamp& mid_stamp);
+
+/**
+ * @brief 图层的记录偏移索引, 保存在图层旁的layer.gmifx文件中, 支持按行号随机访问
+ *
+ * 文件格式(本机字节序): 文件头(魔数、版本、记录大小、MIF/MID文件的大小与修改时间、记录数),
+ * 其后为连续的RecordEntry数组. 任一图层文件的大小或修改时间变化后索引失效.
+ */
+class OffsetIndex {
+ public:
+  //! 索引文件扩展名
+  static const char* const kExtension;
+
+  /**
+   * @brief 扫描图层生成索引, 不构造几何对象也不解码属性
+   * @param layer_path 图层路径, 不带MID/MIF后缀
+   * @return 成功返回0, 失败返回-1
+   */
+  int Build(const std::string& layer_path);
+
+  /**
+   * @brief 写入索引文件
+   * @param layer_path 图层路径, 索引写入layer_path.gmifx
+   * @return 成功返回0, 失败返回-1
+   */
+  int Save(const std::string& layer_path) const;
+
+  /**
+   * @brief 读取索引文件并校验图层文件的大小与修改时间
+   * @param layer_path 图层路径
+   * @return 成功返回0, 索引不存在、损坏或已过期返回-1
+   */
+  int Load(const std::string& layer_path);
+
+  //! 记录数
+  size_t size() const { return records_.size(); }
+  const RecordEntry& operator[](size_t row) const { return records_[row]; }
+
+  //! 第row条记录在MIF/MID中的起始偏移, row等于记录数时为文件大小
+  uint64_t getMifOffset(size_t row) const;
+  uint64_t getMidOffset(size_t row) const;
+
+ private:
+  //! 获取图层MIF/MID文件的时间戳
+  static int StatLayer(const std::string& layer_path, FileStamp& mif_stamp, FileStamp& mid_stamp);
+
+  FileStamp mif_stamp_;
+  FileStamp mid_stamp_;
+  std::vector<RecordEntry> records_;
+};
+
+}  // namespace io
+}  // namespace gmif
+
+#endif  // GMIF_SRC_OFFSET_INDEX_H_
@@ -0,0 +1,28 @@
+#ifndef GMIF_SRC_PARALLEL_H_
+#define GMIF_SRC_PARALLEL_H_
+
+#include <cstddef>
+#include <functional>
+
+namespace gmif {
+namespace parallel {
+
+/**
+ * @brief 获取实际线程数
+ * @param num_threads 期望线程数, 0表示使用硬件并发数
+ * @return 不小于1的线程数
+ */
+size_t ResolveThreads(size_t num_threads);
+
+/**
+ * @brief 并行执行fn(0), fn(1), ..., fn(n-1), 任务按下标动态分配给线程
+ * @param n 任务数
+ * @param num_threads 线程数, 0表示使用硬件并发数
+ * @param fn 任务函数, 抛出的第一个异常在调用线程重新抛出
+ */
+void ParallelFor(size_t n, size_t num_threads, const std::function<void(size_t)>& fn);
+
+}  // namespace parallel
+}  // namespace gmif
+
+#endif  // GMIF_SRC_PARALLEL_H_
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "io.h"
+#include "parallel.h"
+#include "utils.h"
+
+namespace gmif {
+namespace io {
+
+//! 每个线程分配的任务块数, 用于平衡各块几何复杂度差异
+static const size_t kChunksPerThread = 4;
+//! 每个任务块的最大元素数, 限制单块缓冲区大小
+static const size_t kMaxChunkElements = 4096;
+//! 每个线程可领先于写出位置的任务块数, 限制内存中已格式化未写出的数据量
+static const size_t kPendingPerThread = 2;
+//! 任务块缓冲区的初始大小, 不足时扩容, 缓冲区在任务块间复用
+static const size_t kChunkBufferSize = 1 << 16;
+
+//! 任务块的格式化结果, 按块号对槽位数取模复用
+struct DumpSlot {
+  BufferedWriter mif_out;
+  BufferedWriter mid_out;
+  bool ready = false;
+};
+
+int DumpParallel(Mif& mif, const std::string& out_layer_path, const DumpOptions& options) {
+  std::string mif_file = out_layer_path + ".mif";
+  std::string mid_file = out_layer_path + ".mid";
+  BufferedWriter mif_out;
+  BufferedWriter mid_out;
+  if (!OpenDumpFile(mif_file, options, mif_out) || !OpenDumpFile(mid_file, options, mid_out)) {
+    LOG_ERROR << "can`t open dump file: '" << out_layer_path << ".[mid/mif]'" << std::endl;
+    return -1;
+  }
+  if (WriteHeader(mif_out, mif.header()) != 0) {
+    LOG_ERROR << "write header failed: '" << mif_file << "'" << std::endl;
+    return -1;
+  }
+  ColumnSchema schema;
+  schema.Compile(mif.header());
+
+  const auto& elements = mif.elements();
+  size_t num_elements = elements.size();
+  size_t num_threads = parallel::ResolveThreads(options.num_threads);
+  size_t chunk_size = (num_elements + num_threads * kChunksPerThread - 1) /
+                      (num_threads * kChunksPerThread);
+  chunk_size = std::max<size_t>(1, std::min(chunk_size, kMaxChunkElements));
+  size_t num_chunks = (num_elements + chunk_size - 1) / chunk_size;
+  num_threads = std::min(num_threads, num_chunks);
+  std::vector<DumpSlot> slots(num_threads * kPendingPerThread);
+  for (auto& slot : slots) {
+    slot.mif_out.OpenMemory(kChunkBufferSize, !options.compat_format);
+    slot.mid_out.OpenMemory(kChunkBufferSize, !options.compat_format);
+  }
+
+  // 工作线程领取块号next_chunk, 领先写出位置written不超过槽位数; 调用线程按块号顺序写出
+  std::mutex mutex;
+  std::condition_variable slot_free;
+  std::condition_variable slot_ready;
+  size_t next_chunk = 0;
+  size_t written = 0;
+  bool failed = false;
+  auto worker = [&]() {
+    while (true) {
+      size_t k;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (failed || next_chunk == num_chunks) {
+          return;
+        }
+        k = next_chunk++;
+        slot_free.wait(lock, [&]() { return failed || k < written + slots.size(); });
+        if (failed) {
+          return;
+        }
+      }
+      DumpSlot& slot = slots[k % slots.size()];
+      bool ok = true;
+      size_t end = std::min(num_elements, (k + 1) * chunk_size);
+      for (size_t i = k * chunk_size; i < end; ++i) {
+        if (elements[i] == nullptr ||
+            WriteSingleElement(slot.mif_out, slot.mid_out, schema, *elements[i]) != 0) {
+          LOG_ERROR << "dump element[" << i << "] failed." << std::endl;
+          ok = false;
+          break;
+        }
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      if (ok) {
+        slot.ready = true;
+      } else {
+        failed = true;
+        slot_free.notify_all();
+      }
+      slot_ready.notify_one();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (size_t t = 0; t < num_threads; ++t) {
+    threads.emplace_back(worker);
+  }
+  for (size_t k = 0; k < num_chunks; ++k) {
+    DumpSlot& slot = slots[k % slots.size()];
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      slot_ready.wait(lock, [&]() { return failed || slot.ready; });
+      if (failed) {
+        break;
+      }
+    }
+    // 槽位就绪后只由调用线程访问, 直到written推进
+    mif_out.Write(utils::StrView(slot.mif_out.data(), slot.mif_out.size()));
+    mid_out.Write(utils::StrView(slot.mid_out.data(), slot.mid_out.size()));
+    slot.mif_out.Clear();
+    slot.mid_out.Clear();
+    bool write_ok = !mif_out.fail() && !mid_out.fail();
+    std::lock_guard<std::mutex> lock(mutex);
+    slot.ready = false;
+    ++written;
+    if (!write_ok) {
+      LOG_ERROR << "write dump file failed: '" << out_layer_path << ".[mid/mif]'" << std::endl;
+      failed = true;
+    }
+    slot_free.notify_all();
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  bool mif_ok = mif_out.Close();
+  bool mid_ok = mid_out.Close();
+  return !failed && mif_ok && mid_ok ? 0 : -1;
+}
+
+}  // namespace io
+}  // namespace gmif
@@ -0,0 +1,195 @@
+#include <geos/geom/GeometryFactory.h>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include "io.h"
+#include "parallel.h"
+#include "scanner.h"
+#include "utils.h"
+
+using namespace geos::geom;
+
+namespace gmif {
+namespace io {
+
+//! 每个线程分配的任务块数, 用于平衡各块几何复杂度差异
+static const size_t kChunksPerThread = 4;
+
+typedef size_t (*CountFunc)(const char*, const char*);
+typedef const char* (*FindFunc)(const char*, const char*, size_t);
+
+//! 按行对齐的数据片段及其记录数统计
+struct SliceIndex {
+  std::vector<const char*> bounds;  // 片段边界, 大小为片段数 + 1
+  std::vector<size_t> first_rows;   // 各片段首条记录的全局下标, 末尾为记录总数
+};
+
+static SliceIndex BuildSliceIndex(const char* begin,
+                                  const char* end,
+                                  size_t num_slices,
+                                  size_t num_threads,
+                                  CountFunc count_func) {
+  SliceIndex index;
+  index.bounds = SplitLines(begin, end, num_slices);
+  std::vector<size_t> counts(num_slices);
+  parallel::ParallelFor(num_slices, num_threads, [&](size_t i) {
+    counts[i] = count_func(index.bounds[i], index.bounds[i + 1]);
+  });
+  index.first_rows.assign(num_slices + 1, 0);
+  for (size_t i = 0; i < num_slices; ++i) {
+    index.first_rows[i + 1] = index.first_rows[i] + counts[i];
+  }
+  return index;
+}
+
+/**
+ * 计算各任务块的起始地址
+ * @param index 片段统计
+ * @param chunk_rows 各任务块起始记录下标
+ * @param num_threads 线程数
+ * @param find_func 片段内记录定位函数
+ * @return 各任务块起始地址, 大小为chunk_rows.size() + 1, 末尾为数据结束地址
+ */
+static std::vector<const char*> LocateChunks(const SliceIndex& index,
+                                             const std::vector<size_t>& chunk_rows,
+                                             size_t num_threads,
+                                             FindFunc find_func) {
+  size_t num_slices = index.bounds.size() - 1;
+  const char* end = index.bounds.back();
+  std::vector<const char*> starts(chunk_rows.size() + 1, end);
+  parallel::ParallelFor(chunk_rows.size(), num_threads, [&](size_t k) {
+    size_t row = chunk_rows[k];
+    auto it = std::upper_bound(index.first_rows.begin(), index.first_rows.end(), row);
+    size_t slice = (it - index.first_rows.begin()) - 1;
+    if (slice < num_slices) {  // 超出记录总数的块定位到数据末尾
+      starts[k] = find_func(index.bounds[slice], index.bounds[slice + 1],
+                            row - index.first_rows[slice]);
+    }
+  });
+  return starts;
+}
+
+int LoadParallel(const std::string& layer_path,
+                 const LoadOptions& options,
+                 Mif& res,
+                 std::string& error) {
+  MappedFile mif_file;
+  MappedFile mid_file;
+  if (!(TryMapFile(layer_path, {"mif", "MIF", "Mif"}, mif_file) &&
+        TryMapFile(layer_path, {"mid", "MID", "Mid"}, mid_file))) {
+    return 1;
+  }
+
+  TextReader header_reader;
+  header_reader.Reset(mif_file.data(), mif_file.data() + mif_file.size());
+  if (ReadHeader(header_reader, res.header()) != 0) {
+    error = "read header failed";
+    LOG_ERROR << error << std::endl;
+    return -1;
+  }
+  ReadPlan plan;
+  if (PlanRead(res.header(), options, plan) != 0) {
+    error = "compile filter or resolve columns failed";
+    return -1;
+  }
+  const char* mif_begin = header_reader.position();
+  const char* mif_end = mif_file.data() + mif_file.size();
+  const char* mid_begin = mid_file.data();
+  const char* mid_end = mid_file.data() + mid_file.size();
+
+  // 以MID行数为准划分任务块, 每块记录数相同
+  size_t num_threads = parallel::ResolveThreads(options.num_threads);
+  size_t num_slices = num_threads * kChunksPerThread;
+  SliceIndex mid_index = BuildSliceIndex(mid_begin, mid_end, num_slices, num_threads, CountMidRows);
+  size_t total_rows = mid_index.first_rows.back();
+  if (total_rows == 0) {
+    if (options.lazy_geo && !options.mid_only) {
+      res.setArena(std::make_shared<GeoArena>());
+    }
+    return 0;
+  }
+  size_t num_chunks = std::min(num_slices, total_rows);
+  std::vector<size_t> chunk_rows(num_chunks);
+  for (size_t k = 0; k < num_chunks; ++k) {
+    chunk_rows[k] = total_rows * k / num_chunks;
+  }
+  auto mid_starts = LocateChunks(mid_index, chunk_rows, num_threads, FindMidRow);
+  std::vector<const char*> mif_starts(num_chunks + 1, mif_end);
+  if (!options.mid_only || !options.bbox.isNull()) {  // 范围过滤需要扫描MIF
+    SliceIndex mif_index =
+        BuildSliceIndex(mif_begin, mif_end, num_slices, num_threads, CountMifRecords);
+    mif_starts = LocateChunks(mif_index, chunk_rows, num_threads, FindMifRecord);
+  }
+
+  std::vector<std::vector<std::shared_ptr<MifElement>>> chunk_elems(num_chunks);
+  std::vector<std::shared_ptr<GeoArena>> chunk_arenas(num_chunks);
+  std::atomic<bool> failed(false);
+  parallel::ParallelFor(num_chunks, num_threads, [&](size_t k) {
+    if (failed) {
+      return;
+    }
+    // GEOS工厂的引用计数非线程安全, 每个任务块使用独立工厂
+    PrecisionModel pm(GMIF_COORD_PRECISION, 0, 0);
+    auto geos_factory = GeometryFactory::create(&pm, -1);
+    TextReader mif_reader;
+    TextReader mid_reader;
+    mif_reader.Reset(mif_starts[k], mif_starts[k + 1]);
+    mid_reader.Reset(mid_starts[k], mid_starts[k + 1]);
+
+    // 各任务块独立的解码状态, 启用列式存储时块内元素共享属性表
+    ReadContext ctx(res.header(), options, plan);
+    auto& elems = chunk_elems[k];
+    while (true) {
+      std::shared_ptr<MifElement> elem = std::make_shared<MifElement>();
+      int status = ReadSingleElement(geos_factory, mif_reader, mid_reader, ctx, *elem);
+      if (status == 0) {
+        elems.push_back(elem);
+      } else if (status == 1) {
+        break;
+      } else {
+        std::string chunk_error =
+            "read feature failed near row " + std::to_string(chunk_rows[k] + ctx.rows);
+        LOG_ERROR << chunk_error << std::endl;
+        bool expected = false;
+        if (failed.compare_exchange_strong(expected, true)) {  // 只保留首个失败原因
+          error = chunk_error;
+        }
+        return;
+      }
+    }
+    if (ctx.table != nullptr) {
+      ctx.table->Shrink();
+    }
+    chunk_arenas[k] = ctx.arena;
+  });
+  if (failed) {
+    return -1;
+  }
+
+  if (options.lazy_geo && !options.mid_only) {
+    // 各块的坐标区按块顺序拼接为图层的坐标区, 块内第j个元素对应块坐标区的第j项
+    auto arena = std::make_shared<GeoArena>();
+    for (size_t k = 0; k < num_chunks; ++k) {
+      size_t base = arena->size();
+      arena->append(*chunk_arenas[k]);
+      chunk_arenas[k].reset();
+      for (size_t j = 0; j < chunk_elems[k].size(); ++j) {
+        if (chunk_elems[k][j]->isGeoPending()) {
+          chunk_elems[k][j]->setLazyGeo(arena, base + j);
+        }
+      }
+    }
+    arena->shrink();
+    res.setArena(arena);
+  }
+
+  auto& elements = res.elements();
+  elements.reserve(elements.size() + total_rows);
+  for (auto& elems : chunk_elems) {
+    std::move(elems.begin(), elems.end(), std::back_inserter(elements));
+  }
+  return 0;
+}
+
+}  // namespace io
+}  // namespace gmif
@@ -0,0 +1,99 @@
+#include "scanner.h"
+#include <cctype>
+#include <cstring>
+#include "utils.h"
+
+namespace gmif {
+namespace io {
+
+static inline const char* LineEnd(const char* p, const char* end) {
+  const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+  return nl == nullptr ? end : nl;
+}
+
+static inline bool IsBlank(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+//! 行首(跳过空白后)是否为几何对象关键字, 坐标行以数字开头可快速排除
+static bool IsMifRecordLine(const char* p, const char* line_end) {
+  while (p != line_end && IsBlank(*p)) ++p;
+  if (p == line_end || !isalpha(static_cast<unsigned char>(*p))) {
+    return false;
+  }
+  const char* word_end = p;
+  while (word_end != line_end && !IsBlank(*word_end)) ++word_end;
+  utils::StrView word(p, word_end - p);
+  return utils::StrEqualNoCase(word, "point") || utils::StrEqualNoCase(word, "pline") ||
+         utils::StrEqualNoCase(word, "region") || utils::StrEqualNoCase(word, "line") ||
+         utils::StrEqualNoCase(word, "rect") || utils::StrEqualNoCase(word, "none");
+}
+
+static bool IsMidRowLine(const char* p, const char* line_end) {
+  while (p != line_end && IsBlank(*p)) ++p;
+  return p != line_end;
+}
+
+template <typename Pred>
+static const char* FindLine(const char* begin,
+                            const char* end,
+                            size_t n,
+                            size_t* count,
+                            Pred pred) {
+  size_t i = 0;
+  const char* p = begin;
+  while (p < end) {
+    const char* line_end = LineEnd(p, end);
+    if (pred(p, line_end)) {
+      if (i == n) {
+        break;
+      }
+      ++i;
+    }
+    p = (line_end == end) ? end : line_end + 1;
+  }
+  if (count != nullptr) {
+    *count = i;
+  }
+  return p;
+}
+
+std::vector<const char*> SplitLines(const char* begin, const char* end, size_t num_slices) {
+  std::vector<const char*> bounds(num_slices + 1, end);
+  bounds[0] = begin;
+  size_t len = end - begin;
+  for (size_t i = 1; i < num_slices; ++i) {
+    const char* p = begin + len / num_slices * i;
+    if (p < bounds[i - 1]) {
+      p = bounds[i - 1];
+    } else if (p != begin && *(p - 1) != '\n') {
+      p = LineEnd(p, end);
+      p = (p == end) ? end : p + 1;
+    }
+    bounds[i] = p;
+  }
+  return bounds;
+}
+
+size_t CountMifRecords(const char* begin, const char* end) {
+  size_t count = 0;
+  FindLine(begin, end, static_cast<size_t>(-1), &count, IsMifRecordLine);
+  return count;
+}
+
+const char* FindMifRecord(const char* begin, const char* end, size_t n) {
+  return FindLine(begin, end, n, nullptr, IsMifRecordLine);
+}
+
+size_t CountMidRows(const char* begin, const char* end) {
+  size_t count = 0;
+  FindLine(begin, end, static_cast<size_t>(-1), &count, IsMidRowLine);
+  return count;
+}
+
+const char* FindMidRow(const char* begin, const char* end, size_t n) {
+  return FindLine(begin, end, n, nullptr, IsMidRowLine);
+}
+
+}  // namespace io
+}  // namespace gmif
@@ -0,0 +1,34 @@
+#ifndef GMIF_SRC_SCANNER_H_
+#define GMIF_SRC_SCANNER_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace gmif {
+namespace io {
+
+/**
+ * @brief 将内存块切分为若干按行对齐的片段
+ * @param begin 起始地址, 需为行首
+ * @param end 结束地址
+ * @param num_slices 片段数
+ * @return 片段边界, 大小为num_slices + 1, 相邻边界可能相同
+ */
+std::vector<const char*> SplitLines(const char* begin, const char* end, size_t num_slices);
+
+//! 统计[begin, end)中以几何对象关键字(Point/Pline/Region等)开头的行数, begin需为行首
+size_t CountMifRecords(const char* begin, const char* end);
+
+//! 返回[begin, end)中第n个几何对象关键字行的行首, 不存在返回end
+const char* FindMifRecord(const char* begin, const char* end, size_t n);
+
+//! 统计[begin, end)中的非空行数, begin需为行首
+size_t CountMidRows(const char* begin, const char* end);
+
+//! 返回[begin, end)中第n个非空行的行首, 不存在返回end
+const char* FindMidRow(const char* begin, const char* end, size_t n);
+
+}  // namespace io
+}  // namespace gmif
+
+#endif  // GMIF_SRC_SCANNER_H_
@@ -0,0 +1,78 @@
+#include "schema.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace gmif {
+namespace io {
+
+void ParseColumnType(const std::string& lower_col_type_str, ColumnSpec& spec) {
+  const std::string& type = lower_col_type_str;
+  if (type.compare(0, 7, "integer") == 0 || type.compare(0, 8, "smallint") == 0) {
+    spec.type = ColType::kInt;
+  } else if (type.compare(0, 7, "decimal") == 0 || type.compare(0, 5, "float") == 0) {
+    spec.type = ColType::kDouble;
+  } else {
+    spec.type = ColType::kStr;
+  }
+
+  spec.width = 0;
+  spec.precision = -1;
+  size_t left = type.find('(');
+  if (left == std::string::npos) {
+    return;
+  }
+  const char* p = type.c_str() + left + 1;
+  char* next = nullptr;
+  long width = strtol(p, &next, 10);
+  if (next == p) {
+    return;
+  }
+  spec.width = static_cast<int>(width);
+  while (*next == ' ') ++next;
+  if (*next == ',') {
+    p = next + 1;
+    long precision = strtol(p, &next, 10);
+    if (next != p) {
+      spec.precision = static_cast<int>(precision);
+    }
+  }
+}
+
+void ColumnSchema::Compile(const MifHeader& header) {
+  delimiter_ = header.getDelimiter();
+  columns_.resize(header.getColumnSize());
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    columns_[i].name = header.getColumnName(i);
+    ParseColumnType(header.getColumnType(i), columns_[i]);
+  }
+
+  name_order_.resize(columns_.size());
+  for (size_t i = 0; i < name_order_.size(); ++i) {
+    name_order_[i] = i;
+  }
+  std::stable_sort(name_order_.begin(), name_order_.end(),
+                   [this](size_t a, size_t b) { return columns_[a].name < columns_[b].name; });
+
+  read_order_.clear();
+  for (size_t i = 0; i < name_order_.size(); ++i) {
+    size_t index = name_order_[i];
+    if (!read_order_.empty() && columns_[read_order_.back()].name == columns_[index].name) {
+      read_order_.back() = index;  // 重名列后者覆盖前者
+    } else {
+      read_order_.push_back(index);
+    }
+  }
+}
+
+int32_t ColumnSchema::findColumn(const std::string& name) const {
+  auto it = std::lower_bound(
+      read_order_.begin(), read_order_.end(), name,
+      [this](size_t index, const std::string& key) { return columns_[index].name < key; });
+  if (it == read_order_.end() || columns_[*it].name != name) {
+    return -1;
+  }
+  return static_cast<int32_t>(*it);
+}
+
+}  // namespace io
+}  // namespace gmif
@@ -0,0 +1,66 @@
+#ifndef GMIF_SRC_SCHEMA_H_
+#define GMIF_SRC_SCHEMA_H_
+
+#include "gmif/gmif.h"
+#include <string>
+#include <vector>
+
+namespace gmif {
+namespace io {
+
+//! 列值类型, 决定MID字段的解码与编码方式
+enum class ColType { kStr, kDouble, kInt };
+
+//! 单列的编解码信息
+struct ColumnSpec {
+  ColumnSpec() : type(ColType::kStr), width(0), precision(-1) {}
+
+  std::string name;  // 列名
+  ColType type;      // 值类型
+  int width;         // char(n)的n或decimal(w,p)的w, 未声明时为0
+  int precision;     // decimal(w,p)的p, 未声明时为-1
+};
+
+/**
+ * @brief 解析列类型字符串
+ * @param lower_col_type_str 小写列类型, 如"integer"、"char(6)"、"decimal(10,2)"
+ * @param spec 写入type/width/precision
+ */
+void ParseColumnType(const std::string& lower_col_type_str, ColumnSpec& spec);
+
+//! 由MifHeader预编译的列表, 逐行读写时按表分派, 不再重复解析类型字符串
+class ColumnSchema {
+ public:
+  ColumnSchema() : delimiter_(',') {}
+  explicit ColumnSchema(const MifHeader& header) { Compile(header); }
+
+  //! 根据表头重新编译
+  void Compile(const MifHeader& header);
+
+  size_t size() const { return columns_.size(); }
+  char getDelimiter() const { return delimiter_; }
+  const ColumnSpec& operator[](size_t index) const { return columns_[index]; }
+
+  /**
+   * @brief 按列名查找列
+   * @param name 列名
+   * @return 成功返回列下标, 重名时为最后一列, 不存在返回-1
+   */
+  int32_t findColumn(const std::string& name) const;
+
+  //! 按列名排序的列下标, 重名列保留最后一个, 与AttrMap的遍历顺序一致
+  const std::vector<size_t>& getReadOrder() const { return read_order_; }
+  //! 按列名稳定排序的全部列下标, 重名列相邻
+  const std::vector<size_t>& getNameOrder() const { return name_order_; }
+
+ private:
+  std::vector<ColumnSpec> columns_;
+  std::vector<size_t> read_order_;
+  std::vector<size_t> name_order_;
+  char delimiter_;
+};
+
+}  // namespace io
+}  // namespace gmif
+
+#endif  // GMIF_SRC_SCHEMA_H_
@@ -0,0 +1,252 @@
+#include "simd_scan.h"
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define GMIF_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+#ifdef __GNUC__
+#define GMIF_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define GMIF_ALWAYS_INLINE inline
+#endif
+
+namespace gmif {
+namespace utils {
+
+//! 64字节块内各结构字符的位掩码, 第i位对应第i个字节
+struct BlockMasks {
+  uint64_t sep;
+  uint64_t quote;
+  uint64_t escape;
+};
+
+// 各指令集的块扫描实现为Scanner::Scan, 由SplitBlocks<Scanner>展开到带target属性的入口函数中,
+// 块循环与扫描在同一指令集下编译并内联, 每行只分派一次
+
+struct ScalarScanner {
+  static inline BlockMasks Scan(const char* block, char sep) {
+    BlockMasks masks = {0, 0, 0};
+    for (int i = 0; i < 64; ++i) {
+      uint64_t bit = uint64_t(1) << i;
+      masks.sep |= (block[i] == sep) ? bit : 0;
+      masks.quote |= (block[i] == '"') ? bit : 0;
+      masks.escape |= (block[i] == '\\') ? bit : 0;
+    }
+    return masks;
+  }
+};
+
+#ifdef GMIF_SIMD_X86
+struct Sse2Scanner {
+  __attribute__((target("sse2"))) static inline BlockMasks Scan(const char* block, char sep) {
+    const __m128i v_sep = _mm_set1_epi8(sep);
+    const __m128i v_quote = _mm_set1_epi8('"');
+    const __m128i v_escape = _mm_set1_epi8('\\');
+    BlockMasks masks = {0, 0, 0};
+    for (int i = 0; i < 4; ++i) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i * 16));
+      int shift = i * 16;
+      masks.sep |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, v_sep)))) << shift;
+      masks.quote |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, v_quote)))) << shift;
+      masks.escape |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, v_escape))))
+                      << shift;
+    }
+    return masks;
+  }
+};
+
+struct Avx2Scanner {
+  __attribute__((target("avx2"))) static inline BlockMasks Scan(const char* block, char sep) {
+    const __m256i v_sep = _mm256_set1_epi8(sep);
+    const __m256i v_quote = _mm256_set1_epi8('"');
+    const __m256i v_escape = _mm256_set1_epi8('\\');
+    BlockMasks masks = {0, 0, 0};
+    for (int i = 0; i < 2; ++i) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i * 32));
+      int shift = i * 32;
+      masks.sep |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, v_sep)))) << shift;
+      masks.quote |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, v_quote))))
+                     << shift;
+      masks.escape |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, v_escape))))
+                      << shift;
+    }
+    return masks;
+  }
+};
+#endif
+
+ScanIsa DetectScanIsa() {
+  static const ScanIsa isa = []() {
+#ifdef GMIF_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      return ScanIsa::kAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+      return ScanIsa::kSse2;
+    }
+#endif
+    return ScanIsa::kScalar;
+  }();
+  return isa;
+}
+
+//! 前缀异或: 结果第i位为输入第0~i位的异或
+static inline uint64_t PrefixXor(uint64_t x) {
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+static inline int CountTrailingZeros(uint64_t x) {
+#ifdef __GNUC__
+  return __builtin_ctzll(x);
+#else
+  int n = 0;
+  while ((x & 1) == 0) {
+    x >>= 1;
+    ++n;
+  }
+  return n;
+#endif
+}
+
+//! 逐字段追加到结果, 达到最大字段数后停止
+struct AppendSink {
+  bool unquote;
+  std::vector<StrView>& res;
+  size_t max_fields;
+
+  //! 追加字段, 需停止扫描时返回false
+  bool Field(const char* start, const char* end) {
+    AppendField(start, end, unquote, res);
+    return res.size() != max_fields;
+  }
+};
+
+//! 只统计字段数
+struct CountSink {
+  size_t count;
+
+  bool Field(const char*, const char*) {
+    ++count;
+    return true;
+  }
+};
+
+//! 逐块扫描字段, 每个字段交给sink; 返回值同SplitFieldsSimd. 需内联到与Scanner指令集一致的函数中
+template <typename Scanner, typename Sink>
+static GMIF_ALWAYS_INLINE bool SplitBlocks(StrView str, char sep, Sink& sink) {
+  const char* start = str.begin();
+  uint64_t in_quote_carry = 0;   // 上一块结束时是否处于引号内
+  uint64_t field_start_carry = 1;  // 下一块首字节是否为字段开头
+  uint64_t closing_carry = 0;    // 上一块末字节是否为闭合引号
+  char tail[64];
+  for (size_t base = 0; base < str.size(); base += 64) {
+    const char* block = str.data() + base;
+    size_t len = str.size() - base;
+    uint64_t valid = ~uint64_t(0);
+    if (len < 64) {
+      memset(tail, 0, sizeof(tail));
+      memcpy(tail, block, len);
+      block = tail;
+      valid = (uint64_t(1) << len) - 1;
+    }
+    BlockMasks masks = Scanner::Scan(block, sep);
+    masks.sep &= valid;
+    masks.quote &= valid;
+    if ((masks.escape & valid) != 0) {
+      return false;
+    }
+
+    // 引号内区域: 开引号(含)到闭引号(不含)
+    uint64_t in_quote = PrefixXor(masks.quote) ^ (uint64_t(0) - in_quote_carry);
+    uint64_t opening = masks.quote & in_quote;
+    uint64_t closing = masks.quote & ~in_quote;
+    uint64_t seps = masks.sep & ~in_quote;
+
+    // 逐字节解析只在字段开头或闭引号之后识别开引号, 其余情况交由逐字节解析
+    uint64_t field_starts = (seps << 1) | field_start_carry;
+    uint64_t allowed = field_starts | (closing << 1) | closing_carry;
+    if ((opening & ~allowed) != 0) {
+      return false;
+    }
+
+    while (seps != 0) {
+      const char* pos = str.data() + base + CountTrailingZeros(seps);
+      if (!sink.Field(start, pos)) {
+        return true;
+      }
+      start = pos + 1;
+      seps &= seps - 1;
+    }
+
+    in_quote_carry = in_quote >> 63;
+    field_start_carry = (masks.sep & ~in_quote) >> 63;
+    closing_carry = closing >> 63;
+  }
+  sink.Field(start, str.end());
+  return true;
+}
+
+#ifdef GMIF_SIMD_X86
+template <typename Sink>
+__attribute__((target("sse2"))) static bool SplitBlocksSse2(StrView str, char sep, Sink& sink) {
+  return SplitBlocks<Sse2Scanner>(str, sep, sink);
+}
+
+template <typename Sink>
+__attribute__((target("avx2"))) static bool SplitBlocksAvx2(StrView str, char sep, Sink& sink) {
+  return SplitBlocks<Avx2Scanner>(str, sep, sink);
+}
+#endif
+
+//! 按指令集分派, 每次调用只分派一次
+template <typename Sink>
+static bool DispatchBlocks(ScanIsa isa, StrView str, char sep, Sink& sink) {
+#ifdef GMIF_SIMD_X86
+  if (isa == ScanIsa::kAvx2 && DetectScanIsa() == ScanIsa::kAvx2) {
+    return SplitBlocksAvx2(str, sep, sink);
+  }
+  if (isa != ScanIsa::kScalar && DetectScanIsa() != ScanIsa::kScalar) {
+    return SplitBlocksSse2(str, sep, sink);
+  }
+#endif
+  return SplitBlocks<ScalarScanner>(str, sep, sink);
+}
+
+bool SplitFieldsSimd(ScanIsa isa,
+                     StrView str,
+                     char sep,
+                     bool unquote,
+                     std::vector<StrView>& res,
+                     size_t max_fields) {
+  if (sep == '"' || sep == '\\') {
+    return false;
+  }
+  res.clear();
+  AppendSink sink = {unquote, res, max_fields};
+  return DispatchBlocks(isa, str, sep, sink);
+}
+
+bool CountFieldsSimd(ScanIsa isa, StrView str, char sep, size_t& count) {
+  if (sep == '"' || sep == '\\') {
+    return false;
+  }
+  CountSink sink = {0};
+  if (!DispatchBlocks(isa, str, sep, sink)) {
+    return false;
+  }
+  count = sink.count;
+  return true;
+}
+
+}  // namespace utils
+}  // namespace gmif
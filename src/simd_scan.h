@@ -0,0 +1,68 @@
+#ifndef GMIF_SRC_SIMD_SCAN_H_
+#define GMIF_SRC_SIMD_SCAN_H_
+
+#include <cstdint>
+#include <vector>
+#include "utils.h"
+
+namespace gmif {
+namespace utils {
+
+//! 结构字符扫描使用的指令集
+enum class ScanIsa { kScalar, kSse2, kAvx2 };
+
+//! 检测当前CPU支持的最优指令集, 结果在首次调用后缓存
+ScanIsa DetectScanIsa();
+
+/**
+ * @brief 向量化切分MID字段, 结果与StrSplitKeepQuot/StrSplitUnquote一致
+ *
+ * 每次处理64字节, 生成分隔符、引号、转义符位置的位掩码, 通过前缀异或计算引号内区域.
+ * @param isa 指令集, kScalar时以逐字节方式生成位掩码
+ * @param str 待切分字符串
+ * @param sep 分隔符
+ * @param unquote 是否去除字段两端引号
+ * @param res 切分结果
+ * @param max_fields 最多切分的字段数, 达到后不再扫描剩余内容
+ * @return 成功返回true; 含转义符或引号不在字段开头时返回false, 需由调用方逐字节解析
+ */
+bool SplitFieldsSimd(ScanIsa isa,
+                     StrView str,
+                     char sep,
+                     bool unquote,
+                     std::vector<StrView>& res,
+                     size_t max_fields = SIZE_MAX);
+
+/**
+ * @brief 向量化统计字段数, 与SplitFieldsSimd不限字段数时切分出的字段数一致, 不生成字段
+ * @param count 返回的字段数
+ * @return 同SplitFieldsSimd
+ */
+bool CountFieldsSimd(ScanIsa isa, StrView str, char sep, size_t& count);
+
+//! 逐字节切分MID字段, 支持转义符, 实现位于utils.cpp
+void SplitFieldsScalar(StrView str,
+                       char sep,
+                       bool unquote,
+                       std::vector<StrView>& res,
+                       size_t max_fields = SIZE_MAX);
+
+//! 逐字节统计字段数, 与SplitFieldsScalar不限字段数时一致, 实现位于utils.cpp
+size_t CountFieldsScalar(StrView str, char sep);
+
+//! 追加字段, 可选去除两端引号
+inline void AppendField(const char* start,
+                        const char* end,
+                        bool unquote,
+                        std::vector<StrView>& res) {
+  if (unquote) {
+    while (start < end && *start == '"') ++start;
+    while (end > start && *(end - 1) == '"') --end;
+  }
+  res.emplace_back(start, end - start);
+}
+
+}  // namespace utils
+}  // namespace gmif
+
+#endif  // GMIF_SRC_SIMD_SCAN_H_
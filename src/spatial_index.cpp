@@ -0,0 +1,361 @@
+#include <geos/geom/Geometry.h>
+#include <geos/geom/LineString.h>
+#include <geos/geom/Point.h>
+#include <geos/geom/Polygon.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include "gmif/gmif.h"
+#include "parallel.h"
+
+using namespace geos::geom;
+
+namespace gmif {
+
+//! 每个并行任务处理的元素数
+static const size_t kBuildBlockSize = 4096;
+
+//! 外包框, 比Envelope紧凑且无空值判断
+struct Box {
+  double minx, miny, maxx, maxy;
+
+  void expand(const Box& rhs) {
+    minx = std::min(minx, rhs.minx);
+    miny = std::min(miny, rhs.miny);
+    maxx = std::max(maxx, rhs.maxx);
+    maxy = std::max(maxy, rhs.maxy);
+  }
+
+  bool intersects(const Box& rhs) const {
+    return !(rhs.minx > maxx || rhs.maxx < minx || rhs.miny > maxy || rhs.maxy < miny);
+  }
+
+  //! 点到外包框距离的平方, 点在框内时为0
+  double distance2(const Coordinate& pt) const {
+    double dx = std::max(std::max(minx - pt.x, pt.x - maxx), 0.0);
+    double dy = std::max(std::max(miny - pt.y, pt.y - maxy), 0.0);
+    return dx * dx + dy * dy;
+  }
+};
+
+struct SpatialIndex::Impl {
+  size_t node_capacity;                       // 节点容量
+  std::vector<std::vector<Box>> levels;       // levels[0]为叶子, 逐层向上, 最后一层为根
+  std::vector<size_t> item_index;             // 各叶子对应的元素下标
+  std::vector<const MifElement*> item_elems;  // 各叶子对应的元素, 近邻查询时才访问几何对象
+
+  //! 节点的子节点范围[begin, end)
+  void children(size_t level, size_t node, size_t& begin, size_t& end) const {
+    begin = node * node_capacity;
+    end = std::min(begin + node_capacity, levels[level - 1].size());
+  }
+
+  //! 遍历与box相交的叶子
+  template <typename Fn>
+  void Visit(const Box& box, Fn fn) const {
+    if (levels.empty()) {
+      return;
+    }
+    std::vector<std::pair<size_t, size_t>> stack;  // (层, 节点)
+    size_t top = levels.size() - 1;
+    for (size_t i = 0; i < levels[top].size(); ++i) {
+      stack.emplace_back(top, i);
+    }
+    while (!stack.empty()) {
+      size_t level = stack.back().first;
+      size_t node = stack.back().second;
+      stack.pop_back();
+      if (!levels[level][node].intersects(box)) {
+        continue;
+      }
+      if (level == 0) {
+        fn(node);
+        continue;
+      }
+      size_t begin, end;
+      children(level, node, begin, end);
+      for (size_t i = begin; i < end; ++i) {
+        stack.emplace_back(level - 1, i);
+      }
+    }
+  }
+};
+
+/**
+ * 多线程排序: 分段排序后逐轮两两归并
+ * @param items 待排序数组
+ * @param num_threads 线程数
+ * @param less 比较函数
+ */
+template <typename T, typename Less>
+static void ParallelSort(std::vector<T>& items, size_t num_threads, Less less) {
+  size_t num_blocks = std::min(parallel::ResolveThreads(num_threads),
+                               (items.size() + kBuildBlockSize - 1) / kBuildBlockSize);
+  if (num_blocks <= 1) {
+    std::sort(items.begin(), items.end(), less);
+    return;
+  }
+  std::vector<size_t> bounds(num_blocks + 1);
+  for (size_t k = 0; k <= num_blocks; ++k) {
+    bounds[k] = items.size() * k / num_blocks;
+  }
+  parallel::ParallelFor(num_blocks, num_threads, [&](size_t k) {
+    std::sort(items.begin() + bounds[k], items.begin() + bounds[k + 1], less);
+  });
+  for (size_t step = 1; step < num_blocks; step *= 2) {
+    size_t num_merges = (num_blocks + 2 * step - 1) / (2 * step);
+    parallel::ParallelFor(num_merges, num_threads, [&](size_t m) {
+      size_t first = m * 2 * step;
+      size_t middle = std::min(first + step, num_blocks);
+      size_t last = std::min(first + 2 * step, num_blocks);
+      if (middle < last) {
+        std::inplace_merge(items.begin() + bounds[first], items.begin() + bounds[middle],
+                           items.begin() + bounds[last], less);
+      }
+    });
+  }
+}
+
+SpatialIndex::SpatialIndex() : impl_(new Impl) {
+  impl_->node_capacity = kDefaultNodeCapacity;
+}
+
+SpatialIndex::~SpatialIndex() = default;
+
+void SpatialIndex::Build(const std::vector<std::shared_ptr<MifElement>>& elements,
+                         size_t num_threads,
+                         size_t node_capacity) {
+  Impl& impl = *impl_;
+  impl.node_capacity = std::max<size_t>(node_capacity, 2);
+  impl.levels.clear();
+  impl.item_index.clear();
+  impl.item_elems.clear();
+
+  // 并行计算外包框, 空几何对象不参与索引; 尚未构造的几何对象由坐标区计算, 不触发构造
+  std::vector<Box> boxes(elements.size());
+  std::vector<char> valid(elements.size(), 0);
+  size_t num_blocks = (elements.size() + kBuildBlockSize - 1) / kBuildBlockSize;
+  parallel::ParallelFor(num_blocks, num_threads, [&](size_t k) {
+    size_t end = std::min((k + 1) * kBuildBlockSize, elements.size());
+    for (size_t i = k * kBuildBlockSize; i < end; ++i) {
+      const auto& elem = elements[i];
+      if (elem == nullptr) {
+        continue;
+      }
+      Envelope env;
+      std::shared_ptr<const GeoArena> arena;
+      size_t index = 0;
+      if (elem->getLazyGeo(arena, index)) {
+        arena->getEnvelope(index, env);
+      } else if (elem->getGeo() != nullptr) {
+        env = *elem->getGeo()->getEnvelopeInternal();
+      }
+      if (env.isNull()) {
+        continue;
+      }
+      boxes[i] = Box{env.getMinX(), env.getMinY(), env.getMaxX(), env.getMaxY()};
+      valid[i] = 1;
+    }
+  });
+  std::vector<size_t> order;
+  for (size_t i = 0; i < elements.size(); ++i) {
+    if (valid[i]) {
+      order.push_back(i);
+    }
+  }
+  if (order.empty()) {
+    return;
+  }
+
+  // STR: 按中心x排序后切分为竖条, 条内按中心y排序, 依次打包为叶子
+  auto center_x = [&](size_t i) { return boxes[i].minx + boxes[i].maxx; };
+  auto center_y = [&](size_t i) { return boxes[i].miny + boxes[i].maxy; };
+  ParallelSort(order, num_threads, [&](size_t a, size_t b) {
+    return center_x(a) < center_x(b) || (center_x(a) == center_x(b) && a < b);
+  });
+  size_t cap = impl.node_capacity;
+  size_t num_leaves = (order.size() + cap - 1) / cap;
+  size_t num_slices = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(num_leaves))));
+  size_t slice_size = (num_leaves + num_slices - 1) / num_slices * cap;
+  parallel::ParallelFor(num_slices, num_threads, [&](size_t s) {
+    size_t begin = std::min(s * slice_size, order.size());
+    size_t end = std::min(begin + slice_size, order.size());
+    std::sort(order.begin() + begin, order.begin() + end, [&](size_t a, size_t b) {
+      return center_y(a) < center_y(b) || (center_y(a) == center_y(b) && a < b);
+    });
+  });
+
+  impl.item_index = order;
+  impl.item_elems.resize(order.size());
+  impl.levels.emplace_back(order.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    impl.levels[0][i] = boxes[order[i]];
+    impl.item_elems[i] = elements[order[i]].get();
+  }
+
+  // 逐层合并相邻的cap个节点, 直到只剩一个节点
+  while (impl.levels.back().size() > 1) {
+    const std::vector<Box>& lower = impl.levels.back();
+    std::vector<Box> upper((lower.size() + cap - 1) / cap);
+    size_t num_tasks = (upper.size() + kBuildBlockSize - 1) / kBuildBlockSize;
+    parallel::ParallelFor(num_tasks, num_threads, [&](size_t k) {
+      size_t end = std::min((k + 1) * kBuildBlockSize, upper.size());
+      for (size_t i = k * kBuildBlockSize; i < end; ++i) {
+        size_t child_end = std::min((i + 1) * cap, lower.size());
+        upper[i] = lower[i * cap];
+        for (size_t c = i * cap + 1; c < child_end; ++c) {
+          upper[i].expand(lower[c]);
+        }
+      }
+    });
+    impl.levels.push_back(std::move(upper));
+  }
+}
+
+size_t SpatialIndex::size() const {
+  return impl_->item_index.size();
+}
+
+void SpatialIndex::Query(const Envelope& env, std::vector<size_t>& res) const {
+  res.clear();
+  if (env.isNull()) {
+    return;
+  }
+  Box box{env.getMinX(), env.getMinY(), env.getMaxX(), env.getMaxY()};
+  impl_->Visit(box, [&](size_t leaf) { res.push_back(impl_->item_index[leaf]); });
+  std::sort(res.begin(), res.end());
+}
+
+void SpatialIndex::QueryPoint(const Coordinate& pt, std::vector<size_t>& res) const {
+  res.clear();
+  Box box{pt.x, pt.y, pt.x, pt.y};
+  impl_->Visit(box, [&](size_t leaf) { res.push_back(impl_->item_index[leaf]); });
+  std::sort(res.begin(), res.end());
+}
+
+//! 点到线段距离的平方
+static inline double SegmentDistance2(const Coordinate& pt,
+                                      const Coordinate& a,
+                                      const Coordinate& b) {
+  double dx = b.x - a.x;
+  double dy = b.y - a.y;
+  double len2 = dx * dx + dy * dy;
+  double t = 0;
+  if (len2 > 0) {
+    t = std::max(0.0, std::min(1.0, ((pt.x - a.x) * dx + (pt.y - a.y) * dy) / len2));
+  }
+  double ex = a.x + t * dx - pt.x;
+  double ey = a.y + t * dy - pt.y;
+  return ex * ex + ey * ey;
+}
+
+//! 点到坐标序列各线段距离平方的最小值
+static double SequenceDistance2(const Coordinate& pt, const CoordinateSequence& seq) {
+  size_t n = seq.size();
+  if (n == 0) {
+    return std::numeric_limits<double>::infinity();
+  }
+  double res = SegmentDistance2(pt, seq.getAt(0), seq.getAt(0));
+  for (size_t i = 1; i < n; ++i) {
+    res = std::min(res, SegmentDistance2(pt, seq.getAt(i - 1), seq.getAt(i)));
+  }
+  return res;
+}
+
+//! 射线法判断点是否在闭合环内
+static bool InRing(const Coordinate& pt, const CoordinateSequence& seq) {
+  bool inside = false;
+  size_t n = seq.size();
+  for (size_t i = 0, j = n - 1; i < n; j = i++) {
+    const Coordinate& a = seq.getAt(i);
+    const Coordinate& b = seq.getAt(j);
+    if ((a.y > pt.y) != (b.y > pt.y) && pt.x < (b.x - a.x) * (pt.y - a.y) / (b.y - a.y) + a.x) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+//! 点到几何对象距离的平方, 点在面内时为0
+static double GeoDistance2(const Coordinate& pt, const Geometry* geo) {
+  switch (geo->getGeometryTypeId()) {
+    case GEOS_POINT: {
+      const Point* point = static_cast<const Point*>(geo);
+      double dx = point->getX() - pt.x;
+      double dy = point->getY() - pt.y;
+      return dx * dx + dy * dy;
+    }
+    case GEOS_LINESTRING:
+    case GEOS_LINEARRING:
+      return SequenceDistance2(pt, *static_cast<const LineString*>(geo)->getCoordinatesRO());
+    case GEOS_POLYGON: {
+      const Polygon* polygon = static_cast<const Polygon*>(geo);
+      const CoordinateSequence& shell = *polygon->getExteriorRing()->getCoordinatesRO();
+      bool inside = shell.size() > 0 && InRing(pt, shell);
+      double res = SequenceDistance2(pt, shell);
+      for (size_t i = 0; i < polygon->getNumInteriorRing(); ++i) {
+        const CoordinateSequence& hole = *polygon->getInteriorRingN(i)->getCoordinatesRO();
+        if (inside && hole.size() > 0 && InRing(pt, hole)) {
+          inside = false;
+        }
+        res = std::min(res, SequenceDistance2(pt, hole));
+      }
+      return inside ? 0 : res;
+    }
+    default: {
+      double res = std::numeric_limits<double>::infinity();
+      for (size_t i = 0; i < geo->getNumGeometries(); ++i) {
+        res = std::min(res, GeoDistance2(pt, geo->getGeometryN(i)));
+      }
+      return res;
+    }
+  }
+}
+
+void SpatialIndex::Nearest(const Coordinate& pt, size_t k, std::vector<size_t>& res) const {
+  res.clear();
+  const Impl& impl = *impl_;
+  if (impl.levels.empty() || k == 0) {
+    return;
+  }
+
+  // 最优优先搜索: 节点与叶子按外包框距离入队, 叶子出队时计算精确距离后再次入队;
+  // 精确距离出队时, 其余候选的距离均不小于它
+  struct Entry {
+    double dist2;
+    size_t level;  // 叶子精确距离的层号为SIZE_MAX
+    size_t node;
+    size_t elem;   // 叶子的元素下标, 用于距离相同时排序
+    bool operator>(const Entry& rhs) const {
+      return dist2 > rhs.dist2 || (dist2 == rhs.dist2 && elem > rhs.elem);
+    }
+  };
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+  size_t top = impl.levels.size() - 1;
+  for (size_t i = 0; i < impl.levels[top].size(); ++i) {
+    queue.push(Entry{impl.levels[top][i].distance2(pt), top, i, 0});
+  }
+  while (!queue.empty() && res.size() < k) {
+    Entry entry = queue.top();
+    queue.pop();
+    if (entry.level == SIZE_MAX) {
+      res.push_back(entry.elem);
+    } else if (entry.level == 0) {
+      const Geometry* geo = impl.item_elems[entry.node]->getGeo().get();
+      double dist2 = (geo == nullptr) ? std::numeric_limits<double>::infinity()
+                                      : GeoDistance2(pt, geo);
+      queue.push(Entry{dist2, SIZE_MAX, entry.node, impl.item_index[entry.node]});
+    } else {
+      size_t begin, end;
+      impl.children(entry.level, entry.node, begin, end);
+      for (size_t i = begin; i < end; ++i) {
+        size_t elem = (entry.level == 1) ? impl.item_index[i] : 0;
+        queue.push(Entry{impl.levels[entry.level - 1][i].distance2(pt), entry.level - 1, i, elem});
+      }
+    }
+  }
+}
+
+}  // namespace gmif
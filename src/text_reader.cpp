@@ -0,0 +1,217 @@
+#include "text_reader.h"
+#include <algorithm>
+#include <cstring>
+
+namespace gmif {
+namespace io {
+
+static inline bool IsSpace(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v';
+}
+
+bool TextReader::OpenMapped(const std::string& path) {
+  Close();
+  if (!mapped_.Open(path)) {
+    return false;
+  }
+  pos_ = origin_ = mapped_.data();
+  end_ = origin_end_ = pos_ + mapped_.size();
+  return true;
+}
+
+bool TextReader::OpenBuffered(const std::string& path, size_t chunk_size) {
+  Close();
+  ifs_.open(path.c_str(), std::ios_base::in | std::ios_base::binary);
+  if (ifs_.fail()) {
+    ifs_.close();
+    return false;
+  }
+  buf_.resize(chunk_size > 0 ? chunk_size : kDefaultChunkSize);
+  pos_ = end_ = buf_.data();
+  source_eof_ = false;
+  return true;
+}
+
+bool TextReader::OpenCompressed(const std::string& path,
+                                Compression compression,
+                                size_t chunk_size) {
+  Close();
+  chunk_size = chunk_size > 0 ? chunk_size : kDefaultChunkSize;
+  std::unique_ptr<Decompressor> decompressor(new Decompressor);
+  if (!decompressor->Open(path, compression, chunk_size)) {
+    return false;
+  }
+  decompressor_ = std::move(decompressor);
+  buf_.resize(chunk_size);
+  pos_ = end_ = buf_.data();
+  source_eof_ = false;
+  return true;
+}
+
+void TextReader::Reset(const char* begin, const char* end) {
+  Close();
+  pos_ = origin_ = begin;
+  end_ = origin_end_ = end;
+}
+
+void TextReader::Close() {
+  mapped_.Close();
+  if (ifs_.is_open()) {
+    ifs_.close();
+  }
+  ifs_.clear();
+  decompressor_.reset();
+  std::vector<char>().swap(buf_);
+  pos_ = end_ = nullptr;
+  source_eof_ = true;
+  origin_ = origin_end_ = nullptr;
+  base_ = 0;
+  limit_ = UINT64_MAX;
+}
+
+uint64_t TextReader::offset() const {
+  if (ifs_.is_open() || decompressor_ != nullptr) {
+    return base_ + (pos_ - buf_.data());
+  }
+  return pos_ - origin_;
+}
+
+bool TextReader::Seek(uint64_t offset, uint64_t limit) {
+  if (limit < offset || decompressor_ != nullptr) {
+    return false;
+  }
+  if (ifs_.is_open()) {
+    ifs_.clear();
+    ifs_.seekg(static_cast<std::streamoff>(offset));
+    if (ifs_.fail()) {
+      return false;
+    }
+    base_ = offset;
+    limit_ = limit;
+    pos_ = end_ = buf_.data();
+    source_eof_ = false;
+    return true;
+  }
+  uint64_t size = origin_end_ - origin_;
+  if (offset > size) {
+    return false;
+  }
+  pos_ = origin_ + offset;
+  end_ = origin_ + std::min(limit, size);
+  return true;
+}
+
+bool TextReader::eof() {
+  return pos_ == end_ && !Fill();
+}
+
+bool TextReader::fail() const {
+  return ifs_.bad() || (decompressor_ != nullptr && decompressor_->fail());
+}
+
+bool TextReader::Fill() {
+  if (source_eof_) {
+    return false;
+  }
+  size_t offset = pos_ - buf_.data();
+  size_t remain = end_ - pos_;
+  if (remain > 0 && offset > 0) {
+    memmove(buf_.data(), buf_.data() + offset, remain);
+  }
+  base_ += offset;
+  if (remain == buf_.size()) {  // 单行超过缓冲区, 扩容
+    buf_.resize(buf_.size() * 2);
+  }
+  uint64_t avail = limit_ - std::min(limit_, base_ + remain);  // 距读取结束偏移的字节数
+  size_t want = static_cast<size_t>(std::min<uint64_t>(buf_.size() - remain, avail));
+  size_t n = 0;
+  if (decompressor_ != nullptr) {
+    n = decompressor_->Read(buf_.data() + remain, want);
+  } else {
+    ifs_.read(buf_.data() + remain, want);
+    n = static_cast<size_t>(ifs_.gcount());
+  }
+  pos_ = buf_.data();
+  end_ = pos_ + remain + n;
+  if (n == 0) {
+    source_eof_ = true;
+    return false;
+  }
+  return true;
+}
+
+bool TextReader::ReadLine(utils::StrView& line) {
+  size_t scanned = 0;
+  const char* nl = nullptr;
+  while (true) {
+    if (pos_ + scanned != end_) {
+      nl = static_cast<const char*>(memchr(pos_ + scanned, '\n', end_ - pos_ - scanned));
+      if (nl != nullptr) {
+        break;
+      }
+    }
+    scanned = end_ - pos_;
+    if (!Fill()) {
+      break;
+    }
+  }
+  if (nl == nullptr) {  // 最后一行没有换行符
+    if (pos_ == end_) {
+      return false;
+    }
+    nl = end_;
+  }
+  const char* line_end = nl;
+  if (line_end != pos_ && *(line_end - 1) == '\r') {
+    --line_end;
+  }
+  line = utils::StrView(pos_, line_end - pos_);
+  pos_ = (nl == end_) ? end_ : nl + 1;
+  return true;
+}
+
+bool TextReader::ReadToken(utils::StrView& token) {
+  while (true) {
+    while (pos_ != end_ && IsSpace(*pos_)) ++pos_;
+    if (pos_ != end_) {
+      break;
+    }
+    if (!Fill()) {
+      return false;
+    }
+  }
+  size_t len = 0;
+  while (true) {
+    while (pos_ + len != end_ && !IsSpace(pos_[len])) ++len;
+    if (pos_ + len != end_ || !Fill()) {
+      break;
+    }
+  }
+  token = utils::StrView(pos_, len);
+  pos_ += len;
+  return true;
+}
+
+bool TextReader::ReadDouble(double& value) {
+  while (true) {
+    while (pos_ != end_ && IsSpace(*pos_)) ++pos_;
+    if (pos_ == end_) {
+      if (!Fill()) {
+        return false;
+      }
+      continue;
+    }
+    const char* p = utils::ParseDouble(pos_, end_, value);
+    if (p == end_ && Fill()) {  // 数字可能被块边界截断, 补充数据后重新解析
+      continue;
+    }
+    if (p == pos_) {
+      return false;
+    }
+    pos_ = p;
+    return true;
+  }
+}
+
+}  // namespace io
+}  // namespace gmif
@@ -0,0 +1,136 @@
+#ifndef GMIF_SRC_TEXT_READER_H_
+#define GMIF_SRC_TEXT_READER_H_
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "compression.h"
+#include "mapped_file.h"
+#include "utils.h"
+
+namespace gmif {
+namespace io {
+
+/**
+ * @brief 文本读取器, 按行/按词返回指向内部缓冲区的片段, 不产生字符串拷贝
+ *
+ * 数据来源可以是内存映射文件、分块读取的文件、流式解压的压缩文件或外部内存块.
+ * 返回的片段在下一次ReadLine/ReadToken调用前有效.
+ */
+class TextReader {
+ public:
+  static const size_t kDefaultChunkSize = 1 << 20;
+
+  TextReader()
+      : pos_(nullptr),
+        end_(nullptr),
+        source_eof_(true),
+        origin_(nullptr),
+        origin_end_(nullptr),
+        base_(0),
+        limit_(UINT64_MAX) {}
+
+  TextReader(const TextReader&) = delete;
+  TextReader& operator=(const TextReader&) = delete;
+
+  /**
+   * @brief 以内存映射方式打开文件
+   * @param path 文件路径
+   * @return 成功返回true, 失败返回false
+   */
+  bool OpenMapped(const std::string& path);
+
+  /**
+   * @brief 以分块读取方式打开文件, 内存占用为块大小与最长行中的较大者
+   * @param path 文件路径
+   * @param chunk_size 每次读取的字节数
+   * @return 成功返回true, 失败返回false
+   */
+  bool OpenBuffered(const std::string& path, size_t chunk_size = kDefaultChunkSize);
+
+  /**
+   * @brief 打开压缩文件, 由后台线程流式解压, 解压与读取重叠进行; 不支持Seek
+   * @param path 文件路径
+   * @param compression 压缩格式
+   * @param chunk_size 每次读取的字节数
+   * @return 成功返回true, 文件不存在或不支持该压缩格式返回false
+   */
+  bool OpenCompressed(const std::string& path,
+                      Compression compression,
+                      size_t chunk_size = kDefaultChunkSize);
+
+  /**
+   * @brief 绑定外部内存块, 不拥有其生命周期
+   * @param begin 起始地址
+   * @param end 结束地址
+   */
+  void Reset(const char* begin, const char* end);
+
+  //! 关闭并释放数据源
+  void Close();
+
+  //! 数据是否已全部读完
+  bool eof();
+
+  //! 数据源是否发生读取或解压错误, 此时读到的数据结束并非文件结束
+  bool fail() const;
+
+  //! 当前读取位置, 对内存映射和外部内存块即为原数据中的地址
+  const char* position() const { return pos_; }
+
+  //! 当前读取位置相对数据源起始的字节偏移
+  uint64_t offset() const;
+
+  /**
+   * @brief 跳转到指定偏移, 此后读取到limit处即视为数据结束
+   * @param offset 相对数据源起始的字节偏移
+   * @param limit 读取结束偏移, 超过数据源大小时读到数据源结束
+   * @return 成功返回true, 偏移越界、读取失败或数据源为压缩文件返回false
+   */
+  bool Seek(uint64_t offset, uint64_t limit = UINT64_MAX);
+
+  /**
+   * @brief 读取当前位置到行尾的内容, 不含换行符
+   * @param line 返回的行片段
+   * @return 成功返回true, 数据结束返回false
+   */
+  bool ReadLine(utils::StrView& line);
+
+  /**
+   * @brief 跳过空白字符后读取一个词, 可跨行
+   * @param token 返回的词片段
+   * @return 成功返回true, 数据结束返回false
+   */
+  bool ReadToken(utils::StrView& token);
+
+  /**
+   * @brief 跳过空白字符后就地解析一个十进制浮点数, 可跨行
+   * @param value 解析结果
+   * @return 成功返回true, 数据结束或不是数字返回false
+   */
+  bool ReadDouble(double& value);
+
+ private:
+  //! 从文件补充数据, 保留未消费部分, 无新数据返回false
+  bool Fill();
+
+  const char* pos_;         // 当前读取位置
+  const char* end_;         // 有效数据结束位置
+  bool source_eof_;         // 数据源是否已读完
+  const char* origin_;      // 内存映射或外部内存块的起始地址
+  const char* origin_end_;  // 内存映射或外部内存块的结束地址
+  uint64_t base_;           // 分块读取时缓冲区起始对应的文件偏移
+  uint64_t limit_;          // 分块读取时的读取结束偏移
+
+  MappedFile mapped_;
+  std::ifstream ifs_;
+  std::unique_ptr<Decompressor> decompressor_;
+  std::vector<char> buf_;
+};
+
+}  // namespace io
+}  // namespace gmif
+
+#endif  // GMIF_SRC_TEXT_READER_H_
@@ -1,7 +1,15 @@
 #include "utils.h"
+#include <algorithm>
 #include <cctype>
+#include <clocale>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <sstream>
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+#include "simd_scan.h"
 
 namespace gmif {
 namespace utils {
@@ -88,9 +96,57 @@ void StrSplit(const std::string& str, const std::string& sep, std::vector<std::s
   }
 }
 
-void ParseQuot(const char*& s) {
+bool operator==(StrView lhs, StrView rhs) {
+  return lhs.size() == rhs.size() &&
+         (lhs.empty() || memcmp(lhs.data(), rhs.data(), lhs.size()) == 0);
+}
+
+bool operator!=(StrView lhs, StrView rhs) {
+  return !(lhs == rhs);
+}
+
+std::ostream& operator<<(std::ostream& os, StrView sv) {
+  return os.write(sv.data(), sv.size());
+}
+
+void StrTrimLeft(StrView& str, const char* chars) {
+  while (!str.empty() && strchr(chars, str[0]) != nullptr) {
+    str.remove_prefix(1);
+  }
+}
+
+void StrTrimRight(StrView& str, const char* chars) {
+  while (!str.empty() && strchr(chars, str[str.size() - 1]) != nullptr) {
+    str.remove_suffix(1);
+  }
+}
+
+void StrTrim(StrView& str, const char* chars) {
+  StrTrimLeft(str, chars);
+  StrTrimRight(str, chars);
+}
+
+void StrTrimSpace(StrView& str) {
+  StrTrim(str, kSpaceWhite);
+}
+
+void StrSplitSpace(StrView str, std::vector<StrView>& res) {
+  res.clear();
+  const char* s = str.begin();
+  const char* end = str.end();
+  while (s != end) {
+    while (s != end && isspace(static_cast<unsigned char>(*s))) ++s;
+    const char* start = s;
+    while (s != end && !isspace(static_cast<unsigned char>(*s))) ++s;
+    if (s != start) {
+      res.emplace_back(start, s - start);
+    }
+  }
+}
+
+void ParseQuot(const char*& s, const char* end) {
   ++s;  // skip begin quotation
-  while (*s != '\0') {
+  while (s < end) {
     if (*s == kQuot) {
       ++s;  // skip end quotation
       break;
@@ -100,36 +156,123 @@ void ParseQuot(const char*& s) {
   }
 }
 
-void ParseNormal(const char*& s, char sep) {
-  while (*s != '\0' && *s != sep) {
+void ParseNormal(const char*& s, const char* end, char sep) {
+  while (s < end && *s != sep) {
     if (*s == '\\')
       ++s;
     ++s;
   }
 }
 
-void StrSplitKeepQuot(const std::string& str, char sep, std::vector<std::string>& res) {
+void SplitFieldsScalar(StrView str,
+                       char sep,
+                       bool unquote,
+                       std::vector<StrView>& res,
+                       size_t max_fields) {
   res.clear();
-  const char* start = str.c_str();
+  const char* start = str.begin();
+  const char* end = str.end();
   const char* s = start;
-  while (*s != '\0') {
+  while (s < end) {
     if (*s == sep) {
-      res.emplace_back(start, s - start);
+      AppendField(start, s, unquote, res);
+      if (res.size() == max_fields) {
+        return;
+      }
       ++s;
       start = s;
     } else {
       if (*s == kQuot) {
-        ParseQuot(s);
+        ParseQuot(s, end);
       } else {
-        ParseNormal(s, sep);
+        ParseNormal(s, end, sep);
       }
     }
   }
-  if (*start != '\0') {
-    res.emplace_back(start, s - start);
-  } else {
-    res.emplace_back("");
+  if (s > end) {  // ESC at end of string
+    s = end;
   }
+  AppendField(start, s, unquote, res);
+}
+
+size_t CountFieldsScalar(StrView str, char sep) {
+  size_t count = 1;
+  const char* s = str.begin();
+  const char* end = str.end();
+  while (s < end) {
+    if (*s == sep) {
+      ++count;
+      ++s;
+    } else if (*s == kQuot) {
+      ParseQuot(s, end);
+    } else {
+      ParseNormal(s, end, sep);
+    }
+  }
+  return count;
+}
+
+//! 短于此长度的行直接逐字节解析
+static const size_t kSimdMinLength = 32;
+
+static void SplitFields(StrView str,
+                        char sep,
+                        bool unquote,
+                        std::vector<StrView>& res,
+                        size_t max_fields) {
+  ScanIsa isa = DetectScanIsa();
+  if (isa != ScanIsa::kScalar && str.size() >= kSimdMinLength &&
+      SplitFieldsSimd(isa, str, sep, unquote, res, max_fields)) {
+    return;
+  }
+  SplitFieldsScalar(str, sep, unquote, res, max_fields);
+}
+
+size_t StrCountFields(StrView str, char sep) {
+  ScanIsa isa = DetectScanIsa();
+  size_t count = 0;
+  if (isa != ScanIsa::kScalar && str.size() >= kSimdMinLength &&
+      CountFieldsSimd(isa, str, sep, count)) {
+    return count;
+  }
+  return CountFieldsScalar(str, sep);
+}
+
+void StrSplitKeepQuot(StrView str, char sep, std::vector<StrView>& res) {
+  SplitFields(str, sep, false, res, SIZE_MAX);
+}
+
+void StrSplitUnquote(StrView str, char sep, std::vector<StrView>& res, size_t max_fields) {
+  SplitFields(str, sep, true, res, max_fields);
+}
+
+void StrSplitKeepQuot(const std::string& str, char sep, std::vector<std::string>& res) {
+  std::vector<StrView> items;
+  StrSplitKeepQuot(StrView(str.c_str()), sep, items);
+  res.clear();
+  for (const auto& item : items) {
+    res.emplace_back(item.data(), item.size());
+  }
+}
+
+static char AsciiLower(char c) {
+  return ('A' <= c && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+bool StrEqualNoCase(StrView str, StrView lower_str) {
+  return str.size() == lower_str.size() && StrStartsWithNoCase(str, lower_str);
+}
+
+bool StrStartsWithNoCase(StrView str, StrView lower_prefix) {
+  if (str.size() < lower_prefix.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < lower_prefix.size(); ++i) {
+    if (AsciiLower(str[i]) != lower_prefix[i]) {
+      return false;
+    }
+  }
+  return true;
 }
 
 double to_double(const std::string& s) {
@@ -148,5 +291,216 @@ int64_t to_int(const char* s) {
   return strtol(s, nullptr, 10);
 }
 
+double to_double(StrView s) {
+  double v(0);
+  ParseDouble(s.begin(), s.end(), v);
+  return v;
+}
+
+int64_t to_int(StrView s) {
+  const char* p = s.begin();
+  const char* end = s.end();
+  while (p != end && isspace(static_cast<unsigned char>(*p))) ++p;
+  bool neg = false;
+  if (p != end && (*p == '-' || *p == '+')) {
+    neg = (*p == '-');
+    ++p;
+  }
+  int64_t v = 0;
+  for (; p != end && '0' <= *p && *p <= '9'; ++p) {
+    v = v * 10 + (*p - '0');
+  }
+  return neg ? -v : v;
+}
+
+static const double kPow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+static inline bool IsDigit(char c) {
+  return static_cast<unsigned char>(c - '0') < 10;
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define GMIF_SWAR_DIGITS 1
+
+//! 判断8个字节是否全为数字
+static inline bool IsEightDigits(uint64_t val) {
+  return (((val & 0xF0F0F0F0F0F0F0F0) | (((val + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) ==
+          0x3333333333333333);
+}
+
+//! 将8个数字字符并行转换为整数
+static inline uint32_t ParseEightDigits(uint64_t val) {
+  const uint64_t kMask = 0x000000FF000000FF;
+  const uint64_t kMul1 = 0x000F424000000064;  // 100 + (1000000ULL << 32)
+  const uint64_t kMul2 = 0x0000271000000001;  // 1 + (10000ULL << 32)
+  val -= 0x3030303030303030;
+  val = (val * 10) + (val >> 8);
+  val = (((val & kMask) * kMul1) + (((val >> 16) & kMask) * kMul2)) >> 32;
+  return static_cast<uint32_t>(val);
+}
+#endif
+
+//! 按"C"区域解析浮点数, 不受当前区域LC_NUMERIC的影响
+static double ClassicStrtod(const char* s, char** s_end) {
+#ifdef _WIN32
+  static const _locale_t loc = _create_locale(LC_NUMERIC, "C");
+  return _strtod_l(s, s_end, loc);
+#else
+  static const locale_t loc = newlocale(LC_NUMERIC_MASK, "C", static_cast<locale_t>(0));
+  if (loc == static_cast<locale_t>(0)) {  // 仅在内存不足时失败
+    return strtod(s, s_end);
+  }
+  return strtod_l(s, s_end, loc);
+#endif
+}
+
+//! 拷贝到以'\0'结尾的缓冲区后按"C"区域调用strtod
+static const char* StrtodFallback(const char* begin, const char* end, double& value) {
+  char buf[64];
+  std::string str;
+  const char* s = buf;
+  size_t len = end - begin;
+  if (len < sizeof(buf)) {
+    memcpy(buf, begin, len);
+    buf[len] = '\0';
+  } else {
+    str.assign(begin, len);
+    s = str.c_str();
+  }
+  char* s_end = nullptr;
+  value = ClassicStrtod(s, &s_end);
+  return begin + (s_end - s);
+}
+
+const char* ParseDouble(const char* begin, const char* end, double& value) {
+  const char* p = begin;
+  bool neg = false;
+  if (p != end && (*p == '-' || *p == '+')) {
+    neg = (*p == '-');
+    ++p;
+  }
+
+  uint64_t mantissa = 0;
+  int digits = 0;  // 尾数有效位数, 不含前导零
+  int exp10 = 0;
+  const char* int_begin = p;
+  for (; p != end && IsDigit(*p); ++p) {
+    mantissa = mantissa * 10 + (*p - '0');
+    digits += (mantissa != 0);
+  }
+  size_t num_digits = p - int_begin;
+  if (p != end && *p == '.') {
+    ++p;
+    const char* frac_begin = p;
+#ifdef GMIF_SWAR_DIGITS
+    uint64_t chunk;
+    while (end - p >= 8 && digits + 8 <= 19) {
+      memcpy(&chunk, p, 8);
+      if (!IsEightDigits(chunk)) {
+        break;
+      }
+      mantissa = mantissa * 100000000 + ParseEightDigits(chunk);
+      digits += (mantissa != 0) ? 8 : 0;
+      p += 8;
+    }
+#endif
+    for (; p != end && IsDigit(*p); ++p) {
+      mantissa = mantissa * 10 + (*p - '0');
+      digits += (mantissa != 0);
+    }
+    exp10 = -static_cast<int>(p - frac_begin);
+    num_digits += p - frac_begin;
+  }
+  if (num_digits == 0) {  // 非十进制数字(如inf/nan), 交由strtod处理
+    const size_t kMaxSpecialLen = 32;
+    return StrtodFallback(begin, begin + std::min<size_t>(end - begin, kMaxSpecialLen), value);
+  }
+
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    const char* e = p + 1;
+    bool exp_neg = false;
+    if (e != end && (*e == '-' || *e == '+')) {
+      exp_neg = (*e == '-');
+      ++e;
+    }
+    if (e != end && IsDigit(*e)) {  // 指数无数字时不消费'e'
+      int exp_val = 0;
+      for (; e != end && IsDigit(*e); ++e) {
+        if (exp_val < 100000) {
+          exp_val = exp_val * 10 + (*e - '0');
+        }
+      }
+      exp10 += exp_neg ? -exp_val : exp_val;
+      p = e;
+    }
+  }
+
+  if (digits <= 19 && mantissa <= (uint64_t(1) << 53) && -22 <= exp10 && exp10 <= 22) {
+    double v = static_cast<double>(mantissa);
+    v = (exp10 < 0) ? v / kPow10[-exp10] : v * kPow10[exp10];
+    value = neg ? -v : v;
+    return p;
+  }
+  return StrtodFallback(begin, p, value);
+}
+
+//! 将无符号整数逆序写入缓冲区末尾, 返回首字符地址
+static inline char* WriteDigitsBackward(uint64_t value, char* end) {
+  do {
+    *--end = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  return end;
+}
+
+size_t FormatInt(int64_t value, char* buf) {
+  char tmp[24];
+  char* end = tmp + sizeof(tmp);
+  uint64_t abs_value = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+  char* p = WriteDigitsBackward(abs_value, end);
+  if (value < 0) {
+    *--p = '-';
+  }
+  size_t len = end - p;
+  memcpy(buf, p, len);
+  buf[len] = '\0';
+  return len;
+}
+
+size_t FormatFixed(double value, int precision, char* buf) {
+  double abs_value = std::fabs(value);
+  if (precision >= 0 && precision <= 15 && abs_value < 1e15) {
+    double scaled = abs_value * kPow10[precision];
+    double floor_scaled = std::floor(scaled);
+    double frac = scaled - floor_scaled;
+    // 乘积误差不超过半个ulp, 远离0.5时舍入方向与精确值一致
+    if (scaled < 1e15 && std::fabs(frac - 0.5) > scaled * 4.5e-16 + 1e-300) {
+      uint64_t digits = static_cast<uint64_t>(floor_scaled) + (frac > 0.5 ? 1 : 0);
+      char tmp[40];
+      char* end = tmp + sizeof(tmp);
+      char* p = end;
+      for (int i = 0; i < precision; ++i) {
+        *--p = static_cast<char>('0' + digits % 10);
+        digits /= 10;
+      }
+      if (precision > 0) {
+        *--p = '.';
+      }
+      p = WriteDigitsBackward(digits, p);
+      if (std::signbit(value)) {
+        *--p = '-';
+      }
+      size_t len = end - p;
+      memcpy(buf, p, len);
+      buf[len] = '\0';
+      return len;
+    }
+  }
+  int len = snprintf(buf, kFixedBufferSize, "%.*f", precision, value);
+  return len < 0 ? 0 : std::min(static_cast<size_t>(len), kFixedBufferSize - 1);
+}
+
 }  // namespace utils
 }  // namespace gmif
@@ -1,6 +1,7 @@
 #ifndef GMIF_SRC_UTILS_H_
 #define GMIF_SRC_UTILS_H_
 
+#include <cstdint>
 #include <iostream>
 #include <map>
 #include <set>
@@ -16,6 +17,39 @@
 namespace gmif {
 namespace utils {
 
+//! 非拥有的字符串片段, 指向外部缓冲区(C++17 std::string_view的简化替代)
+class StrView {
+ public:
+  StrView() : data_(nullptr), size_(0) {}
+  StrView(const char* data, size_t size) : data_(data), size_(size) {}
+  StrView(const char* s) : data_(s), size_(strlen(s)) {}
+  StrView(const std::string& s) : data_(s.data()), size_(s.size()) {}
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  const char* begin() const { return data_; }
+  const char* end() const { return data_ + size_; }
+  char operator[](size_t i) const { return data_[i]; }
+
+  void remove_prefix(size_t n) {
+    data_ += n;
+    size_ -= n;
+  }
+  void remove_suffix(size_t n) { size_ -= n; }
+
+  std::string str() const { return std::string(data_, size_); }
+
+ private:
+  const char* data_;
+  size_t size_;
+};
+
+bool operator==(StrView lhs, StrView rhs);
+bool operator!=(StrView lhs, StrView rhs);
+std::ostream& operator<<(std::ostream& os, StrView sv);
+
 void StrLower(std::string& str);
 void StrUpper(std::string& str);
 
@@ -30,6 +64,30 @@ void StrTrimSpace(std::string& str);
 void StrSplit(const std::string& str, const std::string& sep, std::vector<std::string>& res);
 void StrSplitKeepQuot(const std::string& str, char sep, std::vector<std::string>& res);
 
+void StrTrimLeft(StrView& str, const char* chars);
+void StrTrimRight(StrView& str, const char* chars);
+void StrTrim(StrView& str, const char* chars);
+void StrTrimSpace(StrView& str);
+
+//! 按空白字符分割, 连续空白视为一个分隔符, 结果指向原缓冲区
+void StrSplitSpace(StrView str, std::vector<StrView>& res);
+//! 同StrSplitKeepQuot, 结果指向原缓冲区
+void StrSplitKeepQuot(StrView str, char sep, std::vector<StrView>& res);
+/**
+ * @brief 同StrSplitKeepQuot, 并去除各字段两端的引号, 复用res容量时不分配内存
+ * @param max_fields 最多切分的字段数, 达到后不再扫描剩余内容
+ */
+void StrSplitUnquote(StrView str,
+                     char sep,
+                     std::vector<StrView>& res,
+                     size_t max_fields = SIZE_MAX);
+//! 统计StrSplitUnquote不限字段数时切分出的字段数, 不生成字段
+size_t StrCountFields(StrView str, char sep);
+
+//! 忽略大小写比较(仅ASCII)
+bool StrEqualNoCase(StrView str, StrView lower_str);
+bool StrStartsWithNoCase(StrView str, StrView lower_prefix);
+
 bool IsDoubleZero(double d);
 bool DoubleEqual(double d1, double d2);
 
@@ -46,6 +104,44 @@ double to_double(const std::string& s);
 double to_double(const char* s);
 int64_t to_int(const std::string& s);
 int64_t to_int(const char* s);
+double to_double(StrView s);
+int64_t to_int(StrView s);
+
+/**
+ * @brief 解析十进制浮点数
+ *
+ * 接受的语法为[+-]数字[.数字][(e|E)[+-]数字], 小数点固定为'.'; 对该语法的输入,
+ * 结果与"C"区域下的strtod逐位一致. 十六进制浮点数只解析到"0x"前的0. 整数尾数不超过2^53
+ * 且10的指数在[-22, 22]内时直接一次乘除得到正确舍入结果; 其余情况及不以数字开头的输入
+ * (如inf/nan, 此时跳过前导空白)回退到"C"区域的strtod_l, 结果均与当前区域设置无关.
+ * @param begin 起始地址
+ * @param end 结束地址
+ * @param value 解析结果
+ * @return 解析结束位置, 无法解析时返回begin
+ */
+const char* ParseDouble(const char* begin, const char* end, double& value);
+
+//! FormatFixed所需的缓冲区大小
+static const size_t kFixedBufferSize = 352;
+
+/**
+ * @brief 按定点小数格式化浮点数, 结果与printf("%.*f")逐字节一致
+ *
+ * 缩放后的整数不超过1e15且远离舍入边界时直接由整数生成数字, 其余情况回退到snprintf.
+ * @param value 浮点数
+ * @param precision 小数位数, 需在[0, 17]内
+ * @param buf 输出缓冲区, 大小至少为kFixedBufferSize
+ * @return 输出长度, 不含结尾的'\0'
+ */
+size_t FormatFixed(double value, int precision, char* buf);
+
+/**
+ * @brief 格式化十进制整数
+ * @param value 整数
+ * @param buf 输出缓冲区, 大小至少为21
+ * @return 输出长度
+ */
+size_t FormatInt(int64_t value, char* buf);
 
 }  // namespace utils
 }  // namespace gmif
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include "buffered_writer.h"
+
+using namespace gmif::io;
+
+class BufferedWriterBench : public ::testing::Test {
+ protected:
+  void SetUp() override { path_ = "test/data/buffered_writer_bench_dump.txt"; }
+  void TearDown() override { std::remove(path_.c_str()); }
+
+  static std::string ReadAll(const std::string& path) {
+    std::ifstream ifs(path.c_str(), std::ios_base::in | std::ios_base::binary);
+    return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+  }
+
+  std::string path_;
+};
+
+TEST_F(BufferedWriterBench, WriteCoords) {
+  std::mt19937_64 rng(7);
+  std::uniform_real_distribution<double> dist(70.0, 140.0);
+  const int kNumPts = 500000;
+  std::vector<double> coords(kNumPts * 2);
+  for (auto& v : coords) {
+    v = dist(rng);
+  }
+
+  auto run = [&](const char* name, const std::function<void()>& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    double sec = std::chrono::duration<double>(end - start).count();
+    std::string content = ReadAll(path_);
+    std::cout << name << ": " << content.size() / sec / (1 << 20) << " MB/s" << std::endl;
+    return content;
+  };
+
+  std::string stream_out = run("ofstream", [&]() {
+    std::ofstream ofs(path_.c_str(), std::ios_base::out | std::ios_base::trunc);
+    ofs << std::setprecision(8) << std::fixed;
+    for (int i = 0; i < kNumPts; ++i) {
+      ofs << coords[i * 2] << " " << coords[i * 2 + 1] << "\n";
+    }
+  });
+  std::string writer_out = run("BufferedWriter", [&]() {
+    BufferedWriter writer;
+    writer.Open(path_);
+    for (int i = 0; i < kNumPts; ++i) {
+      writer.WriteFixed(coords[i * 2], 8);
+      writer.Put(' ');
+      writer.WriteFixed(coords[i * 2 + 1], 8);
+      writer.Put('\n');
+    }
+    writer.Close();
+  });
+  EXPECT_EQ(stream_out, writer_out);
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include "simd_scan.h"
+#include "utils.h"
+
+using namespace gmif::utils;
+
+class UtilsBench : public ::testing::Test {};
+
+TEST_F(UtilsBench, ParseDouble) {
+  std::mt19937_64 rng(7);
+  std::uniform_real_distribution<double> dist(70.0, 140.0);
+  std::string data;
+  char buf[64];
+  const int kNumPts = 500000;
+  for (int i = 0; i < kNumPts; ++i) {
+    snprintf(buf, sizeof(buf), "%.7f %.7f\n", dist(rng), dist(rng) / 3);
+    data += buf;
+  }
+
+  auto run = [&](const char* name, const std::function<double()>& fn) {
+    auto start = std::chrono::steady_clock::now();
+    double sum = fn();
+    auto end = std::chrono::steady_clock::now();
+    double sec = std::chrono::duration<double>(end - start).count();
+    std::cout << name << ": " << data.size() / sec / (1 << 20) << " MB/s (checksum " << sum << ")"
+              << std::endl;
+    return sum;
+  };
+
+  double fast_sum = run("ParseDouble", [&]() {
+    double sum = 0, v = 0;
+    const char* p = data.data();
+    const char* end = p + data.size();
+    while (p != end) {
+      p = ParseDouble(p, end, v);
+      sum += v;
+      while (p != end && (*p == ' ' || *p == '\n')) ++p;
+    }
+    return sum;
+  });
+  double strtod_sum = run("strtod", [&]() {
+    double sum = 0;
+    const char* p = data.c_str();
+    char* next = nullptr;
+    for (int i = 0; i < kNumPts * 2; ++i, p = next) {
+      sum += strtod(p, &next);
+    }
+    return sum;
+  });
+  double stream_sum = run("istringstream", [&]() {
+    double sum = 0, v = 0;
+    std::istringstream iss(data);
+    while (iss >> v) {
+      sum += v;
+    }
+    return sum;
+  });
+  EXPECT_EQ(fast_sum, strtod_sum);
+  EXPECT_EQ(fast_sum, stream_sum);
+}
+
+TEST_F(UtilsBench, SplitFields) {
+  const int kNumRows = 200000;
+  std::vector<std::string> rows;
+  size_t bytes = 0;
+  for (int i = 0; i < kNumRows; ++i) {
+    rows.push_back(std::to_string(i) + ",\"" + std::to_string(i * 7 % 1000000) +
+                   "\",\"北京市海淀区中关村大街" + std::to_string(i % 100) +
+                   "号\",123.45678900,\"Residential Road Segment\",0,\"\",\"2020-01-01\"");
+    bytes += rows.back().size();
+  }
+  std::vector<StrView> v;
+  auto run = [&](const char* name, ScanIsa isa) {
+    size_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& row : rows) {
+      if (isa == ScanIsa::kScalar) {
+        SplitFieldsScalar(StrView(row), ',', true, v);
+      } else {
+        SplitFieldsSimd(isa, StrView(row), ',', true, v);
+      }
+      sum += v.size();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double sec = std::chrono::duration<double>(end - start).count();
+    std::cout << name << ": " << bytes / sec / (1 << 20) << " MB/s" << std::endl;
+    return sum;
+  };
+  size_t fields = run("SplitFieldsScalar", ScanIsa::kScalar);
+  EXPECT_EQ(run("SplitFieldsSimd(sse2)", ScanIsa::kSse2), fields);
+  EXPECT_EQ(run("SplitFieldsSimd(avx2)", ScanIsa::kAvx2), fields);
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include "attr_table.h"
+
+using namespace gmif;
+
+class AttrTableTest : public ::testing::Test {};
+
+TEST_F(AttrTableTest, TestStrDict) {
+  StrDict dict;
+  EXPECT_EQ(dict.Intern(utils::StrView("a")), 0);
+  EXPECT_EQ(dict.Intern(utils::StrView("")), 1);
+  EXPECT_EQ(dict.Intern(utils::StrView("a")), 0);
+  for (int i = 0; i < 1000; ++i) {  // 覆盖扩容
+    EXPECT_EQ(dict.Intern(utils::StrView(std::to_string(i))), i + 2);
+  }
+  EXPECT_EQ(dict.Intern(utils::StrView("999")), 1001);
+  EXPECT_EQ(dict.get(0), utils::StrView("a"));
+  EXPECT_EQ(dict.get(1), utils::StrView(""));
+  EXPECT_EQ(dict.size(), 1002);
+
+  // 释放哈希表后按取值数重建
+  StrDict assigned;
+  assigned.Assign(dict.getArena().data(), dict.getOffsets().data(), dict.size());
+  EXPECT_EQ(assigned.Intern(utils::StrView("999")), 1001);
+  EXPECT_EQ(assigned.Intern(utils::StrView("new")), 1002);
+  dict.Shrink();
+  EXPECT_EQ(dict.Intern(utils::StrView("a")), 0);
+  EXPECT_EQ(dict.Intern(utils::StrView("new")), 1002);
+
+  dict.DisableDedup();
+  EXPECT_EQ(dict.Intern(utils::StrView("a")), 1003);
+  EXPECT_EQ(dict.get(1003), utils::StrView("a"));
+}
+
+TEST_F(AttrTableTest, TestAppendRow) {
+  MifHeader header;
+  header.addColumn("id", "integer");
+  header.addColumn("name", "char(8)");
+  header.addColumn("length", "float");
+  AttrTable table(header);
+
+  std::vector<utils::StrView> items = {utils::StrView("12"), utils::StrView("road"),
+                                       utils::StrView("1.5")};
+  EXPECT_EQ(table.appendRow(items), 0);
+  items = {utils::StrView(""), utils::StrView("road"), utils::StrView("")};
+  EXPECT_EQ(table.appendRow(items), 1);
+  table.Shrink();
+
+  EXPECT_EQ(table.getRowSize(), 2);
+  EXPECT_EQ(table.getInt(0, 0), 12);
+  EXPECT_EQ(table.getInt(0, 1), 0);
+  EXPECT_EQ(table.getStr(1, 1), utils::StrView("road"));
+  EXPECT_EQ(table.getDouble(2, 0), 1.5);
+
+  AttrValue v;
+  table.getValue(1, 0, v);
+  EXPECT_EQ(v.getStr(), "road");
+  table.getValue(2, 1, v);
+  EXPECT_EQ(v.getDouble(), 0.0);
+}
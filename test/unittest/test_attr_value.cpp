@@ -48,4 +48,75 @@ TEST_F(AttrValueTest, TestGreater) {
   EXPECT_TRUE(AttrValue("abc") > AttrValue("abb"));
   EXPECT_TRUE(AttrValue(123.123) > AttrValue(123.122));
   EXPECT_TRUE(AttrValue(-123.123) > AttrValue(-123.124));
-}
\ No newline at end of file
+}
+TEST_F(AttrValueTest, TestKind) {
+  EXPECT_EQ(AttrValue().getKind(), AttrValue::Kind::kNull);
+  EXPECT_EQ(AttrValue(1).getKind(), AttrValue::Kind::kInt);
+  EXPECT_EQ(AttrValue(1.0).getKind(), AttrValue::Kind::kDouble);
+  EXPECT_EQ(AttrValue("1").getKind(), AttrValue::Kind::kStr);
+
+  AttrValue v(int64_t(1) << 40);
+  EXPECT_EQ(v.getInt64(), int64_t(1) << 40);
+  EXPECT_EQ(v.getStr(), "1099511627776.00000000");
+  EXPECT_EQ(AttrValue(-5).getStr(), "-5.00000000");
+  EXPECT_EQ(AttrValue(-0.0).getStr(), "-0.00000000");
+  EXPECT_EQ(AttrValue(" 12.5").getDouble(), 12.5);
+
+  // 读取不改变值类型
+  const AttrValue num(123);
+  EXPECT_EQ(num.getStr(), "123.00000000");
+  EXPECT_EQ(num.getKind(), AttrValue::Kind::kInt);
+  EXPECT_EQ(AttrValue("123"), num);
+}
+
+TEST_F(AttrValueTest, TestStrStorage) {
+  std::string short_str(24, 's');
+  std::string long_str(100, 'l');
+  AttrValue v(short_str);
+  EXPECT_EQ(v.getStr(), short_str);
+  v = long_str;
+  EXPECT_EQ(v.getStr(), long_str);
+  const char* data = v.getStrData();
+  v = short_str;  // 复用堆上容量
+  EXPECT_EQ(v.getStrData(), data);
+  EXPECT_EQ(v.getStr(), short_str);
+
+  AttrValue copy(v);
+  EXPECT_EQ(copy.getStr(), short_str);
+  EXPECT_NE(copy.getStrData(), v.getStrData());
+  AttrValue moved(std::move(v));
+  EXPECT_EQ(moved.getStrData(), data);
+  EXPECT_EQ(v.getKind(), AttrValue::Kind::kNull);
+
+  moved = 1.5;
+  EXPECT_EQ(moved.getDouble(), 1.5);
+  moved = copy;
+  EXPECT_EQ(moved.getStr(), short_str);
+  moved = moved;
+  EXPECT_EQ(moved.getStr(), short_str);
+}
+
+TEST_F(AttrValueTest, TestSharedStr) {
+  auto shared = std::make_shared<const std::string>(std::string(40, 'x'));
+  AttrValue v1;
+  v1.setStr(shared);
+  AttrValue v2(v1);
+  EXPECT_TRUE(v2.isSharedStr());
+  EXPECT_EQ(v2.getStrData(), shared->data());
+  EXPECT_EQ(shared.use_count(), 3);
+  EXPECT_EQ(v1, v2);
+  EXPECT_EQ(v1, AttrValue(*shared));
+  EXPECT_FALSE(v1 < v2);
+
+  v2.setStr(v2.getStrData() + 1, 10);  // 修改时复制为独立存储
+  EXPECT_FALSE(v2.isSharedStr());
+  EXPECT_EQ(v2.getStr(), std::string(10, 'x'));
+  v1 = 1;
+  EXPECT_EQ(shared.use_count(), 1);
+
+  AttrValue v3;
+  v3.setStr(shared);
+  AttrValue v4(std::move(v3));
+  EXPECT_TRUE(v4.isSharedStr());
+  EXPECT_EQ(shared.use_count(), 2);
+}
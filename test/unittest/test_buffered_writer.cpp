@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <sstream>
+#include "buffered_writer.h"
+
+using namespace gmif::io;
+
+class BufferedWriterTest : public ::testing::Test {
+ protected:
+  void SetUp() override { path_ = "test/data/buffered_writer_dump.txt"; }
+
+  static std::string ReadAll(const std::string& path) {
+    std::ifstream ifs(path.c_str(), std::ios_base::in | std::ios_base::binary);
+    return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+  }
+
+  std::string path_;
+};
+
+TEST_F(BufferedWriterTest, TestFixedMatchesStream) {
+  std::vector<double> values = {0.0,   -0.0,   1.0,       -1.5, 0.5,      2.5,         39.9041999,
+                                1e-9,  -1e-9,  0.0000005, 1e20, -3.75e15, 116.4073963, 0.00000049,
+                                123456789.123456789};
+  std::mt19937_64 rng(11);
+  std::uniform_real_distribution<double> dist(-180.0, 180.0);
+  for (int i = 0; i < 10000; ++i) {
+    values.push_back(dist(rng));
+  }
+
+  for (int precision : {0, 6, 8}) {
+    std::ostringstream oss;
+    oss << std::setprecision(precision) << std::fixed;
+    BufferedWriter writer;
+    ASSERT_TRUE(writer.Open(path_, 0));  // 最小缓冲区, 覆盖多次写出
+    for (double v : values) {
+      oss << v << " " << static_cast<int64_t>(v) << "\n";
+      writer.WriteFixed(v, precision);
+      writer.Put(' ');
+      writer.WriteInt(static_cast<int64_t>(v));
+      writer.Write("\n");
+    }
+    oss << std::numeric_limits<int64_t>::min() << "," << std::numeric_limits<int64_t>::max();
+    writer.WriteInt(std::numeric_limits<int64_t>::min());
+    writer.Put(',');
+    writer.WriteInt(std::numeric_limits<int64_t>::max());
+    ASSERT_TRUE(writer.Close());
+    EXPECT_EQ(ReadAll(path_), oss.str()) << "precision " << precision;
+  }
+}
+
+TEST_F(BufferedWriterTest, TestTrimZeros) {
+  BufferedWriter writer;
+  ASSERT_TRUE(writer.Open(path_, BufferedWriter::kDefaultBufferSize, true));
+  for (double v : {1.0, 1.5, -2.25, 100.0, 0.0, 116.40739630, 1e-9}) {
+    writer.WriteFixed(v, 8);
+    writer.Put(' ');
+  }
+  writer.WriteFixed(100.0, 0);
+  ASSERT_TRUE(writer.Close());
+  EXPECT_EQ(ReadAll(path_), "1 1.5 -2.25 100 0 116.4073963 0 100");
+}
+
+TEST_F(BufferedWriterTest, TestLargeWrite) {
+  std::string small(100, 'a');
+  std::string large(10000, 'b');
+  BufferedWriter writer;
+  ASSERT_TRUE(writer.Open(path_, 4096));
+  EXPECT_TRUE(writer.isOpen());
+  writer.Write(small);
+  writer.Write(large);  // 超过缓冲区, 直接写出
+  writer.Write(small);
+  writer.Write(std::string(4000, 'c'));  // 超过剩余空间, 先写出缓冲区
+  ASSERT_TRUE(writer.Close());
+  EXPECT_FALSE(writer.isOpen());
+  EXPECT_EQ(ReadAll(path_), small + large + small + std::string(4000, 'c'));
+
+  EXPECT_FALSE(writer.Open("test/data/no_exist_dir/buffered_writer_dump.txt"));
+}
+
+TEST_F(BufferedWriterTest, TestMemory) {
+  BufferedWriter writer;
+  writer.OpenMemory(0);
+  std::string exp;
+  for (int i = 0; i < 1000; ++i) {
+    writer.WriteInt(i);
+    writer.Put(' ');
+    writer.WriteFixed(i / 4.0, 6);
+    writer.Put('\n');
+    exp += std::to_string(i) + " " + std::to_string(i / 4.0) + "\n";
+  }
+  writer.Write(std::string(10000, 'a'));  // 超过缓冲区时扩容
+  exp += std::string(10000, 'a');
+  EXPECT_TRUE(writer.Flush());
+  ASSERT_EQ(writer.size(), exp.size());
+  EXPECT_EQ(std::string(writer.data(), writer.size()), exp);
+  writer.Clear();
+  EXPECT_EQ(writer.size(), 0u);
+  EXPECT_TRUE(writer.Close());
+  EXPECT_FALSE(writer.isOpen());
+}
+
+TEST_F(BufferedWriterTest, TestAsync) {
+  std::string exp;
+  BufferedWriter writer;
+  ASSERT_TRUE(writer.Open(path_, 0));
+  writer.StartAsync(1);
+  writer.setDropCache(true);
+  for (int i = 0; i < 20000; ++i) {
+    writer.WriteInt(i);
+    writer.Put(' ');
+    writer.WriteFixed(i / 8.0, 6);
+    writer.Put('\n');
+    exp += std::to_string(i) + " " + std::to_string(i / 8.0) + "\n";
+    if (i == 10000) {
+      EXPECT_TRUE(writer.Flush());
+      EXPECT_EQ(ReadAll(path_), exp);
+    }
+  }
+  writer.Write(std::string(10000, 'a'));  // 超过缓冲区, 分段提交
+  exp += std::string(10000, 'a');
+  ASSERT_TRUE(writer.Close());
+  EXPECT_EQ(ReadAll(path_), exp);
+}
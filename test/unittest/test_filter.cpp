@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include "filter.h"
+
+using namespace gmif;
+using utils::StrView;
+
+class FilterTest : public ::testing::Test {
+ protected:
+  MifHeader header_;
+
+  void SetUp() override {
+    header_.addColumn("id", "integer");
+    header_.addColumn("code", "char(6)");
+    header_.addColumn("length", "float");
+    header_.addColumn("kind", "smallint");
+  }
+
+  bool Match(const std::string& expr, const std::vector<StrView>& items) {
+    io::RowFilter filter;
+    EXPECT_EQ(filter.Compile(expr, header_), 0) << expr;
+    return filter.Match(items);
+  }
+};
+
+TEST_F(FilterTest, TestCompile) {
+  io::RowFilter filter;
+  EXPECT_EQ(filter.Compile("", header_), 0);
+  EXPECT_TRUE(filter.empty());
+  EXPECT_EQ(filter.getMaxField(), 0);
+
+  EXPECT_EQ(filter.Compile("CODE = '110100' or id > 3", header_), 0);
+  EXPECT_FALSE(filter.empty());
+  EXPECT_EQ(filter.getMaxField(), 2);
+
+  EXPECT_EQ(filter.Compile("kind in (1, 2) and not (length > 100)", header_), 0);
+  EXPECT_EQ(filter.getMaxField(), 4);
+
+  EXPECT_EQ(filter.Compile("no_exist = 1", header_), -1);
+  EXPECT_EQ(filter.Compile("id = 'abc'", header_), -1);
+  EXPECT_EQ(filter.Compile("id = ", header_), -1);
+  EXPECT_EQ(filter.Compile("(id = 1", header_), -1);
+  EXPECT_EQ(filter.Compile("id = 1 kind = 2", header_), -1);
+  EXPECT_EQ(filter.Compile("code = 'abc", header_), -1);
+  EXPECT_EQ(filter.Compile("id in ()", header_), -1);
+  EXPECT_TRUE(filter.empty());
+}
+
+TEST_F(FilterTest, TestMatch) {
+  std::vector<StrView> items = {"1237", "120100", "10.12", "5"};
+  EXPECT_TRUE(Match("id = 1237", items));
+  EXPECT_TRUE(Match("id == 1237.0 and code = \"120100\"", items));
+  EXPECT_FALSE(Match("id <> 1237", items));
+  EXPECT_TRUE(Match("length >= 10.12 AND length < 10.13", items));
+  EXPECT_FALSE(Match("length > 10.12", items));
+  EXPECT_TRUE(Match("kind in (1, 5) and code not in ('110100', 120101)", items));
+  EXPECT_TRUE(Match("code = 120100", items));  // 字符串列按字面文本比较
+  EXPECT_TRUE(Match("code > '12' and code < '121'", items));
+  EXPECT_TRUE(Match("not id < -1 or kind = 0", items));
+  EXPECT_TRUE(Match("kind = 0 or id = 0 or (code != '' and not kind in (0))", items));
+
+  // 空字段按默认值0比较
+  std::vector<StrView> empty_items = {"", "", "", ""};
+  EXPECT_TRUE(Match("id = 0 and length = 0 and code = ''", empty_items));
+}
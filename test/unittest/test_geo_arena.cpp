@@ -0,0 +1,157 @@
+#include <geos/geom/CoordinateArraySequence.h>
+#include <geos/geom/GeometryFactory.h>
+#include <geos/geom/LineString.h>
+#include <geos/geom/MultiLineString.h>
+#include <geos/geom/MultiPolygon.h>
+#include <geos/geom/Point.h>
+#include <geos/geom/Polygon.h>
+#include <gtest/gtest.h>
+#include "gmif/gmif.h"
+
+using namespace gmif;
+using namespace geos::geom;
+
+class GeoArenaTest : public ::testing::Test {
+ protected:
+  GeometryFactory::Ptr factory_ = GeometryFactory::create();
+  std::vector<GeometryPtr> geos_;
+
+  std::unique_ptr<CoordinateArraySequence> MakeSeq(std::vector<Coordinate> pts) {
+    return std::unique_ptr<CoordinateArraySequence>(new CoordinateArraySequence(std::move(pts)));
+  }
+
+  std::unique_ptr<Polygon> MakeBox(double x0, double y0, double x1, double y1, bool with_hole) {
+    auto shell = factory_->createLinearRing(
+        MakeSeq({{x0, y0}, {x0, y1}, {x1, y1}, {x1, y0}, {x0, y0}}));
+    std::vector<std::unique_ptr<LinearRing>> holes;
+    if (with_hole) {
+      double dx = (x1 - x0) / 4, dy = (y1 - y0) / 4;
+      holes.push_back(factory_->createLinearRing(MakeSeq({{x0 + dx, y0 + dy},
+                                                          {x1 - dx, y0 + dy},
+                                                          {x1 - dx, y1 - dy},
+                                                          {x0 + dx, y1 - dy},
+                                                          {x0 + dx, y0 + dy}})));
+    }
+    return factory_->createPolygon(std::move(shell), std::move(holes));
+  }
+
+  //! 点、线、多线、带内环的面、多面与空几何
+  void SetUp() override {
+    geos_.push_back(GeometryPtr(factory_->createPoint(Coordinate(1, 2))));
+    geos_.push_back(factory_->createLineString(MakeSeq({{0, 0}, {1, 1}, {2, 0}})));
+    std::vector<std::unique_ptr<Geometry>> lines;
+    lines.push_back(factory_->createLineString(MakeSeq({{0, 0}, {1, 1}})));
+    lines.push_back(factory_->createLineString(MakeSeq({{5, 5}, {6, 7}, {8, 9}})));
+    geos_.push_back(factory_->createMultiLineString(std::move(lines)));
+    geos_.push_back(MakeBox(10, 10, 20, 20, true));
+    std::vector<std::unique_ptr<Geometry>> polygons;
+    polygons.push_back(MakeBox(0, 0, 1, 1, false));
+    polygons.push_back(MakeBox(3, 3, 5, 5, true));
+    geos_.push_back(factory_->createMultiPolygon(std::move(polygons)));
+    geos_.push_back(nullptr);
+  }
+
+  static void ExpectGeoEqual(const GeometryPtr& exp, const GeometryPtr& act) {
+    if (exp == nullptr) {
+      EXPECT_TRUE(act == nullptr);
+      return;
+    }
+    ASSERT_TRUE(act != nullptr);
+    EXPECT_EQ(exp->getGeometryTypeId(), act->getGeometryTypeId());
+    EXPECT_EQ(exp->getNumGeometries(), act->getNumGeometries());
+    auto exp_coords = exp->getCoordinates();
+    auto act_coords = act->getCoordinates();
+    ASSERT_EQ(exp_coords->size(), act_coords->size());
+    for (size_t i = 0; i < exp_coords->size(); ++i) {
+      EXPECT_EQ(exp_coords->getAt(i), act_coords->getAt(i));
+    }
+  }
+};
+
+TEST_F(GeoArenaTest, TestAppendAndConvert) {
+  GeoArena arena;
+  for (const auto& geo : geos_) {
+    ASSERT_TRUE(arena.append(geo.get()));
+  }
+  ASSERT_EQ(arena.size(), geos_.size());
+  EXPECT_EQ(arena.getType(3), GEOS_POLYGON);
+  EXPECT_EQ(arena.getType(5), -1);
+  EXPECT_EQ(arena.getElemParts().back(), 7u);  // 1 + 1 + 2 + 1 + 2
+  EXPECT_EQ(arena.getPartRings().back(), 9u);  // 两个面各带一个内环
+  EXPECT_EQ(arena.getCoords().size() / 2, arena.getRingCoords().back());
+  for (size_t i = 0; i < geos_.size(); ++i) {
+    GeometryPtr geo;
+    ASSERT_EQ(arena.toGeometry(i, geo), 0);
+    ExpectGeoEqual(geos_[i], geo);
+    ASSERT_EQ(arena.toGeometry(i, geo, factory_.get()), 0);
+    ExpectGeoEqual(geos_[i], geo);
+
+    Envelope env;
+    arena.getEnvelope(i, env);
+    if (geos_[i] == nullptr) {
+      EXPECT_TRUE(env.isNull());
+    } else {
+      EXPECT_TRUE(env.equals(geos_[i]->getEnvelopeInternal()));
+    }
+  }
+  auto holed = std::dynamic_pointer_cast<Polygon>(GeometryPtr(MakeBox(0, 0, 4, 4, true)));
+  ASSERT_TRUE(arena.append(holed.get()));
+  GeometryPtr geo;
+  ASSERT_EQ(arena.toGeometry(arena.size() - 1, geo), 0);
+  ASSERT_TRUE(std::dynamic_pointer_cast<Polygon>(geo) != nullptr);
+  EXPECT_EQ(std::dynamic_pointer_cast<Polygon>(geo)->getNumInteriorRing(), 1u);
+
+  // 坐标数不合法时不修改坐标区
+  size_t num_coords = arena.getCoords().size();
+  auto single = factory_->createLineString(MakeSeq({{0, 0}}));
+  EXPECT_FALSE(arena.append(single.get()));
+  EXPECT_EQ(arena.size(), geos_.size() + 1);
+  EXPECT_EQ(arena.getCoords().size(), num_coords);
+  EXPECT_EQ(arena.getRingCoords().back(), num_coords / 2);
+}
+
+TEST_F(GeoArenaTest, TestConcat) {
+  GeoArena first;
+  GeoArena second;
+  for (size_t i = 0; i < geos_.size(); ++i) {
+    ASSERT_TRUE((i < 3 ? first : second).append(geos_[i].get()));
+  }
+  GeoArena whole;
+  whole.append(first);
+  whole.append(second);
+  GeoArena picked;
+  for (size_t i = geos_.size(); i > 0; --i) {
+    picked.append(whole, i - 1);
+  }
+  ASSERT_EQ(whole.size(), geos_.size());
+  ASSERT_EQ(picked.size(), geos_.size());
+  for (size_t i = 0; i < geos_.size(); ++i) {
+    GeometryPtr geo;
+    ASSERT_EQ(whole.toGeometry(i, geo), 0);
+    ExpectGeoEqual(geos_[i], geo);
+    ASSERT_EQ(picked.toGeometry(geos_.size() - 1 - i, geo), 0);
+    ExpectGeoEqual(geos_[i], geo);
+  }
+
+  // 整体设置时校验偏移与类型
+  GeoArena restored;
+  auto types = whole.getTypes();
+  auto elem_parts = whole.getElemParts();
+  auto part_rings = whole.getPartRings();
+  auto ring_coords = whole.getRingCoords();
+  auto coords = whole.getCoords();
+  types[0] = GEOS_LINESTRING;  // 点只有1个坐标
+  EXPECT_FALSE(restored.assign(std::vector<int32_t>(types), std::vector<uint64_t>(elem_parts),
+                               std::vector<uint64_t>(part_rings),
+                               std::vector<uint64_t>(ring_coords), std::vector<double>(coords)));
+  types[0] = GEOS_POINT;
+  EXPECT_FALSE(restored.assign(std::vector<int32_t>(types), std::vector<uint64_t>(elem_parts),
+                               std::vector<uint64_t>(part_rings),
+                               std::vector<uint64_t>(ring_coords),
+                               std::vector<double>(coords.begin(), coords.end() - 2)));
+  EXPECT_EQ(restored.size(), 0u);
+  ASSERT_TRUE(restored.assign(std::move(types), std::move(elem_parts), std::move(part_rings),
+                              std::move(ring_coords), std::move(coords)));
+  EXPECT_EQ(restored.size(), geos_.size());
+  EXPECT_EQ(restored.getCoords(), whole.getCoords());
+}
@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+#include <fstream>
+#include <thread>
+#include <type_traits>
+#include "gmif/gmif.h"
+
+using namespace gmif;
+
+class LayerCatalogTest : public ::testing::Test {
+ protected:
+  std::string data_dir_;
+  std::string point_demo_path_;
+  std::string line_demo_path_;
+  std::string region_demo_path_;
+
+  void SetUp() override {
+    data_dir_ = "test/data/";
+    point_demo_path_ = data_dir_ + "point_demo";
+    line_demo_path_ = data_dir_ + "line_demo";
+    region_demo_path_ = data_dir_ + "region_demo";
+  }
+
+  //! 图层计入预算的大小
+  size_t LayerCharge(const std::string& layer_path) {
+    LayerCatalog catalog;
+    return catalog.Get(layer_path) != nullptr ? catalog.memoryUsage() : 0;
+  }
+
+  //! 图层文件大小
+  size_t LayerFileSize(const std::string& layer_path) {
+    size_t size = 0;
+    for (const char* ext : {".mif", ".mid"}) {
+      std::ifstream ifs(layer_path + ext, std::ios_base::binary | std::ios_base::ate);
+      size += static_cast<size_t>(ifs.tellg());
+    }
+    return size;
+  }
+};
+
+TEST_F(LayerCatalogTest, TestGet) {
+  LayerCatalog catalog;
+  std::shared_ptr<const Mif> mif_ptr = catalog.Get(line_demo_path_);
+  ASSERT_TRUE(mif_ptr != nullptr);
+  std::shared_ptr<Mif> expect_ptr = Mif::Load(line_demo_path_);
+  EXPECT_EQ(mif_ptr->elements().size(), expect_ptr->elements().size());
+  EXPECT_EQ(mif_ptr->header().getColumnSize(), expect_ptr->header().getColumnSize());
+  EXPECT_EQ(catalog.Get(line_demo_path_), mif_ptr);
+  EXPECT_EQ(catalog.size(), 1);
+  EXPECT_EQ(catalog.memoryUsage(), LayerCharge(line_demo_path_));
+  // 解析出的元素与几何对象占用的内存大于文件本身
+  EXPECT_GT(catalog.memoryUsage(), LayerFileSize(line_demo_path_));
+
+  // 共享的图层只能读取元素
+  static_assert(std::is_same<decltype(mif_ptr->elements()[0]),
+                             std::shared_ptr<const MifElement>>::value,
+                "shared layer elements must be const");
+  size_t num_elements = 0;
+  for (const auto& elem : mif_ptr->elements()) {
+    EXPECT_EQ(elem->getAttrsMap(), expect_ptr->elements()[num_elements++]->getAttrsMap());
+  }
+  EXPECT_EQ(num_elements, expect_ptr->elements().size());
+
+  EXPECT_TRUE(catalog.Get(data_dir_ + "no_exist") == nullptr);
+  EXPECT_EQ(catalog.size(), 1);
+
+  catalog.Invalidate(line_demo_path_);
+  EXPECT_EQ(catalog.size(), 0);
+  EXPECT_NE(catalog.Get(line_demo_path_), mif_ptr);
+  catalog.Clear();
+  EXPECT_EQ(catalog.size(), 0);
+  EXPECT_EQ(catalog.memoryUsage(), 0);
+}
+
+TEST_F(LayerCatalogTest, TestFileChanged) {
+  std::shared_ptr<Mif> demo_ptr = Mif::Load(region_demo_path_);
+  ASSERT_TRUE(demo_ptr != nullptr);
+  std::string layer_path = region_demo_path_ + "_catalog_dump";
+  ASSERT_TRUE(demo_ptr->Dump(layer_path));
+
+  LayerCatalog catalog;
+  std::shared_ptr<const Mif> mif_ptr = catalog.Get(layer_path);
+  ASSERT_TRUE(mif_ptr != nullptr);
+  EXPECT_EQ(mif_ptr->elements().size(), demo_ptr->elements().size());
+
+  // 文件大小变化后重新加载, 已取得的图层不受影响
+  demo_ptr->elements().pop_back();
+  ASSERT_TRUE(demo_ptr->Dump(layer_path));
+  std::shared_ptr<const Mif> reload_ptr = catalog.Get(layer_path);
+  ASSERT_TRUE(reload_ptr != nullptr);
+  EXPECT_EQ(reload_ptr->elements().size(), demo_ptr->elements().size());
+  EXPECT_EQ(mif_ptr->elements().size(), demo_ptr->elements().size() + 1);
+  EXPECT_EQ(catalog.size(), 1);
+  EXPECT_EQ(catalog.memoryUsage(), LayerCharge(layer_path));
+}
+
+TEST_F(LayerCatalogTest, TestEvict) {
+  LayerCatalogOptions options;
+  options.memory_budget = LayerCharge(point_demo_path_) + LayerCharge(line_demo_path_) +
+                          LayerCharge(region_demo_path_) - 1;
+  LayerCatalog catalog(options);
+  std::shared_ptr<const Mif> point_ptr = catalog.Get(point_demo_path_);
+  std::shared_ptr<const Mif> line_ptr = catalog.Get(line_demo_path_);
+  ASSERT_TRUE(point_ptr != nullptr);
+  ASSERT_TRUE(line_ptr != nullptr);
+  EXPECT_EQ(catalog.Get(point_demo_path_), point_ptr);
+
+  // 超出预算时淘汰最近最少使用的line_demo, 被淘汰的图层仍然有效
+  ASSERT_TRUE(catalog.Get(region_demo_path_) != nullptr);
+  EXPECT_EQ(catalog.size(), 2);
+  EXPECT_EQ(catalog.memoryUsage(), LayerCharge(point_demo_path_) + LayerCharge(region_demo_path_));
+  EXPECT_EQ(catalog.Get(point_demo_path_), point_ptr);
+  EXPECT_FALSE(line_ptr->elements().empty());
+  EXPECT_NE(catalog.Get(line_demo_path_), line_ptr);
+
+  // 单个图层超出预算时不缓存
+  options.memory_budget = 1;
+  LayerCatalog small_catalog(options);
+  EXPECT_TRUE(small_catalog.Get(point_demo_path_) != nullptr);
+  EXPECT_EQ(small_catalog.size(), 0);
+  EXPECT_EQ(small_catalog.memoryUsage(), 0);
+}
+
+TEST_F(LayerCatalogTest, TestDecodeCacheCharge) {
+  LayerCatalogOptions options;
+  options.load.columnar_attrs = true;
+  LayerCatalog catalog(options);
+  std::shared_ptr<const Mif> mif_ptr = catalog.Get(region_demo_path_);
+  ASSERT_TRUE(mif_ptr != nullptr);
+  size_t charge = catalog.memoryUsage();
+
+  // 按列读取不产生解码缓存
+  for (const auto& elem : mif_ptr->elements()) {
+    EXPECT_NO_THROW(elem->getAttr("id"));
+  }
+  EXPECT_EQ(catalog.memoryUsage(), charge);
+
+  // 读取整行属性产生的解码缓存重新计入预算
+  for (const auto& elem : mif_ptr->elements()) {
+    EXPECT_FALSE(elem->getAttrsMap().empty());
+  }
+  EXPECT_GT(catalog.memoryUsage(), charge);
+  EXPECT_EQ(catalog.Get(region_demo_path_), mif_ptr);
+
+  // 解码缓存使图层超出预算时淘汰
+  options.memory_budget = charge;
+  LayerCatalog small_catalog(options);
+  std::shared_ptr<const Mif> small_ptr = small_catalog.Get(region_demo_path_);
+  ASSERT_TRUE(small_ptr != nullptr);
+  EXPECT_EQ(small_catalog.size(), 1);
+  small_ptr->elements().front()->getAttrsMap();
+  EXPECT_EQ(small_catalog.Get(region_demo_path_), small_ptr);
+  EXPECT_EQ(small_catalog.size(), 0);
+  EXPECT_EQ(small_catalog.memoryUsage(), 0);
+}
+
+TEST_F(LayerCatalogTest, TestConcurrentGet) {
+  // 列式属性的共享图层可并发只读访问
+  LayerCatalogOptions options;
+  options.load.columnar_attrs = true;
+  LayerCatalog catalog(options);
+  const size_t num_threads = 8;
+  std::vector<std::shared_ptr<const Mif>> results(num_threads * 3);
+  std::vector<size_t> num_attrs(num_threads, 0);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      results[t * 3] = catalog.Get(point_demo_path_);
+      results[t * 3 + 1] = catalog.Get(line_demo_path_);
+      results[t * 3 + 2] = catalog.Get(region_demo_path_);
+      for (size_t i = t * 3; i < t * 3 + 3; ++i) {
+        for (size_t j = 0; results[i] != nullptr && j < results[i]->elements().size(); ++j) {
+          num_attrs[t] += results[i]->elements().get(j)->getAttrsMap().size();
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  // 同一图层只加载一次, 各线程取得同一对象
+  for (size_t i = 0; i < results.size(); ++i) {
+    ASSERT_TRUE(results[i] != nullptr);
+    EXPECT_EQ(results[i], results[i % 3]);
+  }
+  for (size_t t = 1; t < num_threads; ++t) {
+    EXPECT_EQ(num_attrs[t], num_attrs[0]);
+  }
+  EXPECT_EQ(catalog.size(), 3);
+}
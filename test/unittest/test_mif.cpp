@@ -1,4 +1,5 @@
 #include <geos/geom/CoordinateArraySequence.h>
+#include <geos/geom/GeometryFactory.h>
 #include <geos/geom/LineString.h>
 #include <geos/geom/MultiLineString.h>
 #include <geos/geom/MultiPolygon.h>
@@ -6,6 +7,9 @@
 #include <geos/geom/Polygon.h>
 #include <gtest/gtest.h>
 #include <chrono>
+#include <fstream>
+#include <mutex>
+#include <thread>
 #include "gmif/gmif.h"
 #include "utils.h"
 
@@ -218,4 +222,867 @@ TEST_F(MifTest, TestRegionDemo) {
   EXPECT_EQ(coords2.getAt(0), coords2.getAt(5));
 
   EXPECT_TRUE(mif_ptr->Dump(region_demo_path_ + "_dump"));
-}
\ No newline at end of file
+}
+
+TEST_F(MifTest, TestLoadMappedEqualBuffered) {
+  for (const auto& path : {point_demo_path_, line_demo_path_, region_demo_path_}) {
+    LoadOptions options;
+    options.use_mmap = true;
+    std::shared_ptr<Mif> mapped = Mif::Load(path, options);
+    options.use_mmap = false;
+    std::shared_ptr<Mif> buffered = Mif::Load(path, options);
+    ASSERT_TRUE(mapped != nullptr);
+    ASSERT_TRUE(buffered != nullptr);
+    ASSERT_EQ(mapped->elements().size(), buffered->elements().size());
+    for (size_t i = 0; i < mapped->elements().size(); ++i) {
+      auto& lhs = mapped->elements()[i];
+      auto& rhs = buffered->elements()[i];
+      EXPECT_EQ(lhs->getAttrsMap(), rhs->getAttrsMap());
+      auto lhs_coords = lhs->getGeo()->getCoordinates();
+      auto rhs_coords = rhs->getGeo()->getCoordinates();
+      ASSERT_EQ(lhs_coords->size(), rhs_coords->size());
+      for (size_t j = 0; j < lhs_coords->size(); ++j) {
+        EXPECT_EQ(lhs_coords->getAt(j), rhs_coords->getAt(j));
+      }
+    }
+  }
+}
+
+TEST_F(MifTest, TestMifIStream) {
+  std::shared_ptr<Mif> mif_ptr = Mif::Load(region_demo_path_);
+  ASSERT_TRUE(mif_ptr != nullptr);
+
+  MifIStream ifs;
+  MifElement elem;
+  EXPECT_FALSE(ifs.isOpen());
+  EXPECT_EQ(ifs.Read(elem), -1);
+  EXPECT_FALSE(ifs.Open(data_dir_ + "no_exist"));
+
+  LoadOptions options;
+  options.use_mmap = false;
+  ASSERT_TRUE(ifs.Open(region_demo_path_, options));
+  EXPECT_EQ(ifs.header().getColumnSize(), 4);
+  EXPECT_EQ(ifs.header().getDelimiter(), ',');
+
+  size_t count = 0;
+  int status = 0;
+  while ((status = ifs.Read(elem)) == 0) {
+    ASSERT_LT(count, mif_ptr->elements().size());
+    const auto& exp_elem = mif_ptr->elements()[count];
+    EXPECT_EQ(elem.getAttrsMap(), exp_elem->getAttrsMap());
+    ASSERT_TRUE(elem.getGeo() != nullptr);
+    EXPECT_EQ(elem.getGeo()->getGeometryTypeId(), exp_elem->getGeo()->getGeometryTypeId());
+    EXPECT_EQ(elem.getGeo()->getNumPoints(), exp_elem->getGeo()->getNumPoints());
+    ++count;
+  }
+  EXPECT_EQ(status, 1);
+  EXPECT_EQ(count, 4);
+
+  ifs.Close();
+  EXPECT_FALSE(ifs.isOpen());
+}
+
+TEST_F(MifTest, TestMifOStream) {
+  std::shared_ptr<Mif> mif_ptr = Mif::Load(line_demo_path_);
+  ASSERT_TRUE(mif_ptr != nullptr);
+
+  MifElement elem;
+  MifOStream ofs;
+  EXPECT_EQ(ofs.Write(elem), -1);
+
+  std::string out_path = line_demo_path_ + "_ostream_dump";
+  ASSERT_TRUE(ofs.Open(out_path, mif_ptr->header()));
+  EXPECT_TRUE(ofs.isOpen());
+  for (auto& e : mif_ptr->elements()) {
+    EXPECT_EQ(ofs.Write(*e), 0);
+  }
+  EXPECT_TRUE(ofs.Close());
+  EXPECT_FALSE(ofs.isOpen());
+
+  std::shared_ptr<Mif> reload_ptr = Mif::Load(out_path);
+  ASSERT_TRUE(reload_ptr != nullptr);
+  ASSERT_EQ(reload_ptr->elements().size(), mif_ptr->elements().size());
+  for (size_t i = 0; i < mif_ptr->elements().size(); ++i) {
+    EXPECT_EQ(reload_ptr->elements()[i]->getAttr("id").getInt(),
+              mif_ptr->elements()[i]->getAttr("id").getInt());
+    EXPECT_EQ(reload_ptr->elements()[i]->getGeo()->getNumPoints(),
+              mif_ptr->elements()[i]->getGeo()->getNumPoints());
+  }
+}
+
+void ExpectMifEqual(const std::shared_ptr<Mif>& lhs, const std::shared_ptr<Mif>& rhs) {
+  ASSERT_TRUE(lhs != nullptr);
+  ASSERT_TRUE(rhs != nullptr);
+  EXPECT_EQ(lhs->header().getColumnSize(), rhs->header().getColumnSize());
+  ASSERT_EQ(lhs->elements().size(), rhs->elements().size());
+  for (size_t i = 0; i < lhs->elements().size(); ++i) {
+    auto& l = lhs->elements()[i];
+    auto& r = rhs->elements()[i];
+    EXPECT_EQ(l->getAttrsMap(), r->getAttrsMap());
+    ASSERT_EQ(l->getGeo() == nullptr, r->getGeo() == nullptr);
+    if (l->getGeo() == nullptr) {
+      continue;
+    }
+    EXPECT_EQ(l->getGeo()->getGeometryTypeId(), r->getGeo()->getGeometryTypeId());
+    auto l_coords = l->getGeo()->getCoordinates();
+    auto r_coords = r->getGeo()->getCoordinates();
+    ASSERT_EQ(l_coords->size(), r_coords->size());
+    for (size_t j = 0; j < l_coords->size(); ++j) {
+      EXPECT_EQ(l_coords->getAt(j), r_coords->getAt(j));
+    }
+  }
+}
+
+TEST_F(MifTest, TestParallelLoad) {
+  // 重复写入示例数据构造多任务块图层
+  std::string big_path = data_dir_ + "parallel_demo_dump";
+  std::shared_ptr<Mif> demo_ptr = Mif::Load(region_demo_path_);
+  ASSERT_TRUE(demo_ptr != nullptr);
+  MifOStream ofs;
+  ASSERT_TRUE(ofs.Open(big_path, demo_ptr->header()));
+  for (int i = 0; i < 50; ++i) {
+    for (auto& e : demo_ptr->elements()) {
+      e->addOrUpdateAttr("id", AttrValue(i));
+      ASSERT_EQ(ofs.Write(*e), 0);
+    }
+  }
+  ASSERT_TRUE(ofs.Close());
+
+  for (const auto& path : {point_demo_path_, line_demo_path_, region_demo_path_, big_path}) {
+    std::shared_ptr<Mif> seq_ptr = Mif::Load(path);
+    for (size_t num_threads : {0, 2, 3, 8}) {
+      LoadOptions options;
+      options.num_threads = num_threads;
+      std::shared_ptr<Mif> par_ptr = Mif::Load(path, options);
+      ExpectMifEqual(seq_ptr, par_ptr);
+
+      options.mid_only = true;
+      par_ptr = Mif::Load(path, options);
+      ASSERT_TRUE(par_ptr != nullptr);
+      ASSERT_EQ(par_ptr->elements().size(), seq_ptr->elements().size());
+      EXPECT_TRUE(par_ptr->elements().back()->getGeo() == nullptr);
+    }
+  }
+}
+
+std::string ReadFileContent(const std::string& path) {
+  std::ifstream ifs(path.c_str(), std::ios_base::binary);
+  return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+TEST_F(MifTest, TestLoadBatch) {
+  std::vector<std::string> layers = Mif::ListLayers(data_dir_ + "*_demo.*");
+  std::vector<std::string> expect_layers = {line_demo_path_, point_demo_path_, region_demo_path_};
+  ASSERT_EQ(layers, expect_layers);
+  EXPECT_TRUE(Mif::ListLayers(data_dir_ + "no_exist*").empty());
+
+  layers.push_back(data_dir_ + "no_exist");
+  BatchLoadOptions options;
+  options.num_threads = 2;
+  std::vector<LayerLoadResult> results = Mif::LoadBatch(layers, options);
+  ASSERT_EQ(results.size(), layers.size());
+  for (size_t i = 0; i < expect_layers.size(); ++i) {
+    EXPECT_EQ(results[i].layer_path, layers[i]);
+    EXPECT_TRUE(results[i].error.empty());
+    ExpectMifEqual(std::move(results[i].mif), Mif::Load(layers[i]));
+  }
+  EXPECT_TRUE(results.back().mif == nullptr);
+  EXPECT_EQ(results.back().error, "can't open mif/mid file");
+
+  // 失败原因来自加载过程
+  BatchLoadOptions bad_options = options;
+  bad_options.load.columns = {"no-exist"};
+  results = Mif::LoadBatch({line_demo_path_}, bad_options);
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_EQ(results[0].error, "compile filter or resolve columns failed");
+
+  // 回调取走图层, 批量加载不保留结果
+  std::mutex mutex;
+  size_t num_elements = 0;
+  size_t num_failed = Mif::LoadBatch(layers, options, [&](size_t i, LayerLoadResult& result) {
+    std::unique_ptr<Mif> mif = std::move(result.mif);
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(result.layer_path, layers[i]);
+    num_elements += mif != nullptr ? mif->elements().size() : 0;
+  });
+  EXPECT_EQ(num_failed, 1);
+  size_t expect_elements = 0;
+  for (const auto& path : expect_layers) {
+    expect_elements += Mif::Load(path)->elements().size();
+  }
+  EXPECT_EQ(num_elements, expect_elements);
+}
+
+TEST_F(MifTest, TestColumnarAttrs) {
+  for (size_t num_threads : {1, 3}) {
+    LoadOptions options;
+    options.num_threads = num_threads;
+    std::shared_ptr<Mif> row_ptr = Mif::Load(region_demo_path_, options);
+    options.columnar_attrs = true;
+    std::shared_ptr<Mif> col_ptr = Mif::Load(region_demo_path_, options);
+    ASSERT_TRUE(col_ptr != nullptr);
+
+    // 只读访问不物化
+    auto& elem = col_ptr->elements().at(3);
+    EXPECT_TRUE(elem->getAttrTable() != nullptr);
+    EXPECT_TRUE(elem->hasColumn("code"));
+    EXPECT_FALSE(elem->hasColumn("no-exist"));
+    AttrValue v;
+    EXPECT_TRUE(elem->getAttr("code", v));
+    EXPECT_EQ(v.getStr(), "120100");
+    EXPECT_FALSE(elem->getAttr("no-exist", v));
+    EXPECT_TRUE(elem->getAttrTable() != nullptr);
+
+    // 输出与按行存储一致
+    ASSERT_TRUE(row_ptr->Dump(data_dir_ + "row_attrs_dump"));
+    ASSERT_TRUE(col_ptr->Dump(data_dir_ + "columnar_attrs_dump"));
+    EXPECT_EQ(ReadFileContent(data_dir_ + "row_attrs_dump.mid"),
+              ReadFileContent(data_dir_ + "columnar_attrs_dump.mid"));
+
+    // 只读访问整行属性时缓存解码结果, 不解除关联, 可多线程并发读取
+    const MifElement& const_elem = *elem;
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+      readers.emplace_back([&]() {
+        EXPECT_EQ(const_elem.getAttrsMap(), row_ptr->elements().at(3)->getAttrsMap());
+        EXPECT_EQ(const_elem.getAttr("id").getInt(), 1237);
+      });
+    }
+    for (auto& t : readers) {
+      t.join();
+    }
+    EXPECT_TRUE(elem->getAttrTable() != nullptr);
+
+    // const getAttr只读取单元格, 非const getAttr返回可修改的引用并解除关联
+    const MifElement& other_elem = *col_ptr->elements().at(2);
+    EXPECT_EQ(other_elem.getAttr("code").getStr(),
+              row_ptr->elements().at(2)->getAttr("code").getStr());
+    EXPECT_THROW(other_elem.getAttr("no-exist"), std::out_of_range);
+    EXPECT_TRUE(other_elem.getAttrTable() != nullptr);
+    col_ptr->elements().at(2)->getAttr("code") = AttrValue("update-value");
+    EXPECT_TRUE(other_elem.getAttrTable() == nullptr);
+    EXPECT_EQ(other_elem.getAttr("code").getStr(), "update-value");
+    row_ptr->elements().at(2)->getAttr("code") = AttrValue("update-value");
+
+    // 修改时物化, 之后行为与按行存储一致
+    elem->addOrUpdateAttr("code", AttrValue("update-value"));
+    EXPECT_TRUE(elem->getAttrTable() == nullptr);
+    EXPECT_EQ(elem->getAttr("code").getStr(), "update-value");
+    row_ptr->elements().at(3)->addOrUpdateAttr("code", AttrValue("update-value"));
+    ExpectMifEqual(row_ptr, col_ptr);
+  }
+}
+
+TEST_F(MifTest, TestDumpCompactFormat) {
+  for (const auto& path : {point_demo_path_, line_demo_path_, region_demo_path_}) {
+    std::shared_ptr<Mif> mif_ptr = Mif::Load(path);
+    ASSERT_TRUE(mif_ptr != nullptr);
+    DumpOptions options;
+    options.compat_format = false;
+    options.buffer_size = 0;
+    ASSERT_TRUE(mif_ptr->Dump(path + "_compact_dump", options));
+    ASSERT_TRUE(mif_ptr->Dump(path + "_compat_dump"));
+    EXPECT_LE(ReadFileContent(path + "_compact_dump.mif").size(),
+              ReadFileContent(path + "_compat_dump.mif").size());
+    EXPECT_LT(ReadFileContent(path + "_compact_dump.mid").size(),
+              ReadFileContent(path + "_compat_dump.mid").size());
+
+    // 去除末尾的0不改变数值
+    std::shared_ptr<Mif> compact = Mif::Load(path + "_compact_dump");
+    std::shared_ptr<Mif> compat = Mif::Load(path + "_compat_dump");
+    ASSERT_TRUE(compact != nullptr);
+    ASSERT_TRUE(compat != nullptr);
+    ASSERT_EQ(compact->elements().size(), compat->elements().size());
+    for (size_t i = 0; i < compact->elements().size(); ++i) {
+      auto& lhs = compact->elements()[i];
+      auto& rhs = compat->elements()[i];
+      EXPECT_EQ(lhs->getAttrsMap(), rhs->getAttrsMap());
+      auto lhs_coords = lhs->getGeo()->getCoordinates();
+      auto rhs_coords = rhs->getGeo()->getCoordinates();
+      ASSERT_EQ(lhs_coords->size(), rhs_coords->size());
+      for (size_t j = 0; j < lhs_coords->size(); ++j) {
+        EXPECT_EQ(lhs_coords->getAt(j), rhs_coords->getAt(j));
+      }
+    }
+  }
+}
+
+TEST_F(MifTest, TestParallelDump) {
+  for (const auto& path : {point_demo_path_, line_demo_path_, region_demo_path_}) {
+    for (bool lazy : {false, true}) {
+      LoadOptions load_options;
+      load_options.columnar_attrs = lazy;
+      load_options.lazy_geo = lazy;
+      std::shared_ptr<Mif> mif_ptr = Mif::Load(path, load_options);
+      ASSERT_TRUE(mif_ptr != nullptr);
+      // 重复元素以产生多个任务块并复用槽位
+      auto elements = mif_ptr->elements();
+      for (int i = 0; i < 5000; ++i) {
+        mif_ptr->elements().push_back(elements[i % elements.size()]);
+      }
+      ASSERT_TRUE(mif_ptr->Dump(path + "_seq_dump"));
+      for (size_t num_threads : {2, 3}) {
+        DumpOptions options;
+        options.num_threads = num_threads;
+        ASSERT_TRUE(mif_ptr->Dump(path + "_parallel_dump", options));
+        EXPECT_EQ(ReadFileContent(path + "_parallel_dump.mif"),
+                  ReadFileContent(path + "_seq_dump.mif"));
+        EXPECT_EQ(ReadFileContent(path + "_parallel_dump.mid"),
+                  ReadFileContent(path + "_seq_dump.mid"));
+      }
+      if (lazy) {
+        EXPECT_TRUE(mif_ptr->elements()[0]->isGeoPending());
+      }
+
+      DumpOptions options;
+      options.num_threads = 3;
+      mif_ptr->elements()[4000] = nullptr;
+      EXPECT_FALSE(mif_ptr->Dump(path + "_parallel_dump", options));
+      mif_ptr->elements().resize(elements.size());
+      EXPECT_TRUE(mif_ptr->Dump(path + "_parallel_dump", options));
+      mif_ptr->elements().clear();
+      EXPECT_TRUE(mif_ptr->Dump(path + "_parallel_dump", options));
+    }
+  }
+}
+
+TEST_F(MifTest, TestAsyncDump) {
+  std::shared_ptr<Mif> mif_ptr = Mif::Load(region_demo_path_);
+  ASSERT_TRUE(mif_ptr != nullptr);
+  auto elements = mif_ptr->elements();
+  for (int i = 0; i < 5000; ++i) {
+    mif_ptr->elements().push_back(elements[i % elements.size()]);
+  }
+  ASSERT_TRUE(mif_ptr->Dump(region_demo_path_ + "_seq_dump"));
+  for (size_t num_threads : {1, 3}) {
+    DumpOptions options;
+    options.num_threads = num_threads;
+    options.async_write = true;
+    options.queue_depth = 1;
+    options.buffer_size = 0;  // 小缓冲区, 多次提交
+    options.drop_cache = true;
+    ASSERT_TRUE(mif_ptr->Dump(region_demo_path_ + "_async_dump", options));
+    EXPECT_EQ(ReadFileContent(region_demo_path_ + "_async_dump.mif"),
+              ReadFileContent(region_demo_path_ + "_seq_dump.mif"));
+    EXPECT_EQ(ReadFileContent(region_demo_path_ + "_async_dump.mid"),
+              ReadFileContent(region_demo_path_ + "_seq_dump.mid"));
+  }
+
+  // Flush后已写入的元素全部落盘
+  DumpOptions options;
+  options.async_write = true;
+  MifOStream ofs;
+  EXPECT_FALSE(ofs.Flush());
+  ASSERT_TRUE(ofs.Open(region_demo_path_ + "_async_dump", mif_ptr->header(), options));
+  for (auto& e : elements) {
+    ASSERT_EQ(ofs.Write(*e), 0);
+  }
+  EXPECT_TRUE(ofs.Flush());
+  std::string mid = ReadFileContent(region_demo_path_ + "_async_dump.mid");
+  EXPECT_EQ(std::count(mid.begin(), mid.end(), '\n'), elements.size());
+  EXPECT_EQ(mid, ReadFileContent(region_demo_path_ + "_seq_dump.mid").substr(0, mid.size()));
+  EXPECT_TRUE(ofs.Close());
+}
+
+TEST_F(MifTest, TestCompressedLayer) {
+  std::shared_ptr<Mif> mif_ptr = Mif::Load(region_demo_path_);
+  ASSERT_TRUE(mif_ptr != nullptr);
+  std::string out_path = region_demo_path_ + "_gz_dump";
+  DumpOptions options;
+  options.compression = Compression::kGzip;
+#ifndef GMIF_HAVE_ZLIB
+  EXPECT_FALSE(mif_ptr->Dump(out_path, options));
+#else
+  for (size_t num_threads : {1, 3}) {
+    options.num_threads = num_threads;
+    options.async_write = num_threads != 1;
+    ASSERT_TRUE(mif_ptr->Dump(out_path, options));
+    EXPECT_TRUE(std::ifstream(out_path + ".mif.gz").good());
+    EXPECT_FALSE(std::ifstream(out_path + ".mif").good());
+
+    // 未压缩文件不存在时透明读取压缩文件
+    std::shared_ptr<Mif> reload_ptr = Mif::Load(out_path);
+    ASSERT_TRUE(reload_ptr != nullptr);
+    ExpectMifEqual(reload_ptr, mif_ptr);
+  }
+
+  MifIStream ifs;
+  MifElement elem;
+  ASSERT_TRUE(ifs.Open(out_path));
+  size_t count = 0;
+  while (ifs.Read(elem) == 0) {
+    ++count;
+  }
+  EXPECT_EQ(count, mif_ptr->elements().size());
+  ifs.Close();
+
+  // 截断的压缩文件加载失败
+  std::string mid = ReadFileContent(out_path + ".mid.gz");
+  std::ofstream(out_path + ".mid.gz", std::ios::binary) << mid.substr(0, mid.size() - 8);
+  EXPECT_TRUE(Mif::Load(out_path) == nullptr);
+#endif
+}
+
+TEST_F(MifTest, TestInternStrings) {
+  std::shared_ptr<Mif> row_ptr = Mif::Load(line_demo_path_);
+  for (size_t num_threads : {1, 3}) {
+    LoadOptions options;
+    options.num_threads = num_threads;
+    options.intern_strings = true;
+    std::shared_ptr<Mif> intern_ptr = Mif::Load(line_demo_path_, options);
+    ExpectMifEqual(row_ptr, intern_ptr);
+  }
+}
+
+TEST_F(MifTest, TestColumnProjection) {
+  std::shared_ptr<Mif> full_ptr = Mif::Load(region_demo_path_);
+  ASSERT_TRUE(full_ptr != nullptr);
+  for (size_t num_threads : {1, 3}) {
+    for (bool columnar : {false, true}) {
+      LoadOptions options;
+      options.num_threads = num_threads;
+      options.columnar_attrs = columnar;
+      options.columns = {"KIND", "id", "kind"};
+      std::shared_ptr<Mif> mif_ptr = Mif::Load(region_demo_path_, options);
+      ASSERT_TRUE(mif_ptr != nullptr);
+
+      // 所选列保持文件中的顺序
+      ASSERT_EQ(mif_ptr->header().getColumnSize(), 2);
+      EXPECT_EQ(mif_ptr->header().getColumnName(0), "id");
+      EXPECT_EQ(mif_ptr->header().getColumnName(1), "kind");
+      ASSERT_EQ(mif_ptr->elements().size(), full_ptr->elements().size());
+      for (size_t i = 0; i < mif_ptr->elements().size(); ++i) {
+        const auto& elem = mif_ptr->elements()[i];
+        const auto& exp_elem = full_ptr->elements()[i];
+        EXPECT_FALSE(elem->hasColumn("code"));
+        EXPECT_EQ(elem->getAttr("id"), exp_elem->getAttr("id"));
+        EXPECT_EQ(elem->getAttr("kind"), exp_elem->getAttr("kind"));
+        ASSERT_TRUE(elem->getGeo() != nullptr);
+        EXPECT_EQ(elem->getGeo()->getNumPoints(), exp_elem->getGeo()->getNumPoints());
+      }
+
+      options.columns = {"id", "no-exist"};
+      EXPECT_TRUE(Mif::Load(region_demo_path_, options) == nullptr);
+    }
+  }
+
+  MifIStream ifs;
+  LoadOptions options;
+  options.columns = {"code"};
+  ASSERT_TRUE(ifs.Open(region_demo_path_, options));
+  ASSERT_EQ(ifs.header().getColumnSize(), 1);
+  MifElement elem;
+  size_t count = 0;
+  while (ifs.Read(elem) == 0) {
+    ASSERT_EQ(elem.getAttrsMap().size(), 1);
+    EXPECT_EQ(elem.getAttr("code"), full_ptr->elements()[count]->getAttr("code"));
+    ++count;
+  }
+  EXPECT_EQ(count, full_ptr->elements().size());
+
+  // 投影只切分到所选列, 字段数与表头不一致的行仍加载失败
+  std::string path = data_dir_ + "projection_width_dump";
+  ASSERT_TRUE(full_ptr->Dump(path));
+  std::string mid = ReadFileContent(path + ".mid");
+  for (const char* row : {"1234,\"110100\",523.3412,1,9\n", "1234,\"110100\",523.3412\n"}) {
+    std::ofstream((path + ".mid").c_str(), std::ios_base::binary)
+        << row << mid.substr(mid.find('\n') + 1);
+    options.columns = {"id"};
+    EXPECT_TRUE(Mif::Load(path, options) == nullptr) << row;
+    options.columns.clear();
+    EXPECT_TRUE(Mif::Load(path, options) == nullptr) << row;
+  }
+}
+
+TEST_F(MifTest, TestFilter) {
+  std::shared_ptr<Mif> full_ptr = Mif::Load(region_demo_path_);
+  ASSERT_TRUE(full_ptr != nullptr);
+  auto expect_ids = [&](const std::shared_ptr<Mif>& mif_ptr, const std::vector<int>& ids) {
+    ASSERT_TRUE(mif_ptr != nullptr);
+    ASSERT_EQ(mif_ptr->elements().size(), ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+      const auto& elem = mif_ptr->elements()[i];
+      EXPECT_EQ(elem->getAttr("id").getInt(), ids[i]);
+      const auto& exp_elem = full_ptr->elements()[ids[i] - 1234];
+      ASSERT_TRUE(elem->getGeo() != nullptr);
+      EXPECT_EQ(elem->getGeo()->getGeometryTypeId(), exp_elem->getGeo()->getGeometryTypeId());
+      EXPECT_EQ(elem->getGeo()->getNumPoints(), exp_elem->getGeo()->getNumPoints());
+    }
+  };
+
+  for (size_t num_threads : {1, 3}) {
+    for (bool columnar : {false, true}) {
+      LoadOptions options;
+      options.num_threads = num_threads;
+      options.columnar_attrs = columnar;
+      options.filter = "kind in (1, 3, 5) and length > 100";
+      expect_ids(Mif::Load(region_demo_path_, options), {1234, 1236});
+
+      // 过滤表达式可引用未投影的列
+      options.columns = {"id"};
+      expect_ids(Mif::Load(region_demo_path_, options), {1234, 1236});
+      options.columns.clear();
+
+      options.predicate = [](const AttrMap& attrs) {
+        return attrs.at("code").getStr() != "110100";
+      };
+      expect_ids(Mif::Load(region_demo_path_, options), {1236});
+
+      options.filter.clear();
+      expect_ids(Mif::Load(region_demo_path_, options), {1235, 1236, 1237});
+
+      options.filter = "kind in (1";
+      EXPECT_TRUE(Mif::Load(region_demo_path_, options) == nullptr);
+    }
+  }
+
+  MifIStream ifs;
+  LoadOptions options;
+  options.filter = "id >= 1236";
+  ASSERT_TRUE(ifs.Open(line_demo_path_, options));
+  MifElement elem;
+  std::vector<int> ids;
+  while (ifs.Read(elem) == 0) {
+    ids.push_back(elem.getAttr("id").getInt());
+  }
+  EXPECT_EQ(ids, std::vector<int>({1236, 1237}));
+  options.filter = "no_exist = 1";
+  EXPECT_FALSE(ifs.Open(line_demo_path_, options));
+}
+
+TEST_F(MifTest, TestBboxFilter) {
+  for (const auto& path : {point_demo_path_, line_demo_path_, region_demo_path_}) {
+    std::shared_ptr<Mif> full_ptr = Mif::Load(path);
+    ASSERT_TRUE(full_ptr != nullptr);
+    const auto& full_elems = full_ptr->elements();
+    Envelope window(*full_elems.at(1)->getGeo()->getEnvelopeInternal());
+    std::vector<int> exp_ids;
+    for (const auto& e : full_elems) {
+      if (e->getGeo() != nullptr && e->getGeo()->getEnvelopeInternal()->intersects(window)) {
+        exp_ids.push_back(e->getAttr("id").getInt());
+      }
+    }
+    ASSERT_LT(exp_ids.size(), full_elems.size()) << path;
+
+    for (size_t num_threads : {1, 3}) {
+      for (bool mid_only : {false, true}) {
+        LoadOptions options;
+        options.num_threads = num_threads;
+        options.mid_only = mid_only;
+        options.bbox = window;
+        std::shared_ptr<Mif> mif_ptr = Mif::Load(path, options);
+        ASSERT_TRUE(mif_ptr != nullptr);
+        std::vector<int> ids;
+        for (const auto& e : mif_ptr->elements()) {
+          ids.push_back(e->getAttr("id").getInt());
+          EXPECT_EQ(e->getGeo() == nullptr, mid_only);
+          if (!mid_only) {
+            const auto& exp_elem = full_elems[ids.back() - 1234];
+            EXPECT_EQ(e->getGeo()->getNumPoints(), exp_elem->getGeo()->getNumPoints());
+          }
+        }
+        EXPECT_EQ(ids, exp_ids) << path;
+
+        // 与属性过滤组合
+        options.filter = "id != " + std::to_string(exp_ids.front());
+        mif_ptr = Mif::Load(path, options);
+        ASSERT_TRUE(mif_ptr != nullptr);
+        EXPECT_EQ(mif_ptr->elements().size(), exp_ids.size() - 1);
+      }
+    }
+
+    // 范围外无元素
+    LoadOptions options;
+    options.bbox = Envelope(0, 1, 0, 1);
+    std::shared_ptr<Mif> mif_ptr = Mif::Load(path, options);
+    ASSERT_TRUE(mif_ptr != nullptr);
+    EXPECT_TRUE(mif_ptr->elements().empty());
+
+    MifIStream ifs;
+    options.bbox = window;
+    ASSERT_TRUE(ifs.Open(path, options));
+    MifElement elem;
+    std::vector<int> ids;
+    while (ifs.Read(elem) == 0) {
+      ids.push_back(elem.getAttr("id").getInt());
+    }
+    EXPECT_EQ(ids, exp_ids);
+  }
+}
+
+TEST_F(MifTest, TestOffsetIndex) {
+  // 混合示例数据构造图层, id为行号
+  std::string path = data_dir_ + "offset_index_dump";
+  std::shared_ptr<Mif> demo_ptr = Mif::Load(region_demo_path_);
+  ASSERT_TRUE(demo_ptr != nullptr);
+  MifOStream ofs;
+  ASSERT_TRUE(ofs.Open(path, demo_ptr->header()));
+  int row = 0;
+  for (int i = 0; i < 10; ++i) {
+    for (const auto& demo_path : {point_demo_path_, line_demo_path_, region_demo_path_}) {
+      std::shared_ptr<Mif> part_ptr = Mif::Load(demo_path);
+      ASSERT_TRUE(part_ptr != nullptr);
+      for (auto& e : part_ptr->elements()) {
+        e->addOrUpdateAttr("id", AttrValue(row++));
+        ASSERT_EQ(ofs.Write(*e), 0);
+      }
+    }
+  }
+  ASSERT_TRUE(ofs.Close());
+
+  EXPECT_TRUE(Mif::LoadRange(path, 0, 1) == nullptr);  // 未生成索引
+  ASSERT_TRUE(Mif::BuildOffsetIndex(path));
+  std::shared_ptr<Mif> full_ptr = Mif::Load(path);
+  ASSERT_TRUE(full_ptr != nullptr);
+  const auto& full_elems = full_ptr->elements();
+  ASSERT_EQ(full_elems.size(), static_cast<size_t>(row));
+
+  auto expect_rows = [&](const std::shared_ptr<Mif>& mif_ptr, const std::vector<size_t>& rows) {
+    ASSERT_TRUE(mif_ptr != nullptr);
+    ASSERT_EQ(mif_ptr->elements().size(), rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+      const auto& elem = mif_ptr->elements()[i];
+      const auto& exp_elem = full_elems[rows[i]];
+      EXPECT_EQ(elem->getAttrsMap(), exp_elem->getAttrsMap());
+      ASSERT_TRUE(elem->getGeo() != nullptr);
+      EXPECT_EQ(elem->getGeo()->getGeometryTypeId(), exp_elem->getGeo()->getGeometryTypeId());
+      EXPECT_EQ(elem->getGeo()->getNumPoints(), exp_elem->getGeo()->getNumPoints());
+    }
+  };
+
+  for (bool use_mmap : {true, false}) {
+    LoadOptions options;
+    options.use_mmap = use_mmap;
+    expect_rows(Mif::LoadRange(path, 5, 7, options), {5, 6, 7, 8, 9, 10, 11});
+    expect_rows(Mif::LoadRange(path, row - 2, 10, options), {size_t(row - 2), size_t(row - 1)});
+    expect_rows(Mif::LoadRange(path, row, 1, options), {});
+    EXPECT_TRUE(Mif::LoadRange(path, row + 1, 1, options) == nullptr);
+    expect_rows(Mif::LoadRows(path, {17, 3, 3, 0, size_t(row - 1)}, options),
+                {17, 3, 3, 0, size_t(row - 1)});
+    EXPECT_TRUE(Mif::LoadRows(path, {0, size_t(row)}, options) == nullptr);
+
+    // 过滤条件只作用于所选范围
+    options.filter = "id >= 8";
+    expect_rows(Mif::LoadRange(path, 5, 7, options), {8, 9, 10, 11});
+    expect_rows(Mif::LoadRows(path, {9, 2, 30}, options), {9, 30});
+
+    options.filter.clear();
+    MifIStream ifs;
+    ASSERT_TRUE(ifs.Open(path, options));
+    MifElement elem;
+    ASSERT_TRUE(ifs.Seek(20));
+    ASSERT_EQ(ifs.Read(elem), 0);
+    EXPECT_EQ(elem.getAttr("id").getInt(), 20);
+    ASSERT_EQ(ifs.Read(elem), 0);
+    EXPECT_EQ(elem.getAttr("id").getInt(), 21);
+    ASSERT_TRUE(ifs.Seek(1));
+    ASSERT_EQ(ifs.Read(elem), 0);
+    EXPECT_EQ(elem.getAttr("id").getInt(), 1);
+    ASSERT_TRUE(ifs.Seek(row));
+    EXPECT_EQ(ifs.Read(elem), 1);
+    EXPECT_FALSE(ifs.Seek(row + 1));
+  }
+
+  // 同一秒内改写且大小不变, 按纳秒修改时间判断索引过期
+  std::string mid = ReadFileContent(path + ".mid");
+  std::this_thread::sleep_for(milliseconds(20));
+  std::ofstream((path + ".mid").c_str(), std::ios_base::binary) << mid;
+  EXPECT_TRUE(Mif::LoadRange(path, 0, 1) == nullptr);
+  ASSERT_TRUE(Mif::BuildOffsetIndex(path));
+  expect_rows(Mif::LoadRange(path, 0, 1), {0});
+
+  // 图层修改后索引过期
+  {
+    std::ofstream mid_ofs((path + ".mid").c_str(), std::ios_base::app);
+    mid_ofs << "\n";
+  }
+  EXPECT_TRUE(Mif::LoadRange(path, 0, 1) == nullptr);
+  MifIStream ifs;
+  ASSERT_TRUE(ifs.Open(path));
+  EXPECT_FALSE(ifs.Seek(0));
+}
+
+TEST_F(MifTest, TestBinaryCache) {
+  std::string path = data_dir_ + "binary_cache_dump";
+  std::shared_ptr<Mif> src_ptr = Mif::Load(region_demo_path_);
+  ASSERT_TRUE(src_ptr != nullptr);
+  for (const auto& demo_path : {point_demo_path_, line_demo_path_}) {
+    std::shared_ptr<Mif> part_ptr = Mif::Load(demo_path);
+    ASSERT_TRUE(part_ptr != nullptr);
+    auto& elems = src_ptr->elements();
+    elems.insert(elems.end(), part_ptr->elements().begin(), part_ptr->elements().end());
+  }
+  // 带内环的面与无几何的元素
+  auto geos_factory = GeometryFactory::create();
+  auto make_ring = [&](double x0, double y0, double x1, double y1) {
+    std::vector<Coordinate> pts = {{x0, y0}, {x0, y1}, {x1, y1}, {x1, y0}, {x0, y0}};
+    return geos_factory->createLinearRing(std::unique_ptr<CoordinateArraySequence>(
+        new CoordinateArraySequence(std::move(pts))));
+  };
+  std::vector<std::unique_ptr<LinearRing>> holes;
+  holes.push_back(make_ring(116.2, 39.2, 116.4, 39.4));
+  auto holed = std::make_shared<MifElement>(*src_ptr->elements().front());
+  holed->setGeo(geos_factory->createPolygon(make_ring(116, 39, 117, 40), std::move(holes)));
+  src_ptr->elements().push_back(holed);
+  auto no_geo = std::make_shared<MifElement>(*src_ptr->elements().back());
+  no_geo->setGeo(nullptr);
+  no_geo->addOrUpdateAttr("code", AttrValue(12.5));  // 按列类型转换为字符串
+  src_ptr->elements().push_back(no_geo);
+  ASSERT_TRUE(src_ptr->DumpBinary(path));
+
+  // 按列类型转换后的属性与写出MID时一致
+  no_geo->addOrUpdateAttr("code", AttrValue(AttrValue(12.5).getStr()));
+  for (size_t num_threads : {1, 3}) {
+    for (bool columnar_attrs : {false, true}) {
+      LoadOptions options;
+      options.num_threads = num_threads;
+      options.columnar_attrs = columnar_attrs;
+      std::shared_ptr<Mif> bin_ptr = Mif::LoadBinary(path, options);
+      ASSERT_TRUE(bin_ptr != nullptr);
+      EXPECT_EQ(bin_ptr->header().getCoordsys(), src_ptr->header().getCoordsys());
+      EXPECT_EQ(bin_ptr->header().getDelimiter(), src_ptr->header().getDelimiter());
+      EXPECT_EQ(bin_ptr->header().getColumnType(1), src_ptr->header().getColumnType(1));
+      EXPECT_EQ(bin_ptr->elements().front()->getAttrTable() != nullptr, columnar_attrs);
+      auto holed_geo = std::dynamic_pointer_cast<Polygon>(bin_ptr->elements()[12]->getGeo());
+      ASSERT_TRUE(holed_geo != nullptr);
+      EXPECT_EQ(holed_geo->getNumInteriorRing(), 1);
+      ExpectMifEqual(src_ptr, bin_ptr);
+    }
+  }
+  LoadOptions options;
+  options.mid_only = true;
+  std::shared_ptr<Mif> mid_ptr = Mif::LoadBinary(path, options);
+  ASSERT_TRUE(mid_ptr != nullptr);
+  ASSERT_EQ(mid_ptr->elements().size(), src_ptr->elements().size());
+  EXPECT_TRUE(mid_ptr->elements().front()->getGeo() == nullptr);
+
+  // 列式属性表的元素直接写出, 不被物化
+  options = LoadOptions();
+  options.columnar_attrs = true;
+  std::shared_ptr<Mif> col_ptr = Mif::Load(line_demo_path_, options);
+  ASSERT_TRUE(col_ptr != nullptr);
+  ASSERT_TRUE(col_ptr->DumpBinary(path));
+  EXPECT_TRUE(col_ptr->elements().front()->getAttrTable() != nullptr);
+  ExpectMifEqual(std::shared_ptr<Mif>(Mif::Load(line_demo_path_)), Mif::LoadBinary(path));
+
+  // 记录源图层的时间戳, 图层文件变化或删除后缓存过期
+  std::string layer_path = data_dir_ + "binary_source_dump";
+  ASSERT_TRUE(col_ptr->Dump(layer_path));
+  ASSERT_TRUE(col_ptr->DumpBinary(layer_path));
+  EXPECT_TRUE(Mif::LoadBinary(layer_path) != nullptr);
+  std::string mid = ReadFileContent(layer_path + ".mid");
+  std::this_thread::sleep_for(milliseconds(20));
+  std::ofstream((layer_path + ".mid").c_str(), std::ios_base::binary) << mid;
+  EXPECT_TRUE(Mif::LoadBinary(layer_path) == nullptr);
+  ASSERT_TRUE(col_ptr->DumpBinary(layer_path));
+  EXPECT_TRUE(Mif::LoadBinary(layer_path) != nullptr);
+  std::remove((layer_path + ".mif").c_str());
+  EXPECT_TRUE(Mif::LoadBinary(layer_path) == nullptr);
+
+  // 缓存损坏或不存在
+  {
+    std::fstream fs((path + ".gmifb").c_str(), std::ios_base::in | std::ios_base::out |
+                                                   std::ios_base::binary);
+    fs.seekp(-3, std::ios_base::end);
+    fs.put('\xff');
+  }
+  EXPECT_TRUE(Mif::LoadBinary(path) == nullptr);
+  EXPECT_TRUE(Mif::LoadBinary(data_dir_ + "no_exist") == nullptr);
+}
+
+TEST_F(MifTest, TestLazyGeo) {
+  for (const auto& path : {point_demo_path_, line_demo_path_, region_demo_path_}) {
+    std::shared_ptr<Mif> eager_ptr = Mif::Load(path);
+    ASSERT_TRUE(eager_ptr != nullptr);
+    for (size_t num_threads : {1, 3}) {
+      LoadOptions options;
+      options.num_threads = num_threads;
+      options.lazy_geo = true;
+      std::shared_ptr<Mif> lazy_ptr = Mif::Load(path, options);
+      ASSERT_TRUE(lazy_ptr != nullptr);
+      for (const auto& e : lazy_ptr->elements()) {
+        EXPECT_TRUE(e->isGeoPending());
+      }
+      // 坐标区与元素一一对应
+      const GeoArena* arena = lazy_ptr->arena();
+      ASSERT_TRUE(arena != nullptr);
+      ASSERT_EQ(arena->size(), eager_ptr->elements().size());
+      for (size_t i = 0; i < arena->size(); ++i) {
+        EXPECT_EQ(arena->getType(i), eager_ptr->elements()[i]->getGeo()->getGeometryTypeId());
+      }
+      // 空间索引与保存直接读取坐标区, 不构造几何对象
+      lazy_ptr->BuildIndex();
+      std::string dump_path = data_dir_ + "lazy_geo_dump";
+      ASSERT_TRUE(lazy_ptr->Dump(dump_path));
+      for (const auto& e : lazy_ptr->elements()) {
+        EXPECT_TRUE(e->isGeoPending());
+      }
+      ASSERT_TRUE(eager_ptr->Dump(dump_path + "_eager"));
+      EXPECT_EQ(ReadFileContent(dump_path + ".mif"), ReadFileContent(dump_path + "_eager.mif"));
+      eager_ptr->BuildIndex();
+      std::vector<size_t> exp_hits;
+      std::vector<size_t> hits;
+      const Envelope* query_env = eager_ptr->elements().at(1)->getGeo()->getEnvelopeInternal();
+      eager_ptr->index()->Query(*query_env, exp_hits);
+      lazy_ptr->index()->Query(*query_env, hits);
+      EXPECT_EQ(hits, exp_hits);
+
+      // 复制未构造的元素
+      MifElement copy(*lazy_ptr->elements().front());
+      EXPECT_TRUE(copy.isGeoPending());
+
+      // 多线程并发首次访问
+      std::vector<std::thread> threads;
+      for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&lazy_ptr]() {
+          for (const auto& e : lazy_ptr->elements()) {
+            EXPECT_TRUE(e->getGeo() != nullptr);
+          }
+        });
+      }
+      for (auto& t : threads) {
+        t.join();
+      }
+      ExpectMifEqual(eager_ptr, lazy_ptr);
+      EXPECT_FALSE(lazy_ptr->elements().front()->isGeoPending());
+      ASSERT_TRUE(copy.getGeo() != nullptr);
+      EXPECT_EQ(copy.getGeo()->getNumPoints(),
+                eager_ptr->elements().front()->getGeo()->getNumPoints());
+
+      // 与范围过滤组合
+      options.bbox = *eager_ptr->elements().at(1)->getGeo()->getEnvelopeInternal();
+      lazy_ptr = Mif::Load(path, options);
+      ASSERT_TRUE(lazy_ptr != nullptr);
+      ASSERT_FALSE(lazy_ptr->elements().empty());
+      for (const auto& e : lazy_ptr->elements()) {
+        ASSERT_TRUE(e->getGeo() != nullptr);
+        EXPECT_TRUE(e->getGeo()->getEnvelopeInternal()->intersects(options.bbox));
+      }
+    }
+
+    // 二进制缓存的坐标整体复制为坐标区
+    std::string cache_path = data_dir_ + "lazy_geo_dump";
+    ASSERT_TRUE(eager_ptr->DumpBinary(cache_path));
+    LoadOptions options;
+    options.lazy_geo = true;
+    std::shared_ptr<Mif> bin_ptr = Mif::LoadBinary(cache_path, options);
+    ASSERT_TRUE(bin_ptr != nullptr);
+    ASSERT_TRUE(bin_ptr->arena() != nullptr);
+    EXPECT_EQ(bin_ptr->arena()->size(), eager_ptr->elements().size());
+    EXPECT_TRUE(bin_ptr->elements().front()->isGeoPending());
+    ExpectMifEqual(eager_ptr, bin_ptr);
+
+    MifIStream ifs;
+    ASSERT_TRUE(ifs.Open(path, options));
+    MifElement elem;
+    size_t count = 0;
+    while (ifs.Read(elem) == 0) {
+      EXPECT_TRUE(elem.isGeoPending());
+      const auto& exp_geo = eager_ptr->elements()[count++]->getGeo();
+      ASSERT_TRUE(elem.getGeo() != nullptr);
+      EXPECT_EQ(elem.getGeo()->getGeometryTypeId(), exp_geo->getGeometryTypeId());
+      EXPECT_EQ(elem.getGeo()->getNumPoints(), exp_geo->getNumPoints());
+    }
+    EXPECT_EQ(count, eager_ptr->elements().size());
+  }
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include "io.h"
+
+using namespace gmif;
+
+class SchemaTest : public ::testing::Test {};
+
+TEST_F(SchemaTest, TestParseColumnType) {
+  io::ColumnSpec spec;
+  io::ParseColumnType("integer", spec);
+  EXPECT_EQ(spec.type, io::ColType::kInt);
+  EXPECT_EQ(spec.width, 0);
+  EXPECT_EQ(spec.precision, -1);
+
+  io::ParseColumnType("char(6)", spec);
+  EXPECT_EQ(spec.type, io::ColType::kStr);
+  EXPECT_EQ(spec.width, 6);
+  EXPECT_EQ(spec.precision, -1);
+
+  io::ParseColumnType("decimal(10, 2)", spec);
+  EXPECT_EQ(spec.type, io::ColType::kDouble);
+  EXPECT_EQ(spec.width, 10);
+  EXPECT_EQ(spec.precision, 2);
+
+  io::ParseColumnType("float", spec);
+  EXPECT_EQ(spec.type, io::ColType::kDouble);
+  io::ParseColumnType("smallint", spec);
+  EXPECT_EQ(spec.type, io::ColType::kInt);
+  io::ParseColumnType("date", spec);
+  EXPECT_EQ(spec.type, io::ColType::kStr);
+}
+
+TEST_F(SchemaTest, TestCompile) {
+  MifHeader header;
+  header.setDelimiter('\t');
+  header.addColumn("id", "integer");
+  header.addColumn("name", "char(32)");
+  header.addColumn("area", "decimal(12,3)");
+
+  io::ColumnSchema schema(header);
+  ASSERT_EQ(schema.size(), 3);
+  EXPECT_EQ(schema.getDelimiter(), '\t');
+  EXPECT_EQ(schema[2].name, "area");
+  EXPECT_EQ(schema[2].precision, 3);
+  EXPECT_EQ(schema.getReadOrder(), std::vector<size_t>({2, 0, 1}));
+  EXPECT_EQ(schema.getNameOrder(), std::vector<size_t>({2, 0, 1}));
+}
+
+TEST_F(SchemaTest, TestReadReuseElement) {
+  MifHeader header;
+  header.setDelimiter(',');
+  header.addColumn("id", "integer");
+  header.addColumn("name", "char(32)");
+  LoadOptions options;
+  options.mid_only = true;
+  io::ReadContext ctx(header, options);
+
+  std::string mid("1,\"a\"\n2,\"b\"\n");
+  io::TextReader mif_reader;
+  io::TextReader mid_reader;
+  mid_reader.Reset(mid.data(), mid.data() + mid.size());
+  auto geos_factory = geos::geom::GeometryFactory::create();
+
+  MifElement elem;
+  elem.addOrUpdateAttr("stale", AttrValue("x"));  // 与表头不一致的字段被丢弃
+  ASSERT_EQ(io::ReadSingleElement(geos_factory, mif_reader, mid_reader, ctx, elem), 0);
+  ASSERT_EQ(elem.getAttrsMap().size(), 2);
+  EXPECT_FALSE(elem.hasColumn("stale"));
+  EXPECT_EQ(elem.getAttr("id").getInt(), 1);
+
+  const AttrValue* name_val = &elem.getAttr("name");
+  ASSERT_EQ(io::ReadSingleElement(geos_factory, mif_reader, mid_reader, ctx, elem), 0);
+  EXPECT_EQ(&elem.getAttr("name"), name_val);  // 原地更新
+  EXPECT_EQ(elem.getAttr("name").getStr(), "b");
+  EXPECT_EQ(elem.getAttr("id").getInt(), 2);
+  EXPECT_EQ(io::ReadSingleElement(geos_factory, mif_reader, mid_reader, ctx, elem), 1);
+}
+
+TEST_F(SchemaTest, TestInternStrings) {
+  MifHeader header;
+  header.setDelimiter(',');
+  header.addColumn("name", "char(64)");
+  header.addColumn("code", "char(6)");
+  LoadOptions options;
+  options.mid_only = true;
+  options.intern_strings = true;
+  io::ReadContext ctx(header, options);
+
+  std::string name(40, 'n');
+  std::string mid = "\"" + name + "\",\"110000\"\n\"" + name + "\",\"110000\"\n";
+  io::TextReader mif_reader;
+  io::TextReader mid_reader;
+  mid_reader.Reset(mid.data(), mid.data() + mid.size());
+  auto geos_factory = geos::geom::GeometryFactory::create();
+
+  MifElement e1;
+  MifElement e2;
+  ASSERT_EQ(io::ReadSingleElement(geos_factory, mif_reader, mid_reader, ctx, e1), 0);
+  ASSERT_EQ(io::ReadSingleElement(geos_factory, mif_reader, mid_reader, ctx, e2), 0);
+  const AttrValue& v1 = e1.getAttr("name");
+  const AttrValue& v2 = e2.getAttr("name");
+  ASSERT_TRUE(v1.isSharedStr());
+  EXPECT_EQ(v1.getStrData(), v2.getStrData());  // 共享同一存储
+  EXPECT_EQ(v1.getStr(), name);
+  EXPECT_EQ(v1, v2);
+  EXPECT_FALSE(e1.getAttr("code").isSharedStr());  // 短字符串内联存储
+  EXPECT_EQ(ctx.pools[0].size(), 1);
+}
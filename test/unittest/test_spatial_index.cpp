@@ -0,0 +1,143 @@
+#include <geos/geom/CoordinateArraySequence.h>
+#include <geos/geom/GeometryFactory.h>
+#include <geos/geom/LineString.h>
+#include <geos/geom/Point.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include "gmif/gmif.h"
+
+using namespace gmif;
+using namespace geos::geom;
+
+class SpatialIndexTest : public ::testing::Test {
+ protected:
+  GeometryFactory::Ptr factory_ = GeometryFactory::create();
+  std::vector<std::shared_ptr<MifElement>> elements_;
+  std::vector<Coordinate> starts_;  // 各元素线段的起点
+  std::vector<Coordinate> ends_;    // 各元素线段的终点, 点元素与起点相同
+
+  //! 随机生成点与两点线段, 每隔若干元素插入一个空几何元素
+  void SetUp() override {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> pos(0, 1000);
+    std::uniform_real_distribution<double> step(-5, 5);
+    for (int i = 0; i < 3000; ++i) {
+      auto elem = std::make_shared<MifElement>();
+      Coordinate a(pos(rng), pos(rng));
+      Coordinate b(a);
+      if (i % 7 == 0) {
+        elem->setGeo(nullptr);
+      } else if (i % 2 == 0) {
+        elem->setGeo(GeometryPtr(factory_->createPoint(a)));
+      } else {
+        b = Coordinate(a.x + step(rng), a.y + step(rng));
+        auto coords = std::unique_ptr<CoordinateArraySequence>(new CoordinateArraySequence(2));
+        coords->setAt(a, 0);
+        coords->setAt(b, 1);
+        elem->setGeo(GeometryPtr(factory_->createLineString(std::move(coords))));
+      }
+      elements_.push_back(elem);
+      starts_.push_back(a);
+      ends_.push_back(b);
+    }
+  }
+
+  double Distance(size_t i, const Coordinate& pt) const {
+    const Coordinate& a = starts_[i];
+    const Coordinate& b = ends_[i];
+    double dx = b.x - a.x, dy = b.y - a.y;
+    double len2 = dx * dx + dy * dy;
+    double t = len2 > 0 ? ((pt.x - a.x) * dx + (pt.y - a.y) * dy) / len2 : 0;
+    t = std::max(0.0, std::min(1.0, t));
+    return std::hypot(a.x + t * dx - pt.x, a.y + t * dy - pt.y);
+  }
+};
+
+TEST_F(SpatialIndexTest, TestQuery) {
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<double> pos(-10, 1010);
+  for (size_t num_threads : {1, 4}) {
+    for (size_t node_capacity : {2, 16}) {
+      SpatialIndex index;
+      index.Build(elements_, num_threads, node_capacity);
+      EXPECT_EQ(index.size(), elements_.size() - (elements_.size() + 6) / 7);
+
+      std::vector<size_t> res;
+      for (int n = 0; n < 200; ++n) {
+        Coordinate pt(pos(rng), pos(rng));
+        Envelope env(pt.x, pt.x + 30, pt.y, pt.y + 20);
+        std::vector<size_t> exp;
+        for (size_t i = 0; i < elements_.size(); ++i) {
+          if (elements_[i]->getGeo() != nullptr &&
+              elements_[i]->getGeo()->getEnvelopeInternal()->intersects(env)) {
+            exp.push_back(i);
+          }
+        }
+        index.Query(env, res);
+        ASSERT_EQ(res, exp);
+
+        // 取线段元素的中点作为点查询
+        size_t line = (n * 2 + 1) % elements_.size();
+        if (elements_[line]->getGeo() != nullptr) {
+          Coordinate mid((starts_[line].x + ends_[line].x) / 2,
+                         (starts_[line].y + ends_[line].y) / 2);
+          index.QueryPoint(mid, res);
+          EXPECT_TRUE(std::binary_search(res.begin(), res.end(), line));
+        }
+      }
+      index.Query(Envelope(), res);
+      EXPECT_TRUE(res.empty());
+    }
+  }
+}
+
+TEST_F(SpatialIndexTest, TestNearest) {
+  SpatialIndex index;
+  index.Build(elements_, 0, 4);
+  std::mt19937 rng(9);
+  std::uniform_real_distribution<double> pos(0, 1000);
+  std::vector<size_t> res;
+  for (int n = 0; n < 200; ++n) {
+    Coordinate pt(pos(rng), pos(rng));
+    std::vector<std::pair<double, size_t>> exp;
+    for (size_t i = 0; i < elements_.size(); ++i) {
+      if (elements_[i]->getGeo() != nullptr) {
+        exp.emplace_back(Distance(i, pt), i);
+      }
+    }
+    std::sort(exp.begin(), exp.end());
+    index.Nearest(pt, 5, res);
+    ASSERT_EQ(res.size(), 5);
+    for (size_t k = 0; k < res.size(); ++k) {
+      EXPECT_NEAR(Distance(res[k], pt), exp[k].first, 1e-9);
+    }
+  }
+  index.Nearest(Coordinate(0, 0), 0, res);
+  EXPECT_TRUE(res.empty());
+  index.Nearest(Coordinate(0, 0), elements_.size(), res);
+  EXPECT_EQ(res.size(), index.size());
+}
+
+TEST_F(SpatialIndexTest, TestMifIndex) {
+  std::shared_ptr<Mif> mif_ptr = Mif::Load("test/data/region_demo");
+  ASSERT_TRUE(mif_ptr != nullptr);
+  EXPECT_TRUE(mif_ptr->index() == nullptr);
+  mif_ptr->BuildIndex();
+  ASSERT_TRUE(mif_ptr->index() != nullptr);
+  EXPECT_EQ(mif_ptr->index()->size(), mif_ptr->elements().size());
+
+  // 面的顶点在其边界上, 距离为0
+  std::vector<size_t> res;
+  for (size_t i = 0; i < mif_ptr->elements().size(); ++i) {
+    const auto& geo = mif_ptr->elements()[i]->getGeo();
+    mif_ptr->index()->Query(*geo->getEnvelopeInternal(), res);
+    EXPECT_TRUE(std::binary_search(res.begin(), res.end(), i));
+    Coordinate vertex = geo->getCoordinates()->getAt(0);
+    mif_ptr->index()->QueryPoint(vertex, res);
+    EXPECT_TRUE(std::binary_search(res.begin(), res.end(), i));
+    mif_ptr->index()->Nearest(vertex, mif_ptr->elements().size(), res);
+    ASSERT_EQ(res.size(), mif_ptr->elements().size());
+    EXPECT_TRUE(res[0] == i || res[0] < i);  // 距离同为0时按下标升序
+  }
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <fstream>
+#include "text_reader.h"
+
+using namespace gmif;
+
+class TextReaderTest : public ::testing::Test {
+ protected:
+  std::string path_;
+
+  void SetUp() override { path_ = "test/data/line_demo.mif"; }
+};
+
+std::vector<std::string> ReadAllLines(io::TextReader& reader) {
+  std::vector<std::string> lines;
+  utils::StrView line;
+  while (reader.ReadLine(line)) {
+    lines.push_back(line.str());
+  }
+  return lines;
+}
+
+TEST_F(TextReaderTest, TestMappedEqualBuffered) {
+  io::TextReader mapped;
+  io::TextReader buffered;
+  ASSERT_TRUE(mapped.OpenMapped(path_));
+  ASSERT_TRUE(buffered.OpenBuffered(path_, 7));  // 小缓冲区覆盖跨块与扩容
+
+  auto mapped_lines = ReadAllLines(mapped);
+  EXPECT_EQ(mapped_lines.size(), 98);
+  EXPECT_EQ(mapped_lines, ReadAllLines(buffered));
+  EXPECT_TRUE(mapped.eof());
+  EXPECT_TRUE(buffered.eof());
+}
+
+TEST_F(TextReaderTest, TestMemory) {
+  std::string data("a b\r\n\n  c\td");
+  io::TextReader reader;
+  reader.Reset(data.data(), data.data() + data.size());
+
+  utils::StrView v;
+  ASSERT_TRUE(reader.ReadToken(v));
+  EXPECT_EQ(v.str(), "a");
+  ASSERT_TRUE(reader.ReadLine(v));
+  EXPECT_EQ(v.str(), " b");
+  ASSERT_TRUE(reader.ReadLine(v));
+  EXPECT_TRUE(v.empty());
+  ASSERT_TRUE(reader.ReadToken(v));
+  EXPECT_EQ(v.str(), "c");
+  ASSERT_TRUE(reader.ReadToken(v));
+  EXPECT_EQ(v.str(), "d");
+  EXPECT_FALSE(reader.ReadToken(v));
+  EXPECT_FALSE(reader.ReadLine(v));
+  EXPECT_TRUE(reader.eof());
+}
+
+TEST_F(TextReaderTest, TestSeek) {
+  io::TextReader mapped;
+  io::TextReader buffered;
+  ASSERT_TRUE(mapped.OpenMapped(path_));
+  ASSERT_TRUE(buffered.OpenBuffered(path_, 7));
+  for (io::TextReader* reader : {&mapped, &buffered}) {
+    utils::StrView line;
+    std::vector<uint64_t> offsets;
+    std::vector<std::string> lines;
+    while (true) {
+      offsets.push_back(reader->offset());
+      if (!reader->ReadLine(line)) {
+        break;
+      }
+      lines.push_back(line.str());
+    }
+    ASSERT_EQ(lines.size(), 98);
+
+    // 限定在[offsets[10], offsets[12])内, 只能读到两行
+    ASSERT_TRUE(reader->Seek(offsets[10], offsets[12]));
+    EXPECT_EQ(reader->offset(), offsets[10]);
+    ASSERT_TRUE(reader->ReadLine(line));
+    EXPECT_EQ(line.str(), lines[10]);
+    ASSERT_TRUE(reader->ReadLine(line));
+    EXPECT_EQ(line.str(), lines[11]);
+    EXPECT_FALSE(reader->ReadLine(line));
+    EXPECT_TRUE(reader->eof());
+
+    ASSERT_TRUE(reader->Seek(offsets[3]));
+    ASSERT_TRUE(reader->ReadLine(line));
+    EXPECT_EQ(line.str(), lines[3]);
+  }
+}
+
+TEST_F(TextReaderTest, TestOpenFailed) {
+  io::TextReader reader;
+  EXPECT_FALSE(reader.OpenMapped("test/data/no_exist.mif"));
+  EXPECT_FALSE(reader.OpenBuffered("test/data/no_exist.mif"));
+}
+
+#ifdef GMIF_HAVE_ZLIB
+//! 将字符串压缩为一个gzip成员
+std::string GzipString(const std::string& data) {
+  std::string res;
+  io::Compressor compressor;
+  EXPECT_TRUE(compressor.Init(Compression::kGzip, 0, [&](const char* p, size_t n) {
+    res.append(p, n);
+    return true;
+  }));
+  EXPECT_TRUE(compressor.Write(data.data(), data.size()));
+  EXPECT_TRUE(compressor.Finish());
+  return res;
+}
+
+void WriteFileContent(const std::string& path, const std::string& content) {
+  std::ofstream ofs(path, std::ios::binary);
+  ofs << content;
+}
+
+TEST_F(TextReaderTest, TestCompressed) {
+  io::TextReader buffered;
+  ASSERT_TRUE(buffered.OpenBuffered(path_));
+  auto lines = ReadAllLines(buffered);
+  std::ifstream ifs(path_, std::ios::binary);
+  std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+  // 多成员gzip按成员顺序拼接
+  std::string gz_path = "test/data/line_demo_gz_dump.mif.gz";
+  size_t half = content.size() / 2;
+  WriteFileContent(gz_path, GzipString(content.substr(0, half)) + GzipString(content.substr(half)));
+  io::TextReader reader;
+  ASSERT_TRUE(reader.OpenCompressed(gz_path, Compression::kGzip, 7));
+  EXPECT_EQ(ReadAllLines(reader), lines);
+  EXPECT_TRUE(reader.eof());
+  EXPECT_FALSE(reader.fail());
+  EXPECT_FALSE(reader.Seek(0));
+
+  // 截断的压缩文件读取失败, 不视为正常结束
+  std::string gz = GzipString(content);
+  WriteFileContent(gz_path, gz.substr(0, gz.size() / 2));
+  ASSERT_TRUE(reader.OpenCompressed(gz_path, Compression::kGzip, 7));
+  EXPECT_LT(ReadAllLines(reader).size(), lines.size());
+  EXPECT_TRUE(reader.fail());
+
+  EXPECT_FALSE(reader.OpenCompressed("test/data/no_exist.mif.gz", Compression::kGzip));
+}
+#endif
@@ -1,5 +1,13 @@
 #include <gtest/gtest.h>
+#include <clocale>
+#include <cmath>
+#include <cstring>
 #include <functional>
+#include <limits>
+#include <locale>
+#include <random>
+#include <sstream>
+#include "simd_scan.h"
 #include "utils.h"
 
 using namespace gmif::utils;
@@ -69,4 +77,224 @@ TEST_F(UtilsTest, TestStrKeepQuot) {
   TestSplitQuot(R"("a\",bc",bcd)", ',', {R"("a\",bc")", "bcd"});
   TestSplitQuot(R"("","abc")", ',', {R"("")", R"("abc")"});
   TestSplitQuot(R"("","")", ',', {R"("")", R"("")"});
-}
\ No newline at end of file
+}
+void TestSplitQuotView(const std::string& str, char sep, const std::vector<std::string>& exp_v) {
+  std::vector<StrView> v;
+  StrSplitKeepQuot(StrView(str), sep, v);
+  std::vector<std::string> res;
+  for (const auto& item : v) {
+    res.push_back(item.str());
+  }
+  EXPECT_EQ(res, exp_v);
+}
+
+TEST_F(UtilsTest, TestStrViewSplit) {
+  TestSplitQuotView(",abc,bcd,", ',', {"", "abc", "bcd", ""});
+  TestSplitQuotView("\"a,bc\",bcd", ',', {"\"a,bc\"", "bcd"});
+  TestSplitQuotView(R"("a\",bc",bcd)", ',', {R"("a\",bc")", "bcd"});
+
+  std::vector<StrView> v;
+  StrSplitSpace(StrView("  Pline \t MULTIPLE 2 "), v);
+  ASSERT_EQ(v.size(), 3);
+  EXPECT_TRUE(StrEqualNoCase(v[0], "pline"));
+  EXPECT_TRUE(StrEqualNoCase(v[1], "multiple"));
+  EXPECT_EQ(to_int(v[2]), 2);
+
+  StrView sv("\"123.5\"");
+  StrTrim(sv, "\"");
+  EXPECT_EQ(sv, StrView("123.5"));
+  EXPECT_EQ(to_double(sv), 123.5);
+  EXPECT_EQ(to_int(StrView("-42abc")), -42);
+}
+
+void TestParseDouble(const std::string& str) {
+  char* exp_end = nullptr;
+  double exp_val = strtod(str.c_str(), &exp_end);
+  double val = -1;
+  const char* end = ParseDouble(str.data(), str.data() + str.size(), val);
+  EXPECT_EQ(end - str.data(), exp_end - str.c_str()) << str;
+  EXPECT_EQ(memcmp(&val, &exp_val, sizeof(double)), 0) << str << ": " << val << " != " << exp_val;
+}
+
+TEST_F(UtilsTest, TestParseDouble) {
+  for (const char* s : {"0", "-0", "+1", "118.7574625", "37.7319445", "-123.456e-7", "1e22", "1e23",
+                        "9007199254740993", "0.1", "00000.00000000001234", ".5", "5.", "1e", "1e+",
+                        "12abc", "1.7976931348623157e308", "1e400", "4.9e-324", "-.", ".",
+                        "123456789012345678901234567890", "0.30000000000000004", "inf", "-nan"}) {
+    TestParseDouble(s);
+  }
+
+  std::mt19937_64 rng(42);
+  std::uniform_real_distribution<double> dist(-180.0, 180.0);
+  char buf[64];
+  for (int i = 0; i < 200000; ++i) {
+    double d = dist(rng);
+    const char* fmt = (i % 4 == 0) ? "%.6f" : (i % 4 == 1) ? "%.9f" : (i % 4 == 2) ? "%.17g" : "%e";
+    snprintf(buf, sizeof(buf), fmt, d);
+    TestParseDouble(buf);
+    snprintf(buf, sizeof(buf), "%llu.%llu",
+             static_cast<unsigned long long>(rng() % 100000000000ULL),
+             static_cast<unsigned long long>(rng()));
+    TestParseDouble(buf);
+  }
+
+  // 回退到strtod的输入同样不受逗号小数点区域的影响
+  for (const char* name : {"de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8", "fr_FR.utf8"}) {
+    if (setlocale(LC_NUMERIC, name) == nullptr) {
+      continue;
+    }
+    for (const char* s : {"118.75746250000001", "1.5e300", "-2.5e-30", "123.5"}) {
+      double val = 0;
+      const char* end = ParseDouble(s, s + strlen(s), val);
+      EXPECT_EQ(end, s + strlen(s)) << name << ": " << s;
+      std::istringstream iss(s);
+      iss.imbue(std::locale::classic());
+      double exp_val = 0;
+      iss >> exp_val;
+      EXPECT_EQ(val, exp_val) << name << ": " << s;
+    }
+    break;
+  }
+  setlocale(LC_NUMERIC, "C");
+}
+
+TEST_F(UtilsTest, TestStrSplitUnquote) {
+  std::vector<StrView> v;
+  StrSplitUnquote(StrView(R"(1237,"120100","a,b",,"",10.12)"), ',', v);
+  std::vector<std::string> res;
+  for (const auto& item : v) {
+    res.push_back(item.str());
+  }
+  EXPECT_EQ(res, std::vector<std::string>({"1237", "120100", "a,b", "", "", "10.12"}));
+
+  // 复用容量时不再分配
+  const StrView* data = v.data();
+  StrSplitUnquote(StrView("1,2,3"), ',', v);
+  EXPECT_EQ(v.data(), data);
+  EXPECT_EQ(v.size(), 3);
+
+  // 达到字段数上限后不再扫描剩余内容
+  std::string line = "1237,\"a,b\"," + std::string(80, 'x') + ",10.12";
+  StrSplitUnquote(StrView(line), ',', v, 2);
+  ASSERT_EQ(v.size(), 2);
+  EXPECT_EQ(v[1].str(), "a,b");
+  StrSplitUnquote(StrView(line), ',', v, 3);
+  ASSERT_EQ(v.size(), 3);
+  EXPECT_EQ(v[2].str(), std::string(80, 'x'));
+  StrSplitUnquote(StrView(line), ',', v, 10);
+  EXPECT_EQ(v.size(), 4);
+  EXPECT_EQ(StrCountFields(StrView(line), ','), 4);
+}
+
+//! 逐字节切分, 作为向量化切分的对照
+static std::vector<std::string> SplitReference(const std::string& str, char sep, bool unquote) {
+  std::vector<std::string> res;
+  size_t start = 0, i = 0;
+  while (i < str.size()) {
+    if (str[i] == sep) {
+      res.push_back(str.substr(start, i - start));
+      start = ++i;
+    } else if (str[i] == '"') {
+      for (++i; i < str.size(); ++i) {
+        if (str[i] == '"') {
+          ++i;
+          break;
+        }
+        if (str[i] == '\\') ++i;
+      }
+    } else {
+      for (; i < str.size() && str[i] != sep; ++i) {
+        if (str[i] == '\\') ++i;
+      }
+    }
+  }
+  res.push_back(str.substr(start, std::min(i, str.size()) - start));
+  if (unquote) {
+    for (auto& item : res) {
+      size_t b = item.find_first_not_of('"');
+      item = (b == std::string::npos) ? "" : item.substr(b, item.find_last_not_of('"') - b + 1);
+    }
+  }
+  return res;
+}
+
+TEST_F(UtilsTest, TestSplitFieldsSimd) {
+  std::vector<ScanIsa> isas = {ScanIsa::kScalar, ScanIsa::kSse2, ScanIsa::kAvx2};
+  std::vector<StrView> v;
+  std::vector<std::string> res;
+  auto to_strings = [&]() {
+    res.clear();
+    for (const auto& item : v) {
+      res.push_back(item.str());
+    }
+    return res;
+  };
+
+  // 跨越64字节块边界的引号与分隔符
+  std::string line = "1237,\"" + std::string(70, 'a') + ",b\",," + std::string(60, 'c') + ",\"\"";
+  for (ScanIsa isa : isas) {
+    ASSERT_TRUE(SplitFieldsSimd(isa, StrView(line), ',', true, v));
+    EXPECT_EQ(to_strings(), SplitReference(line, ',', true));
+  }
+
+  // 转义符与字段中间的引号交由逐字节解析
+  EXPECT_FALSE(SplitFieldsSimd(DetectScanIsa(), StrView("1,\"a\\\"b\",2"), ',', false, v));
+  EXPECT_FALSE(SplitFieldsSimd(DetectScanIsa(), StrView("1,a\"b,2"), ',', false, v));
+  EXPECT_TRUE(SplitFieldsSimd(DetectScanIsa(), StrView("1,\"a\"\"b\"c,2"), ',', false, v));
+
+  // 随机行与逐字节结果一致
+  std::mt19937 rng(7);
+  const char alphabet[] = {',', '"', 'x', 'y', '1', '\\', ' ', '\t'};
+  for (int n = 0; n < 20000; ++n) {
+    std::string str(rng() % 200, ' ');
+    bool plain = (n % 2 == 0);
+    for (auto& c : str) {
+      c = alphabet[rng() % (plain ? 5 : sizeof(alphabet))];
+    }
+    bool unquote = (n % 3 == 0);
+    std::vector<std::string> exp = SplitReference(str, ',', unquote);
+    size_t count = 0;
+    for (ScanIsa isa : isas) {
+      if (SplitFieldsSimd(isa, StrView(str), ',', unquote, v)) {
+        ASSERT_EQ(to_strings(), exp) << str;
+      }
+      if (CountFieldsSimd(isa, StrView(str), ',', count)) {
+        ASSERT_EQ(count, exp.size()) << str;
+      }
+    }
+    ASSERT_EQ(StrCountFields(StrView(str), ','), exp.size()) << str;
+    StrSplitKeepQuot(StrView(str), ',', v);
+    ASSERT_EQ(to_strings(), SplitReference(str, ',', false)) << str;
+  }
+}
+
+TEST_F(UtilsTest, TestFormatFixed) {
+  char buf[kFixedBufferSize];
+  char exp[kFixedBufferSize];
+  auto check = [&](double v, int precision) {
+    snprintf(exp, sizeof(exp), "%.*f", precision, v);
+    size_t len = FormatFixed(v, precision, buf);
+    ASSERT_EQ(std::string(buf, len), std::string(exp)) << v << " " << precision;
+  };
+  for (double v : {0.0, -0.0, 0.5, 1.5, 2.5, 0.125, -0.125, 1e-9, -1e-9, 123.123456789, 1e15, 1e300,
+                   -1e300, 0.1, 0.7, 116.38812345678, std::numeric_limits<double>::infinity(),
+                   std::numeric_limits<double>::quiet_NaN()}) {
+    for (int precision : {0, 2, 6, 8, 15, 17}) {
+      check(v, precision);
+    }
+  }
+  std::mt19937_64 rng(11);
+  std::uniform_real_distribution<double> dist(-200.0, 200.0);
+  for (int i = 0; i < 200000; ++i) {
+    double v = dist(rng);
+    check(v, 6);
+    check(v, 8);
+    check(std::round(v * 1e6) / 1e6, 6);  // 坐标常见的截断值
+    check(v * 1e9, 8);
+  }
+
+  EXPECT_EQ(FormatInt(0, buf), 1);
+  EXPECT_STREQ(buf, "0");
+  FormatInt(std::numeric_limits<int64_t>::min(), buf);
+  EXPECT_STREQ(buf, "-9223372036854775808");
+}